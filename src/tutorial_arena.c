@@ -0,0 +1,261 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Per-file memory arena for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              Every open object needs a struct tutorial_object and copies
+ *              of its name and path. The arena carves objects out of large
+ *              blocks, reusing the memory of closed ones, and keeps one copy
+ *              of each distinct name and path in an interned string table,
+ *              so opening and closing an object usually doesn't touch
+ *              malloc() at all. Nothing is given back until the file and
+ *              all of its objects are closed, when it's all released at
+ *              once.
+ */
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tutorial_arena.h"
+#include "tutorial_internal.h"
+#include "tutorial_util.h"
+
+/* Size of the blocks that objects and strings are carved out of. Anything
+ * bigger than a quarter of this gets a block of its own.
+ */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/* Initial number of string table buckets (always a power of two) */
+#define ARENA_INIT_NBUCKETS 256
+
+struct arena_block {
+    struct arena_block *next;
+    size_t              size; /* Usable bytes */
+    size_t              used;
+    max_align_t         data[];
+};
+
+struct intern_entry {
+    /* The next entry in the same bucket */
+    struct intern_entry *next;
+
+    uint64_t hash;
+    size_t   len;
+    char     str[];
+};
+
+/* A closed object, waiting to be reused */
+struct free_object {
+    struct free_object *next;
+};
+
+struct tutorial_arena {
+    /* Guards everything, since objects can be opened and closed from
+     * several application threads
+     */
+    pthread_mutex_t lock;
+
+    /* The block being carved up comes first */
+    struct arena_block *blocks;
+
+    struct free_object *free_objects;
+
+    struct intern_entry **buckets;
+    size_t                nbuckets;
+    size_t                nentries;
+};
+
+/**********/
+/* BLOCKS */
+/**********/
+
+/* Carves size bytes, aligned to align, out of the current block */
+static void *
+arena_alloc(struct tutorial_arena *arena, size_t size, size_t align)
+{
+    struct arena_block *block = arena->blocks;
+    size_t              start = 0;
+
+    if (block)
+        start = (block->used + align - 1) & ~(align - 1);
+
+    if (NULL == block || start + size > block->size) {
+        hbool_t own_block  = size > ARENA_BLOCK_SIZE / 4;
+        size_t  block_size = own_block ? size : ARENA_BLOCK_SIZE;
+
+        if (NULL == (block = malloc(sizeof(struct arena_block) + block_size)))
+            return NULL;
+        block->size = block_size;
+        block->used = 0;
+
+        /* Big allocations go behind the current block, which may still have
+         * plenty of room
+         */
+        if (own_block && arena->blocks) {
+            block->next         = arena->blocks->next;
+            arena->blocks->next = block;
+            block->used         = size;
+            return block->data;
+        }
+
+        block->next   = arena->blocks;
+        arena->blocks = block;
+        start         = 0;
+    }
+
+    block->used = start + size;
+
+    return (char *)block->data + start;
+}
+
+/***********/
+/* STRINGS */
+/***********/
+
+static void
+grow_buckets(struct tutorial_arena *arena)
+{
+    size_t                nbuckets = arena->nbuckets * 2;
+    struct intern_entry **buckets  = NULL;
+
+    if (NULL == (buckets = calloc(nbuckets, sizeof(struct intern_entry *))))
+        return;
+
+    for (size_t i = 0; i < arena->nbuckets; i++)
+        while (arena->buckets[i]) {
+            struct intern_entry *e = arena->buckets[i];
+            size_t               b = (size_t)(e->hash & (nbuckets - 1));
+
+            arena->buckets[i] = e->next;
+            e->next           = buckets[b];
+            buckets[b]        = e;
+        }
+
+    free(arena->buckets);
+    arena->buckets  = buckets;
+    arena->nbuckets = nbuckets;
+}
+
+/* Returns the arena's copy of the first len characters of str (which lasts
+ * as long as the file), adding one if there isn't one yet. Returns NULL
+ * if out of memory.
+ */
+const char *
+arena_intern(struct tutorial_arena *arena, const char *str, size_t len)
+{
+    uint64_t             hash = hash_string(str, len);
+    struct intern_entry *e    = NULL;
+    size_t               b;
+
+    pthread_mutex_lock(&arena->lock);
+
+    for (e = arena->buckets[hash & (arena->nbuckets - 1)]; e; e = e->next)
+        if (e->hash == hash && e->len == len && memcmp(e->str, str, len) == 0)
+            goto done;
+
+    if (arena->nentries >= arena->nbuckets)
+        grow_buckets(arena);
+
+    if (NULL == (e = arena_alloc(arena, sizeof(struct intern_entry) + len + 1, alignof(struct intern_entry))))
+        goto done;
+    e->hash = hash;
+    e->len  = len;
+    memcpy(e->str, str, len);
+    e->str[len] = '\0';
+
+    b                 = (size_t)(hash & (arena->nbuckets - 1));
+    e->next           = arena->buckets[b];
+    arena->buckets[b] = e;
+    arena->nentries++;
+
+done:
+    pthread_mutex_unlock(&arena->lock);
+
+    return e ? e->str : NULL;
+}
+
+/***********/
+/* OBJECTS */
+/***********/
+
+/* Returns a zeroed object, or NULL if out of memory */
+struct tutorial_object *
+arena_alloc_object(struct tutorial_arena *arena)
+{
+    struct tutorial_object *obj = NULL;
+
+    pthread_mutex_lock(&arena->lock);
+
+    if (arena->free_objects) {
+        obj                 = (struct tutorial_object *)arena->free_objects;
+        arena->free_objects = arena->free_objects->next;
+    }
+    else
+        obj = arena_alloc(arena, sizeof(struct tutorial_object), alignof(struct tutorial_object));
+
+    pthread_mutex_unlock(&arena->lock);
+
+    if (obj)
+        memset(obj, 0, sizeof(struct tutorial_object));
+
+    return obj;
+}
+
+/* Keeps a closed object's memory for the next one */
+void
+arena_free_object(struct tutorial_arena *arena, struct tutorial_object *obj)
+{
+    struct free_object *f = (struct free_object *)obj;
+
+    pthread_mutex_lock(&arena->lock);
+
+    f->next             = arena->free_objects;
+    arena->free_objects = f;
+
+    pthread_mutex_unlock(&arena->lock);
+}
+
+/*********/
+/* ARENA */
+/*********/
+
+struct tutorial_arena *
+create_arena(void)
+{
+    struct tutorial_arena *arena = NULL;
+
+    arena           = calloc(1, sizeof(struct tutorial_arena));
+    arena->buckets  = calloc(ARENA_INIT_NBUCKETS, sizeof(struct intern_entry *));
+    arena->nbuckets = ARENA_INIT_NBUCKETS;
+    pthread_mutex_init(&arena->lock, NULL);
+
+    return arena;
+}
+
+/* Frees every object and string at once. Nothing allocated from the arena
+ * may be used afterwards.
+ */
+void
+free_arena(struct tutorial_arena *arena)
+{
+    if (NULL == arena)
+        return;
+
+    while (arena->blocks) {
+        struct arena_block *block = arena->blocks;
+
+        arena->blocks = block->next;
+        free(block);
+    }
+
+    pthread_mutex_destroy(&arena->lock);
+    free(arena->buckets);
+    free(arena);
+}
@@ -0,0 +1,25 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Per-file memory arena for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_ARENA_H
+#define TUTORIAL_ARENA_H
+
+#include <stddef.h>
+
+#include "tutorial_internal.h"
+
+struct tutorial_arena *create_arena(void);
+void                   free_arena(struct tutorial_arena *arena);
+
+struct tutorial_object *arena_alloc_object(struct tutorial_arena *arena);
+void                    arena_free_object(struct tutorial_arena *arena, struct tutorial_object *obj);
+
+const char *arena_intern(struct tutorial_arena *arena, const char *str, size_t len);
+
+#endif /* TUTORIAL_ARENA_H */
@@ -0,0 +1,1004 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Attribute functionality for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              All of an object's attributes live in one attribute record in
+ *              its directory, which is read whole (one read of one file,
+ *              however many attributes there are) the first time any of them
+ *              is needed and cached with the object's other metadata. Values
+ *              of up to ATTR_INLINE_MAX bytes are kept in the record itself,
+ *              so a query over many small attributes does no further I/O.
+ *              Larger values go in a blob file next to the record, which
+ *              keeps the record small. Any change writes a new record and
+ *              renames it over the old one.
+ *
+ *              Attributes may have any datatype without variable-length
+ *              parts. The type is kept as encoded by H5Tencode(), and values
+ *              are stored in it, so reads and writes in other types are
+ *              converted by the library.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <hdf5.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "tutorial_arena.h"
+#include "tutorial_cache.h"
+#include "tutorial_internal.h"
+#include "tutorial_request.h"
+#include "tutorial_util.h"
+
+#define ATTR_FILE_NAME "TUTORIAL_VOL_ATTRIBUTES"
+#define ATTR_BLOB_NAME ATTR_FILE_NAME ".blob"
+#define ATTR_TEMP_NAME ATTR_FILE_NAME ".tmp"
+#define ATTR_MAGIC     "TVAT"
+#define ATTR_VERSION   1
+
+/* Largest value kept in the attribute record */
+#define ATTR_INLINE_MAX 4096
+
+/* Where a value is */
+#define ATTR_UNWRITTEN 0
+#define ATTR_INLINE    1
+#define ATTR_BLOB      2
+
+#define PAD8(n) (((n) + 7) & ~(size_t)7)
+
+/* The attribute record: a header, then one record per attribute in creation
+ * order. Everything is in native byte order.
+ */
+struct attr_header {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  reserved[3];
+    uint32_t nattrs;
+    uint32_t next_corder;
+};
+
+/* Each attribute's record is followed by its dimensions (as uint64_t), its
+ * name (with the terminating null), its encoded type and, if it's inline,
+ * its value, all padded to a multiple of 8 bytes
+ */
+struct attr_record {
+    uint32_t size; /* Including what follows */
+    uint32_t corder;
+    uint16_t name_len;
+    uint8_t  space_class;
+    uint8_t  rank;
+    uint32_t type_size;
+    uint8_t  location; /* ATTR_UNWRITTEN, ATTR_INLINE or ATTR_BLOB */
+    uint8_t  reserved[7];
+    uint64_t data_size;
+    uint64_t blob_offset;
+};
+
+/* The object whose attributes an operation is on */
+struct attr_owner {
+    /* Its type and directory */
+    H5I_type_t type;
+    int        dir_fd;
+
+    /* Its path, which the attribute table is cached by */
+    const char *path;
+
+    /* Set if the directory and path were opened and made for the lookup */
+    hbool_t own_fd;
+    char *  path_buf;
+};
+
+/**********/
+/* TABLES */
+/**********/
+
+static int
+compare_attrs(const void *a, const void *b)
+{
+    const struct tutorial_attr_info *info_a = *(struct tutorial_attr_info *const *)a;
+    const struct tutorial_attr_info *info_b = *(struct tutorial_attr_info *const *)b;
+
+    return strcmp(info_a->name, info_b->name);
+}
+
+static hsize_t
+attr_nelmts(const struct tutorial_attr_info *info)
+{
+    hsize_t n = H5S_NULL == info->space_class ? 0 : 1;
+
+    for (int i = 0; i < info->rank; i++)
+        n *= info->dims[i];
+
+    return n;
+}
+
+void
+free_attrs(struct tutorial_attrs *attrs)
+{
+    free(attrs->attrs);
+    free(attrs->by_name);
+    free(attrs->buf);
+    free(attrs);
+}
+
+/* Makes a table of the attributes in a record (which is kept, and may be
+ * NULL for an object without any). Returns NULL if the record is damaged.
+ */
+static struct tutorial_attrs *
+parse_attrs(char *buf, size_t size)
+{
+    struct tutorial_attrs *attrs = NULL;
+    struct attr_header     hdr;
+    size_t                 off = sizeof(struct attr_header);
+
+    attrs      = calloc(1, sizeof(struct tutorial_attrs));
+    attrs->buf = buf;
+
+    if (0 == size)
+        return attrs;
+
+    memcpy(&hdr, buf, size < sizeof(hdr) ? size : sizeof(hdr));
+    if (size < sizeof(hdr) || memcmp(hdr.magic, ATTR_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != ATTR_VERSION)
+        goto error;
+
+    attrs->nattrs      = hdr.nattrs;
+    attrs->next_corder = hdr.next_corder;
+    attrs->attrs       = calloc(hdr.nattrs ? hdr.nattrs : 1, sizeof(struct tutorial_attr_info));
+    attrs->by_name     = malloc((hdr.nattrs ? hdr.nattrs : 1) * sizeof(struct tutorial_attr_info *));
+
+    for (size_t i = 0; i < attrs->nattrs; i++) {
+        struct tutorial_attr_info *info = &(attrs->attrs[i]);
+        struct attr_record         rec;
+        const char *               p   = NULL;
+        const char *               end = NULL;
+
+        if (off + sizeof(rec) > size)
+            goto error;
+        memcpy(&rec, buf + off, sizeof(rec));
+        if (rec.size < sizeof(rec) || off + rec.size > size || rec.rank > H5S_MAX_RANK)
+            goto error;
+
+        p   = buf + off + sizeof(rec);
+        end = buf + off + rec.size;
+
+        info->corder      = rec.corder;
+        info->space_class = (H5S_class_t)rec.space_class;
+        info->rank        = rec.rank;
+        memcpy(info->dims, p, rec.rank * sizeof(uint64_t));
+        p += rec.rank * sizeof(uint64_t);
+
+        info->name = p;
+        p += rec.name_len + 1;
+        info->type_buf  = p;
+        info->type_size = rec.type_size;
+        p += rec.type_size;
+
+        info->data_size   = rec.data_size;
+        info->in_blob     = (ATTR_BLOB == rec.location);
+        info->blob_offset = rec.blob_offset;
+        if (ATTR_INLINE == rec.location) {
+            info->value = p;
+            p += rec.data_size;
+        }
+
+        if (p > end || '\0' != info->name[rec.name_len])
+            goto error;
+
+        attrs->by_name[i] = info;
+        off += rec.size;
+    }
+
+    qsort(attrs->by_name, attrs->nattrs, sizeof(struct tutorial_attr_info *), compare_attrs);
+
+    return attrs;
+
+error:
+    free_attrs(attrs);
+    return NULL;
+}
+
+static size_t
+record_size(const struct tutorial_attr_info *info)
+{
+    return PAD8(sizeof(struct attr_record) + (size_t)info->rank * sizeof(uint64_t) + strlen(info->name) + 1 +
+                info->type_size + (info->value ? info->data_size : 0));
+}
+
+/* Writes a new attribute record, holding the given attributes, over an
+ * object's old one, and caches the new table
+ */
+static herr_t
+save_attrs(struct tutorial_file *file, const struct attr_owner *owner, const struct tutorial_attr_info *infos,
+           size_t n, uint32_t next_corder)
+{
+    struct tutorial_attrs *attrs = NULL;
+    struct attr_header     hdr;
+    char *                 buf  = NULL;
+    size_t                 size = sizeof(struct attr_header);
+    size_t                 off  = sizeof(struct attr_header);
+    herr_t                 ret  = 0;
+    int                    fd;
+
+    for (size_t i = 0; i < n; i++)
+        size += record_size(&infos[i]);
+
+    buf = calloc(1, size);
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, ATTR_MAGIC, sizeof(hdr.magic));
+    hdr.version     = ATTR_VERSION;
+    hdr.nattrs      = (uint32_t)n;
+    hdr.next_corder = next_corder;
+    memcpy(buf, &hdr, sizeof(hdr));
+
+    for (size_t i = 0; i < n; i++) {
+        const struct tutorial_attr_info *info = &infos[i];
+        struct attr_record               rec;
+        char *                           p = buf + off + sizeof(rec);
+
+        memset(&rec, 0, sizeof(rec));
+        rec.size        = (uint32_t)record_size(info);
+        rec.corder      = info->corder;
+        rec.name_len    = (uint16_t)strlen(info->name);
+        rec.space_class = (uint8_t)info->space_class;
+        rec.rank        = (uint8_t)info->rank;
+        rec.type_size   = (uint32_t)info->type_size;
+        rec.location    = info->in_blob ? ATTR_BLOB : info->value ? ATTR_INLINE : ATTR_UNWRITTEN;
+        rec.data_size   = info->data_size;
+        rec.blob_offset = info->blob_offset;
+        memcpy(buf + off, &rec, sizeof(rec));
+
+        memcpy(p, info->dims, (size_t)info->rank * sizeof(uint64_t));
+        p += (size_t)info->rank * sizeof(uint64_t);
+        memcpy(p, info->name, (size_t)rec.name_len + 1);
+        p += rec.name_len + 1;
+        memcpy(p, info->type_buf, info->type_size);
+        p += info->type_size;
+        if (info->value)
+            memcpy(p, info->value, info->data_size);
+
+        off += rec.size;
+    }
+
+    /* Replace the old record in one step, so it's never seen half written */
+    if ((fd = openat(owner->dir_fd, ATTR_TEMP_NAME, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) {
+        free(buf);
+        return -1;
+    }
+    if (write(fd, buf, size) != (ssize_t)size)
+        ret = -1;
+    if (close(fd) < 0 || ret < 0 ||
+        renameat(owner->dir_fd, ATTR_TEMP_NAME, owner->dir_fd, ATTR_FILE_NAME) < 0) {
+        unlinkat(owner->dir_fd, ATTR_TEMP_NAME, 0);
+        free(buf);
+        return -1;
+    }
+
+    if (NULL == (attrs = parse_attrs(buf, size)))
+        return -1;
+    attrs->refcount = 1;
+    cache_store_attrs(file->cache, owner->path, attrs);
+    cache_release_attrs(file->cache, attrs);
+
+    return 0;
+}
+
+/* Returns an object's attribute table, reading its attribute record if it
+ * isn't cached. Pass it to cache_release_attrs() when done.
+ */
+static struct tutorial_attrs *
+get_attrs(struct tutorial_file *file, int dir_fd, const char *path)
+{
+    struct tutorial_attrs *attrs = NULL;
+    struct stat            st;
+    char *                 buf  = NULL;
+    size_t                 size = 0;
+    int                    fd;
+
+    if (NULL != (attrs = cache_lookup_attrs(file->cache, path)))
+        return attrs;
+
+    /* An object without a record doesn't have any attributes */
+    if ((fd = openat(dir_fd, ATTR_FILE_NAME, O_RDONLY)) < 0) {
+        if (ENOENT != errno)
+            return NULL;
+    }
+    else {
+        if (fstat(fd, &st) < 0) {
+            close(fd);
+            return NULL;
+        }
+        size = (size_t)st.st_size;
+        buf  = malloc(size ? size : 1);
+        if (pread(fd, buf, size, 0) != (ssize_t)size) {
+            free(buf);
+            close(fd);
+            return NULL;
+        }
+        close(fd);
+    }
+
+    if (NULL == (attrs = parse_attrs(buf, size)))
+        return NULL;
+    attrs->refcount = 1;
+    cache_store_attrs(file->cache, path, attrs);
+
+    return attrs;
+}
+
+static struct tutorial_attr_info *
+find_attr(const struct tutorial_attrs *attrs, const char *name)
+{
+    struct tutorial_attr_info   key;
+    struct tutorial_attr_info * pkey = &key;
+    struct tutorial_attr_info **found;
+
+    if (0 == attrs->nattrs)
+        return NULL;
+
+    key.name = name;
+
+    found = bsearch(&pkey, attrs->by_name, attrs->nattrs, sizeof(struct tutorial_attr_info *), compare_attrs);
+
+    return found ? *found : NULL;
+}
+
+/* The nth attribute in the given index and order, or NULL if there aren't
+ * that many
+ */
+static struct tutorial_attr_info *
+attr_by_idx(const struct tutorial_attrs *attrs, H5_index_t idx_type, H5_iter_order_t order, hsize_t n)
+{
+    if (n >= attrs->nattrs)
+        return NULL;
+    if (H5_ITER_DEC == order)
+        n = attrs->nattrs - 1 - n;
+
+    return H5_INDEX_CRT_ORDER == idx_type ? &(attrs->attrs[n]) : attrs->by_name[n];
+}
+
+static void
+get_attr_info(const struct tutorial_attr_info *info, H5A_info_t *ainfo)
+{
+    memset(ainfo, 0, sizeof(H5A_info_t));
+
+    ainfo->corder_valid = true;
+    ainfo->corder       = (H5O_msg_crt_idx_t)info->corder;
+    ainfo->cset         = H5T_CSET_ASCII;
+    ainfo->data_size    = info->data_size;
+}
+
+/**********/
+/* VALUES */
+/**********/
+
+/* Reads a stored value (data_size bytes). Values that were never written
+ * read as zeros, like the library's default fill value.
+ */
+static herr_t
+read_value(int dir_fd, const struct tutorial_attr_info *info, void *buf)
+{
+    herr_t ret = 0;
+    int    fd;
+
+    if (info->value)
+        memcpy(buf, info->value, info->data_size);
+    else if (!info->in_blob)
+        memset(buf, 0, info->data_size);
+    else {
+        if ((fd = openat(dir_fd, ATTR_BLOB_NAME, O_RDONLY)) < 0)
+            return -1;
+        if (pread(fd, buf, info->data_size, (off_t)info->blob_offset) != (ssize_t)info->data_size)
+            ret = -1;
+        close(fd);
+    }
+
+    return ret;
+}
+
+/* Appends a large value to the blob file. The space of the value it replaces
+ * isn't reused.
+ */
+static herr_t
+append_blob(int dir_fd, const void *buf, hsize_t size, uint64_t *offset)
+{
+    off_t  end;
+    herr_t ret = 0;
+    int    fd;
+
+    if ((fd = openat(dir_fd, ATTR_BLOB_NAME, O_RDWR | O_CREAT, 0666)) < 0)
+        return -1;
+
+    if ((end = lseek(fd, 0, SEEK_END)) < 0 || pwrite(fd, buf, size, end) != (ssize_t)size)
+        ret = -1;
+    *offset = (uint64_t)end;
+
+    close(fd);
+
+    return ret;
+}
+
+/**********/
+/* OWNERS */
+/**********/
+
+/* Looks up the object whose attributes an operation is on: the location
+ * itself, or the object named relative to it
+ */
+static herr_t
+find_owner(void *obj, const H5VL_loc_params_t *loc_params, struct attr_owner *owner)
+{
+    struct tutorial_object *parent = loc_group(obj, loc_params);
+    const char *            name   = NULL;
+
+    memset(owner, 0, sizeof(struct attr_owner));
+    owner->dir_fd = -1;
+
+    /* The object may still be being created */
+    wait_for_tasks(parent->file);
+
+    switch (loc_params->type) {
+        case H5VL_OBJECT_BY_SELF:
+            name = ".";
+            break;
+        case H5VL_OBJECT_BY_NAME:
+            name = loc_params->loc_data.loc_by_name.name;
+            break;
+        case H5VL_OBJECT_BY_IDX:
+            name = loc_params->loc_data.loc_by_idx.name;
+            break;
+        case H5VL_OBJECT_BY_TOKEN:
+        default:
+            return -1;
+    }
+
+    parent = resolve_name(parent, &name);
+
+    if (0 == strcmp(name, ".")) {
+        owner->type = parent->type;
+        owner->path = parent->path;
+        if (H5I_GROUP == parent->type)
+            owner->dir_fd = group_fd(parent);
+        else if (H5I_DATASET == parent->type)
+            owner->dir_fd = parent->data.dataset.dir_fd;
+
+        return owner->dir_fd >= 0 ? 0 : -1;
+    }
+
+    /* Only groups have members */
+    if (H5I_GROUP != parent->type)
+        return -1;
+
+    if ((owner->dir_fd = openat(group_fd(parent), name, O_RDONLY | O_DIRECTORY)) < 0)
+        return -1;
+    owner->own_fd   = true;
+    owner->type     = is_dataset_dir(group_fd(parent), name) ? H5I_DATASET : H5I_GROUP;
+    owner->path_buf = make_path(parent->path, name, NULL);
+    owner->path     = owner->path_buf;
+
+    return 0;
+}
+
+static void
+release_owner(struct attr_owner *owner)
+{
+    if (owner->own_fd)
+        close(owner->dir_fd);
+    free(owner->path_buf);
+}
+
+/* Registers an ID for a new handle on an object, for an iteration callback
+ * to use like any other
+ */
+static hid_t
+register_owner(struct tutorial_file *file, const struct attr_owner *owner)
+{
+    struct tutorial_object *obj  = NULL;
+    const char *            name = owner->path + strlen(file->root->path);
+    H5VL_loc_params_t       loc_params;
+    hid_t                   id;
+
+    name = ('/' == *name) ? name + 1 : ".";
+
+    if (H5I_GROUP == owner->type)
+        obj = open_group(file->root, name);
+    else {
+        loc_params.type     = H5VL_OBJECT_BY_SELF;
+        loc_params.obj_type = H5I_GROUP;
+
+        obj = tutorial_dataset_open(file->root, &loc_params, name, H5P_DEFAULT, H5P_DEFAULT, NULL);
+    }
+    if (NULL == obj)
+        return H5I_INVALID_HID;
+
+    if ((id = H5VLwrap_register(obj, owner->type)) < 0) {
+        if (H5I_GROUP == owner->type)
+            tutorial_group_close(obj, H5P_DEFAULT, NULL);
+        else
+            tutorial_dataset_close(obj, H5P_DEFAULT, NULL);
+    }
+
+    return id;
+}
+
+/**************/
+/* ATTRIBUTES */
+/**************/
+
+/* Opens the attribute described by info, which belongs to owner */
+static struct tutorial_object *
+make_attr(struct tutorial_file *file, const struct attr_owner *owner, const struct tutorial_attr_info *info)
+{
+    struct tutorial_object *   obj  = NULL;
+    struct tutorial_attribute *attr = NULL;
+
+    obj  = make_object(file, H5I_ATTR, owner->path, info->name);
+    attr = &(obj->data.attr);
+
+    attr->owner_path = arena_intern(file->arena, owner->path, strlen(owner->path));
+    attr->dir_fd     = dup(owner->dir_fd);
+    attr->type_id    = H5Tdecode(info->type_buf);
+
+    if (H5S_SIMPLE == info->space_class)
+        attr->space_id = H5Screate_simple(info->rank, info->dims, NULL);
+    else
+        attr->space_id = H5Screate(info->space_class);
+
+    if (attr->dir_fd < 0 || attr->type_id < 0 || attr->space_id < 0) {
+        tutorial_attr_close(obj, H5P_DEFAULT, NULL);
+        return NULL;
+    }
+
+    return obj;
+}
+
+/* Looks up the attribute that an open attribute is for */
+static struct tutorial_attr_info *
+lookup_attr(struct tutorial_object *obj, struct tutorial_attrs **attrs)
+{
+    struct tutorial_attribute *attr = &(obj->data.attr);
+
+    if (NULL == (*attrs = get_attrs(obj->file, attr->dir_fd, attr->owner_path)))
+        return NULL;
+
+    return find_attr(*attrs, obj->name);
+}
+
+/* Saves an object's attributes with old_info replaced by new_info, new_info
+ * added (if old_info is NULL) or old_info removed (if new_info is NULL)
+ */
+static herr_t
+change_attr(struct tutorial_file *file, const struct attr_owner *owner, const struct tutorial_attrs *attrs,
+            const struct tutorial_attr_info *old_info, const struct tutorial_attr_info *new_info)
+{
+    struct tutorial_attr_info *infos = NULL;
+    size_t                     n     = 0;
+    uint32_t                   next  = attrs->next_corder;
+    herr_t                     ret;
+
+    infos = malloc((attrs->nattrs + 1) * sizeof(struct tutorial_attr_info));
+
+    for (size_t i = 0; i < attrs->nattrs; i++) {
+        if (&(attrs->attrs[i]) != old_info)
+            infos[n++] = attrs->attrs[i];
+        else if (new_info)
+            infos[n++] = *new_info;
+    }
+    if (NULL == old_info) {
+        infos[n]        = *new_info;
+        infos[n].corder = next++;
+        n++;
+    }
+
+    ret = save_attrs(file, owner, infos, n, next);
+
+    free(infos);
+
+    return ret;
+}
+
+/*************/
+/* CALLBACKS */
+/*************/
+
+void *
+tutorial_attr_create(void *obj, const H5VL_loc_params_t *loc_params, const char *attr_name, hid_t type_id,
+                     hid_t space_id, hid_t acpl_id, hid_t aapl_id, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *  parent    = loc_group(obj, loc_params);
+    struct tutorial_object *  new_obj   = NULL;
+    struct tutorial_attrs *   attrs     = NULL;
+    struct tutorial_attr_info info;
+    struct attr_owner         owner;
+    unsigned char *           type_buf  = NULL;
+    size_t                    type_size = 0;
+    int                       rank;
+
+    /* Values are stored as they are, so they can't point elsewhere */
+    if (H5Tdetect_class(type_id, H5T_VLEN) > 0 || H5Tis_variable_str(type_id) > 0)
+        return NULL;
+
+    memset(&info, 0, sizeof(info));
+    info.name        = attr_name;
+    info.space_class = H5Sget_simple_extent_type(space_id);
+    if ((rank = H5Sget_simple_extent_dims(space_id, info.dims, NULL)) < 0)
+        return NULL;
+    info.rank      = rank;
+    info.data_size = attr_nelmts(&info) * H5Tget_size(type_id);
+
+    if (H5Tencode(type_id, NULL, &type_size) < 0 || NULL == (type_buf = malloc(type_size)) ||
+        H5Tencode(type_id, type_buf, &type_size) < 0) {
+        free(type_buf);
+        return NULL;
+    }
+    info.type_buf  = type_buf;
+    info.type_size = type_size;
+
+    if (find_owner(obj, loc_params, &owner) < 0) {
+        release_owner(&owner);
+        free(type_buf);
+        return NULL;
+    }
+
+    /* Add the attribute (unwritten) to the record */
+    if (NULL != (attrs = get_attrs(parent->file, owner.dir_fd, owner.path)) &&
+        NULL == find_attr(attrs, attr_name) && change_attr(parent->file, &owner, attrs, NULL, &info) >= 0)
+        new_obj = make_attr(parent->file, &owner, &info);
+
+    if (attrs)
+        cache_release_attrs(parent->file->cache, attrs);
+    release_owner(&owner);
+    free(type_buf);
+
+    return new_obj;
+}
+
+void *
+tutorial_attr_open(void *obj, const H5VL_loc_params_t *loc_params, const char *attr_name, hid_t aapl_id,
+                   hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *   parent  = loc_group(obj, loc_params);
+    struct tutorial_object *   new_obj = NULL;
+    struct tutorial_attrs *    attrs   = NULL;
+    struct tutorial_attr_info *info    = NULL;
+    struct attr_owner          owner;
+
+    if (find_owner(obj, loc_params, &owner) < 0) {
+        release_owner(&owner);
+        return NULL;
+    }
+
+    if (NULL != (attrs = get_attrs(parent->file, owner.dir_fd, owner.path))) {
+        if (H5VL_OBJECT_BY_IDX == loc_params->type)
+            info = attr_by_idx(attrs, loc_params->loc_data.loc_by_idx.idx_type,
+                               loc_params->loc_data.loc_by_idx.order, loc_params->loc_data.loc_by_idx.n);
+        else
+            info = find_attr(attrs, attr_name);
+
+        if (info)
+            new_obj = make_attr(parent->file, &owner, info);
+
+        cache_release_attrs(parent->file->cache, attrs);
+    }
+
+    release_owner(&owner);
+
+    return new_obj;
+}
+
+herr_t
+tutorial_attr_read(void *_obj, hid_t mem_type_id, void *buf, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *   obj   = (struct tutorial_object *)_obj;
+    struct tutorial_attribute *attr  = &(obj->data.attr);
+    struct tutorial_attrs *    attrs = NULL;
+    struct tutorial_attr_info *info  = NULL;
+    void *                     tmp   = NULL;
+    size_t                     mem_size;
+    hsize_t                    n;
+    herr_t                     ret = 0;
+
+    if (NULL == (info = lookup_attr(obj, &attrs))) {
+        if (attrs)
+            cache_release_attrs(obj->file->cache, attrs);
+        return -1;
+    }
+
+    n        = attr_nelmts(info);
+    mem_size = H5Tget_size(mem_type_id);
+
+    /* Read straight into the buffer if there's nothing to convert */
+    if (H5Tequal(mem_type_id, attr->type_id) > 0)
+        ret = read_value(attr->dir_fd, info, buf);
+    else {
+        tmp = malloc(n * (mem_size > H5Tget_size(attr->type_id) ? mem_size : H5Tget_size(attr->type_id)) + 1);
+
+        if (read_value(attr->dir_fd, info, tmp) < 0 ||
+            (n > 0 && H5Tconvert(attr->type_id, mem_type_id, n, tmp, NULL, H5P_DEFAULT) < 0))
+            ret = -1;
+        else
+            memcpy(buf, tmp, n * mem_size);
+
+        free(tmp);
+    }
+
+    cache_release_attrs(obj->file->cache, attrs);
+
+    return ret;
+}
+
+herr_t
+tutorial_attr_write(void *_obj, hid_t mem_type_id, const void *buf, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *   obj   = (struct tutorial_object *)_obj;
+    struct tutorial_attribute *attr  = &(obj->data.attr);
+    struct tutorial_attrs *    attrs = NULL;
+    struct tutorial_attr_info *info  = NULL;
+    struct tutorial_attr_info  new_info;
+    struct attr_owner          owner;
+    void *                     tmp = NULL;
+    size_t                     mem_size;
+    hsize_t                    n;
+    herr_t                     ret = 0;
+
+    if (NULL == (info = lookup_attr(obj, &attrs))) {
+        if (attrs)
+            cache_release_attrs(obj->file->cache, attrs);
+        return -1;
+    }
+
+    n        = attr_nelmts(info);
+    mem_size = H5Tget_size(mem_type_id);
+
+    /* Convert the value to the stored type */
+    tmp = malloc(n * (mem_size > H5Tget_size(attr->type_id) ? mem_size : H5Tget_size(attr->type_id)) + 1);
+    memcpy(tmp, buf, n * mem_size);
+    if (n > 0 && H5Tequal(mem_type_id, attr->type_id) <= 0 &&
+        H5Tconvert(mem_type_id, attr->type_id, n, tmp, NULL, H5P_DEFAULT) < 0) {
+        ret = -1;
+        goto done;
+    }
+
+    /* Small values go in the record and large ones in the blob file */
+    new_info = *info;
+    if (info->data_size <= ATTR_INLINE_MAX) {
+        new_info.value   = tmp;
+        new_info.in_blob = false;
+    }
+    else {
+        new_info.value   = NULL;
+        new_info.in_blob = true;
+        if (append_blob(attr->dir_fd, tmp, info->data_size, &(new_info.blob_offset)) < 0) {
+            ret = -1;
+            goto done;
+        }
+    }
+
+    memset(&owner, 0, sizeof(owner));
+    owner.dir_fd = attr->dir_fd;
+    owner.path   = attr->owner_path;
+
+    ret = change_attr(obj->file, &owner, attrs, info, &new_info);
+
+done:
+    cache_release_attrs(obj->file->cache, attrs);
+    free(tmp);
+
+    return ret;
+}
+
+herr_t
+tutorial_attr_get(void *obj, H5VL_attr_get_args_t *args, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *   attr_obj = (struct tutorial_object *)obj;
+    struct tutorial_attrs *    attrs    = NULL;
+    struct tutorial_attr_info *info     = NULL;
+    struct attr_owner          owner;
+    herr_t                     ret = 0;
+
+    switch (args->op_type) {
+        case H5VL_ATTR_GET_ACPL: {
+            /* Attributes don't have any creation properties of their own */
+            if ((args->args.get_acpl.acpl_id = H5Pcreate(H5P_ATTRIBUTE_CREATE)) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_ATTR_GET_SPACE: {
+            if ((args->args.get_space.space_id = H5Scopy(attr_obj->data.attr.space_id)) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_ATTR_GET_TYPE: {
+            if ((args->args.get_type.type_id = H5Tcopy(attr_obj->data.attr.type_id)) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_ATTR_GET_STORAGE_SIZE: {
+            if (NULL == (info = lookup_attr(attr_obj, &attrs)))
+                ret = -1;
+            else
+                *args->args.get_storage_size.data_size = info->data_size;
+
+            if (attrs)
+                cache_release_attrs(attr_obj->file->cache, attrs);
+            break;
+        }
+        case H5VL_ATTR_GET_INFO:
+        case H5VL_ATTR_GET_NAME: {
+            const H5VL_loc_params_t *loc_params = H5VL_ATTR_GET_INFO == args->op_type
+                                                      ? &(args->args.get_info.loc_params)
+                                                      : &(args->args.get_name.loc_params);
+            struct tutorial_file *   file       = NULL;
+
+            /* An open attribute, or one looked up on its object */
+            if (H5VL_OBJECT_BY_SELF == loc_params->type) {
+                file = attr_obj->file;
+                info = lookup_attr(attr_obj, &attrs);
+            }
+            else {
+                file = loc_group(obj, loc_params)->file;
+                if (find_owner(obj, loc_params, &owner) < 0) {
+                    release_owner(&owner);
+                    return -1;
+                }
+
+                if (NULL != (attrs = get_attrs(file, owner.dir_fd, owner.path))) {
+                    if (H5VL_OBJECT_BY_IDX == loc_params->type)
+                        info = attr_by_idx(attrs, loc_params->loc_data.loc_by_idx.idx_type,
+                                           loc_params->loc_data.loc_by_idx.order,
+                                           loc_params->loc_data.loc_by_idx.n);
+                    else if (H5VL_ATTR_GET_INFO == args->op_type)
+                        info = find_attr(attrs, args->args.get_info.attr_name);
+                }
+
+                release_owner(&owner);
+            }
+
+            if (NULL == info)
+                ret = -1;
+            else if (H5VL_ATTR_GET_INFO == args->op_type)
+                get_attr_info(info, args->args.get_info.ainfo);
+            else {
+                H5VL_attr_get_name_args_t *get_name = &(args->args.get_name);
+                size_t                     len      = strlen(info->name);
+
+                *get_name->attr_name_len = len;
+
+                /* The name may be truncated to fit */
+                if (get_name->buf && get_name->buf_size > 0) {
+                    if (len >= get_name->buf_size)
+                        len = get_name->buf_size - 1;
+                    memcpy(get_name->buf, info->name, len);
+                    get_name->buf[len] = '\0';
+                }
+            }
+
+            if (attrs)
+                cache_release_attrs(file->cache, attrs);
+            break;
+        }
+        default:
+            return -1;
+    }
+
+    return ret;
+}
+
+herr_t
+tutorial_attr_specific(void *obj, const H5VL_loc_params_t *loc_params, H5VL_attr_specific_args_t *args,
+                       hid_t dxpl_id, void **req)
+{
+    struct tutorial_file *     file  = loc_group(obj, loc_params)->file;
+    struct tutorial_attrs *    attrs = NULL;
+    struct tutorial_attr_info *info  = NULL;
+    struct attr_owner          owner;
+    herr_t                     ret = 0;
+
+    if (find_owner(obj, loc_params, &owner) < 0 ||
+        NULL == (attrs = get_attrs(file, owner.dir_fd, owner.path))) {
+        release_owner(&owner);
+        return -1;
+    }
+
+    switch (args->op_type) {
+        case H5VL_ATTR_DELETE:
+        case H5VL_ATTR_DELETE_BY_IDX: {
+            if (H5VL_ATTR_DELETE == args->op_type)
+                info = find_attr(attrs, args->args.del.name);
+            else
+                info = attr_by_idx(attrs, args->args.delete_by_idx.idx_type, args->args.delete_by_idx.order,
+                                   args->args.delete_by_idx.n);
+
+            if (NULL == info || change_attr(file, &owner, attrs, info, NULL) < 0)
+                ret = -1;
+            break;
+        }
+        case H5VL_ATTR_EXISTS: {
+            *args->args.exists.exists = (NULL != find_attr(attrs, args->args.exists.name));
+            break;
+        }
+        case H5VL_ATTR_ITER: {
+            H5VL_attr_iterate_args_t *iterate = &(args->args.iterate);
+            hsize_t                   idx     = iterate->idx ? *iterate->idx : 0;
+            hid_t                     loc_id;
+            H5A_info_t                ainfo;
+
+            /* Starting past the end is an error, unless there's nothing to
+             * skip
+             */
+            if (idx > 0 && idx >= attrs->nattrs) {
+                ret = -1;
+                break;
+            }
+
+            /* The callback gets an ID for the object, for a new handle so
+             * closing it doesn't close the one the iteration was started from
+             */
+            if ((loc_id = register_owner(file, &owner)) < 0) {
+                ret = -1;
+                break;
+            }
+
+            for (; 0 == ret && idx < attrs->nattrs; idx++) {
+                info = attr_by_idx(attrs, iterate->idx_type, iterate->order, idx);
+                get_attr_info(info, &ainfo);
+                ret = iterate->op(loc_id, info->name, &ainfo, iterate->op_data);
+            }
+
+            if (iterate->idx)
+                *iterate->idx = idx;
+
+            H5Oclose(loc_id);
+            break;
+        }
+        case H5VL_ATTR_RENAME: {
+            struct tutorial_attr_info new_info;
+
+            if (NULL == (info = find_attr(attrs, args->args.rename.old_name)) ||
+                NULL != find_attr(attrs, args->args.rename.new_name)) {
+                ret = -1;
+                break;
+            }
+
+            new_info      = *info;
+            new_info.name = args->args.rename.new_name;
+            ret           = change_attr(file, &owner, attrs, info, &new_info);
+            break;
+        }
+        default:
+            ret = -1;
+            break;
+    }
+
+    cache_release_attrs(file->cache, attrs);
+    release_owner(&owner);
+
+    return ret;
+}
+
+herr_t
+tutorial_attr_close(void *_obj, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *   obj  = (struct tutorial_object *)_obj;
+    struct tutorial_attribute *attr = &(obj->data.attr);
+
+    if (attr->type_id >= 0)
+        H5Tclose(attr->type_id);
+    if (attr->space_id >= 0)
+        H5Sclose(attr->space_id);
+    if (attr->dir_fd >= 0)
+        close(attr->dir_fd);
+
+    /* Destroy the object */
+    destroy_object(&obj);
+
+    return 0;
+}
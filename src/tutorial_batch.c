@@ -0,0 +1,266 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Batched object creation for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              In a file opened with TUTORIAL_VOL_BATCH_CREATE_PROP, the
+ *              on-disk part of creating a group or dataset is held back in
+ *              the file's batch instead of running straight away, along
+ *              with any writes to the new datasets and their closes. The
+ *              batch is flushed the first time anything needs to see the
+ *              disk (anything that waits for the file's tasks), on
+ *              H5Fflush() and when the file is closed. Groups are made
+ *              first, in order, and then the datasets are made (and
+ *              written) in parallel on the file's thread pool, so a file
+ *              being filled with many small datasets isn't held up by the
+ *              latency of each one's system calls in turn.
+ */
+
+#include <hdf5.h>
+#include <stdlib.h>
+
+#include "tutorial_batch.h"
+#include "tutorial_internal.h"
+#include "tutorial_journal.h"
+#include "tutorial_pool.h"
+#include "tutorial_request.h"
+#include "tutorial_writeback.h"
+
+/* More parts than threads, so a few slow datasets don't hold one up */
+#define BATCH_PARTS_PER_THREAD 4
+
+/* A task held back for an object */
+struct batch_task {
+    struct batch_task *  next;
+    tutorial_task_t      func;
+    tutorial_task_free_t free_func;
+    void *               task_data;
+};
+
+/* An object whose creation is held back, and the tasks for it that came
+ * after (in order)
+ */
+struct tutorial_batch_entry {
+    struct tutorial_batch_entry *next;
+    struct tutorial_object *     obj;
+    struct batch_task *          head;
+    struct batch_task *          tail;
+
+    /* Set when the object is closed before the batch is flushed */
+    tutorial_close_t close_func;
+
+    herr_t ret;
+};
+
+/* The objects waiting in a file's batch, in the order they were created */
+struct tutorial_batch {
+    struct tutorial_batch_entry *head;
+    struct tutorial_batch_entry *tail;
+    size_t                       nentries;
+};
+
+/* The datasets of a batch, split between the parts of a job */
+struct batch_job {
+    struct tutorial_batch_entry **entries;
+    size_t                        nentries;
+    size_t                        nparts;
+};
+
+static void
+add_task(struct tutorial_batch_entry *entry, tutorial_task_t func, tutorial_task_free_t free_func,
+         void *task_data)
+{
+    struct batch_task *task = NULL;
+
+    task            = calloc(1, sizeof(struct batch_task));
+    task->func      = func;
+    task->free_func = free_func;
+    task->task_data = task_data;
+
+    if (entry->tail)
+        entry->tail->next = task;
+    else
+        entry->head = task;
+    entry->tail = task;
+}
+
+/* Runs an object's tasks in order, stopping at the first that fails. The
+ * task data is released either way.
+ */
+static void
+run_entry(struct tutorial_batch_entry *entry)
+{
+    struct batch_task *task = NULL;
+
+    while (NULL != (task = entry->head)) {
+        entry->head = task->next;
+
+        if (entry->ret >= 0 && task->func(task->task_data) < 0)
+            entry->ret = -1;
+        if (task->free_func)
+            task->free_func(task->task_data);
+        free(task);
+    }
+    entry->tail = NULL;
+}
+
+static herr_t
+entries_part(size_t part, void *job_data)
+{
+    struct batch_job *job  = (struct batch_job *)job_data;
+    size_t            from = job->nentries * part / job->nparts;
+    size_t            to   = job->nentries * (part + 1) / job->nparts;
+
+    for (size_t i = from; i < to; i++)
+        run_entry(job->entries[i]);
+
+    return 0;
+}
+
+/* Holds back the task that creates obj on disk, if its file batches
+ * creations. Returns false (having done nothing) if it doesn't, in which
+ * case the task should be submitted as usual.
+ */
+hbool_t
+batch_create(struct tutorial_object *obj, tutorial_task_t func, tutorial_task_free_t free_func,
+             void *task_data)
+{
+    struct tutorial_file *       f     = obj->file;
+    struct tutorial_batch_entry *entry = NULL;
+
+    if (!f->batch_create)
+        return false;
+
+    if (NULL == f->batch)
+        f->batch = calloc(1, sizeof(struct tutorial_batch));
+
+    entry      = calloc(1, sizeof(struct tutorial_batch_entry));
+    entry->obj = obj;
+    add_task(entry, func, free_func, task_data);
+
+    if (f->batch->tail)
+        f->batch->tail->next = entry;
+    else
+        f->batch->head = entry;
+    f->batch->tail = entry;
+    f->batch->nentries++;
+
+    obj->batched = entry;
+
+    return true;
+}
+
+/* Whether obj's creation is still held back in its file's batch */
+hbool_t
+is_batched(const struct tutorial_object *obj)
+{
+    return NULL != obj->batched;
+}
+
+/* Holds back a task for an object whose creation is held back, to run
+ * after it. Returns false (having done nothing) if the object has already
+ * been created.
+ */
+hbool_t
+batch_task(struct tutorial_object *obj, tutorial_task_t func, tutorial_task_free_t free_func, void *task_data)
+{
+    if (NULL == obj->batched)
+        return false;
+
+    add_task(obj->batched, func, free_func, task_data);
+
+    return true;
+}
+
+/* Puts off closing an object whose creation is held back until the batch
+ * has been flushed, when close_func is called for it. Returns false if the
+ * object has already been created, and should be closed now.
+ */
+hbool_t
+batch_close(struct tutorial_object *obj, tutorial_close_t close_func)
+{
+    if (NULL == obj->batched)
+        return false;
+
+    obj->batched->close_func = close_func;
+
+    return true;
+}
+
+/* Runs everything held back in f's batch. The tasks queued for the file's
+ * background thread must have finished, since they came first. Failures
+ * are remembered, and with report set, -1 is returned if anything that has
+ * been batched since the last report failed.
+ */
+herr_t
+flush_batch(struct tutorial_file *f, hbool_t report)
+{
+    struct tutorial_batch *       batch  = f->batch;
+    struct tutorial_batch_entry * entry  = NULL;
+    struct tutorial_batch_entry **dsets  = NULL;
+    size_t                        ndsets = 0;
+    herr_t                        ret    = 0;
+    struct batch_job              job;
+
+    if (batch) {
+        /* Take the batch, so flushing again (as closing an object does)
+         * finds nothing to do
+         */
+        f->batch = NULL;
+
+        /* Groups are made first and in order, so every dataset's group (and
+         * every group's parent) is there before it's needed
+         */
+        dsets = malloc(batch->nentries * sizeof(struct tutorial_batch_entry *));
+        for (entry = batch->head; entry; entry = entry->next)
+            if (H5I_GROUP == entry->obj->type)
+                run_entry(entry);
+            else
+                dsets[ndsets++] = entry;
+
+        /* Datasets don't depend on each other. Their writes skip the write
+         * buffer and the journal, which aren't safe to use from the pool, so
+         * the journal is emptied once here in case anything in it could be
+         * replayed over them.
+         */
+        if (ndsets > 0) {
+            if (f->journal && (drain_write_buffer(f, NULL, false) < 0 || checkpoint_journal(f, true) < 0))
+                f->batch_failed = true;
+
+            job.entries  = dsets;
+            job.nentries = ndsets;
+            job.nparts   = pool_threads(f) * BATCH_PARTS_PER_THREAD;
+            if (job.nparts > ndsets)
+                job.nparts = ndsets;
+
+            run_parallel(f, job.nparts, entries_part, &job);
+        }
+
+        /* Close what was closed while it was waiting */
+        while (NULL != (entry = batch->head)) {
+            batch->head = entry->next;
+
+            if (entry->ret < 0)
+                f->batch_failed = true;
+
+            entry->obj->batched = NULL;
+            if (entry->close_func)
+                entry->close_func(entry->obj, H5P_DEFAULT, NULL);
+
+            free(entry);
+        }
+
+        free(dsets);
+        free(batch);
+    }
+
+    if (report && f->batch_failed) {
+        f->batch_failed = false;
+        ret             = -1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,29 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Batched object creation for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_BATCH_H
+#define TUTORIAL_BATCH_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+#include "tutorial_request.h"
+
+/* Closes an object (one of the close callbacks) */
+typedef herr_t (*tutorial_close_t)(void *obj, hid_t dxpl_id, void **req);
+
+hbool_t batch_create(struct tutorial_object *obj, tutorial_task_t func, tutorial_task_free_t free_func,
+                     void *task_data);
+hbool_t is_batched(const struct tutorial_object *obj);
+hbool_t batch_task(struct tutorial_object *obj, tutorial_task_t func, tutorial_task_free_t free_func,
+                   void *task_data);
+hbool_t batch_close(struct tutorial_object *obj, tutorial_close_t close_func);
+herr_t  flush_batch(struct tutorial_file *f, hbool_t report);
+
+#endif /* TUTORIAL_BATCH_H */
@@ -0,0 +1,584 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Per-file metadata cache for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              Opening a dataset parses several small metadata files, and
+ *              opening a group opens its directory. The cache remembers, by
+ *              object path, the parsed metadata of every dataset seen so far
+ *              in a file, so reopening one doesn't read those files again.
+ *              The handles of closed objects are kept too (up to
+ *              CACHE_MAX_IDLE of them) and handed to the next open. Anything
+ *              that rewrites an object's metadata stores the new version.
+ *
+ *              Groups' sorted member listings are kept as well, and dropped
+ *              whenever something is created in or deleted from the group.
+ *              So are objects' attribute tables, which are replaced whenever
+ *              an attribute changes.
+ */
+
+#include <dirent.h>
+#include <hdf5.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tutorial_cache.h"
+#include "tutorial_internal.h"
+#include "tutorial_util.h"
+
+/* Number of closed objects whose handles are kept open */
+#define CACHE_MAX_IDLE 128
+
+/* Initial number of hash buckets (always a power of two) */
+#define CACHE_INIT_NBUCKETS 64
+
+struct cache_entry {
+    /* The next entry in the same bucket */
+    struct cache_entry *next;
+
+    /* The object's path, as in struct tutorial_object */
+    char *   path;
+    uint64_t hash;
+
+    /* The dataset's metadata (the handle and mapping fields are unused) */
+    hbool_t                 has_dataset;
+    struct tutorial_dataset dataset;
+
+    /* The group's members (NULL until someone asks for them) */
+    struct tutorial_listing *listing;
+
+    /* The object's attributes (NULL until someone asks for them) */
+    struct tutorial_attrs *attrs;
+
+    /* Handles left open by the last object closed, and the entry's place in
+     * the list of entries that have some, most recently closed first
+     */
+    int                 dir_fd;
+    FILE *              data_file;
+    FILE *              space_file;
+    DIR *               dir;
+    hbool_t             idle;
+    struct cache_entry *idle_prev;
+    struct cache_entry *idle_next;
+};
+
+struct tutorial_cache {
+    /* Guards everything, since datasets can be created on the file's
+     * background thread
+     */
+    pthread_mutex_t lock;
+
+    struct cache_entry **buckets;
+    size_t               nbuckets;
+    size_t               nentries;
+
+    struct cache_entry *idle_head;
+    struct cache_entry *idle_tail;
+    size_t              nidle;
+};
+
+/***********/
+/* ENTRIES */
+/***********/
+
+static void
+grow_buckets(struct tutorial_cache *cache)
+{
+    size_t               nbuckets = cache->nbuckets * 2;
+    struct cache_entry **buckets  = NULL;
+
+    if (NULL == (buckets = calloc(nbuckets, sizeof(struct cache_entry *))))
+        return;
+
+    for (size_t i = 0; i < cache->nbuckets; i++)
+        while (cache->buckets[i]) {
+            struct cache_entry *e = cache->buckets[i];
+            size_t              b = (size_t)(e->hash & (nbuckets - 1));
+
+            cache->buckets[i] = e->next;
+            e->next           = buckets[b];
+            buckets[b]        = e;
+        }
+
+    free(cache->buckets);
+    cache->buckets  = buckets;
+    cache->nbuckets = nbuckets;
+}
+
+/* Finds the entry for the first len characters of path, adding an empty one
+ * if create is set
+ */
+static struct cache_entry *
+find_entry_len(struct tutorial_cache *cache, const char *path, size_t len, hbool_t create)
+{
+    uint64_t            hash = hash_string(path, len);
+    struct cache_entry *e    = NULL;
+    size_t              b;
+
+    for (e = cache->buckets[hash & (cache->nbuckets - 1)]; e; e = e->next)
+        if (e->hash == hash && strncmp(e->path, path, len) == 0 && '\0' == e->path[len])
+            return e;
+
+    if (!create)
+        return NULL;
+
+    if (cache->nentries >= cache->nbuckets)
+        grow_buckets(cache);
+
+    e         = calloc(1, sizeof(struct cache_entry));
+    e->path   = strndup(path, len);
+    e->hash   = hash;
+    e->dir_fd = -1;
+
+    b                 = (size_t)(hash & (cache->nbuckets - 1));
+    e->next           = cache->buckets[b];
+    cache->buckets[b] = e;
+    cache->nentries++;
+
+    return e;
+}
+
+static struct cache_entry *
+find_entry(struct tutorial_cache *cache, const char *path, hbool_t create)
+{
+    return find_entry_len(cache, path, strlen(path), create);
+}
+
+/****************/
+/* IDLE HANDLES */
+/****************/
+
+static void
+unlink_idle(struct tutorial_cache *cache, struct cache_entry *e)
+{
+    if (!e->idle)
+        return;
+
+    if (e->idle_prev)
+        e->idle_prev->idle_next = e->idle_next;
+    else
+        cache->idle_head = e->idle_next;
+    if (e->idle_next)
+        e->idle_next->idle_prev = e->idle_prev;
+    else
+        cache->idle_tail = e->idle_prev;
+
+    e->idle_prev = e->idle_next = NULL;
+    e->idle                     = false;
+    cache->nidle--;
+}
+
+static void
+close_idle(struct tutorial_cache *cache, struct cache_entry *e)
+{
+    unlink_idle(cache, e);
+
+    if (e->dir_fd >= 0)
+        close(e->dir_fd);
+    if (e->data_file)
+        fclose(e->data_file);
+    if (e->space_file)
+        fclose(e->space_file);
+    if (e->dir)
+        closedir(e->dir);
+
+    e->dir_fd     = -1;
+    e->data_file  = NULL;
+    e->space_file = NULL;
+    e->dir        = NULL;
+}
+
+/* Puts an entry that was just given handles at the front of the idle list,
+ * closing the handles of the least recently closed object if there are now
+ * too many
+ */
+static void
+make_idle(struct tutorial_cache *cache, struct cache_entry *e)
+{
+    unlink_idle(cache, e);
+
+    e->idle_next = cache->idle_head;
+    if (cache->idle_head)
+        cache->idle_head->idle_prev = e;
+    else
+        cache->idle_tail = e;
+    cache->idle_head = e;
+    e->idle          = true;
+    cache->nidle++;
+
+    if (cache->nidle > CACHE_MAX_IDLE)
+        close_idle(cache, cache->idle_tail);
+}
+
+/* Takes an entry off the idle list once its handles have been handed out */
+static void
+check_idle(struct tutorial_cache *cache, struct cache_entry *e)
+{
+    if (e->dir_fd < 0 && NULL == e->data_file && NULL == e->space_file && NULL == e->dir)
+        unlink_idle(cache, e);
+}
+
+/* Drops a reference to a listing, freeing it if it was the last. The
+ * cache's lock must be held.
+ */
+static void
+unref_listing(struct tutorial_listing *listing)
+{
+    if (listing && 0 == --listing->refcount)
+        free_listing(listing);
+}
+
+/* The same as unref_listing(), for an attribute table */
+static void
+unref_attrs(struct tutorial_attrs *attrs)
+{
+    if (attrs && 0 == --attrs->refcount)
+        free_attrs(attrs);
+}
+
+static void
+free_entry(struct tutorial_cache *cache, struct cache_entry *e)
+{
+    close_idle(cache, e);
+    unref_listing(e->listing);
+    unref_attrs(e->attrs);
+    free(e->path);
+    free(e);
+}
+
+/*********/
+/* CACHE */
+/*********/
+
+struct tutorial_cache *
+create_cache(void)
+{
+    struct tutorial_cache *cache = NULL;
+
+    cache           = calloc(1, sizeof(struct tutorial_cache));
+    cache->buckets  = calloc(CACHE_INIT_NBUCKETS, sizeof(struct cache_entry *));
+    cache->nbuckets = CACHE_INIT_NBUCKETS;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    return cache;
+}
+
+/* Closes every idle handle and forgets everything */
+void
+free_cache(struct tutorial_cache *cache)
+{
+    if (NULL == cache)
+        return;
+
+    for (size_t i = 0; i < cache->nbuckets; i++)
+        while (cache->buckets[i]) {
+            struct cache_entry *e = cache->buckets[i];
+
+            cache->buckets[i] = e->next;
+            free_entry(cache, e);
+        }
+
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->buckets);
+    free(cache);
+}
+
+/* Fills in a dataset's metadata from the cache, along with the handles of
+ * the last closed object for it (if they're still open). Returns false,
+ * leaving dset alone, if the dataset isn't cached.
+ */
+hbool_t
+cache_lookup_dataset(struct tutorial_cache *cache, const char *path, struct tutorial_dataset *dset)
+{
+    struct cache_entry *e = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (NULL == (e = find_entry(cache, path, false)) || !e->has_dataset) {
+        pthread_mutex_unlock(&cache->lock);
+        return false;
+    }
+
+    *dset            = e->dataset;
+    dset->dir_fd     = e->dir_fd;
+    dset->data_file  = e->data_file;
+    dset->space_file = e->space_file;
+
+    e->dir_fd     = -1;
+    e->data_file  = NULL;
+    e->space_file = NULL;
+    check_idle(cache, e);
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return true;
+}
+
+/* Records a dataset's metadata, replacing anything cached for the path.
+ * Called whenever the metadata files are written.
+ */
+void
+cache_store_dataset(struct tutorial_cache *cache, const char *path, const struct tutorial_dataset *dset)
+{
+    struct cache_entry *e = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    e = find_entry(cache, path, true);
+
+    e->has_dataset = true;
+    e->dataset     = *dset;
+
+    e->dataset.dir_fd     = -1;
+    e->dataset.data_file  = NULL;
+    e->dataset.space_file = NULL;
+    e->dataset.use_mmap   = false;
+    e->dataset.map        = NULL;
+    e->dataset.map_size   = 0;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/* Keeps a closing dataset's handles for the next open. Returns false if
+ * they weren't kept, in which case the caller closes them.
+ */
+hbool_t
+cache_release_dataset(struct tutorial_cache *cache, const char *path, struct tutorial_dataset *dset)
+{
+    struct cache_entry *e = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    /* Only one set of handles is kept per dataset */
+    if (NULL == (e = find_entry(cache, path, false)) || !e->has_dataset || e->dir_fd >= 0 || e->data_file ||
+        e->space_file) {
+        pthread_mutex_unlock(&cache->lock);
+        return false;
+    }
+
+    e->dir_fd     = dset->dir_fd;
+    e->data_file  = dset->data_file;
+    e->space_file = dset->space_file;
+    if (e->dir_fd >= 0 || e->data_file || e->space_file)
+        make_idle(cache, e);
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return true;
+}
+
+/* Returns the directory handle of the last closed group at path (rewound),
+ * or NULL if there isn't one
+ */
+DIR *
+cache_lookup_dir(struct tutorial_cache *cache, const char *path)
+{
+    struct cache_entry *e   = NULL;
+    DIR *               dir = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (NULL != (e = find_entry(cache, path, false)) && e->dir) {
+        dir    = e->dir;
+        e->dir = NULL;
+        check_idle(cache, e);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    if (dir)
+        rewinddir(dir);
+
+    return dir;
+}
+
+/* Keeps a closing group's directory handle for the next open. Returns false
+ * if it wasn't kept, in which case the caller closes it.
+ */
+hbool_t
+cache_release_dir(struct tutorial_cache *cache, const char *path, DIR *dir)
+{
+    struct cache_entry *e = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    e = find_entry(cache, path, true);
+    if (e->dir) {
+        pthread_mutex_unlock(&cache->lock);
+        return false;
+    }
+
+    e->dir = dir;
+    make_idle(cache, e);
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return true;
+}
+
+/* Returns the group at path's member listing, with a reference the caller
+ * gives back with cache_release_listing(), or NULL if there isn't one
+ */
+struct tutorial_listing *
+cache_lookup_listing(struct tutorial_cache *cache, const char *path)
+{
+    struct cache_entry *     e       = NULL;
+    struct tutorial_listing *listing = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (NULL != (e = find_entry(cache, path, false)) && NULL != (listing = e->listing))
+        listing->refcount++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return listing;
+}
+
+/* Records the group at path's member listing. The caller's reference is
+ * kept, so it still needs releasing.
+ */
+void
+cache_store_listing(struct tutorial_cache *cache, const char *path, struct tutorial_listing *listing)
+{
+    struct cache_entry *e = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    e = find_entry(cache, path, true);
+    unref_listing(e->listing);
+    e->listing = listing;
+    listing->refcount++;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void
+cache_release_listing(struct tutorial_cache *cache, struct tutorial_listing *listing)
+{
+    pthread_mutex_lock(&cache->lock);
+    unref_listing(listing);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/* Returns the attribute table of the object at path, with a reference the
+ * caller gives back with cache_release_attrs(), or NULL if there isn't one
+ */
+struct tutorial_attrs *
+cache_lookup_attrs(struct tutorial_cache *cache, const char *path)
+{
+    struct cache_entry *   e     = NULL;
+    struct tutorial_attrs *attrs = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (NULL != (e = find_entry(cache, path, false)) && NULL != (attrs = e->attrs))
+        attrs->refcount++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return attrs;
+}
+
+/* Records the attribute table of the object at path, replacing the old one.
+ * The caller's reference is kept, so it still needs releasing.
+ */
+void
+cache_store_attrs(struct tutorial_cache *cache, const char *path, struct tutorial_attrs *attrs)
+{
+    struct cache_entry *e = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    e = find_entry(cache, path, true);
+    unref_attrs(e->attrs);
+    e->attrs = attrs;
+    attrs->refcount++;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void
+cache_release_attrs(struct tutorial_cache *cache, struct tutorial_attrs *attrs)
+{
+    pthread_mutex_lock(&cache->lock);
+    unref_attrs(attrs);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/* Drops the listing of the group holding the object at path. The cache's
+ * lock must be held.
+ */
+static void
+drop_parent_listing(struct tutorial_cache *cache, const char *path)
+{
+    const char *        slash = strrchr(path, '/');
+    struct cache_entry *e     = NULL;
+
+    if (slash && NULL != (e = find_entry_len(cache, path, (size_t)(slash - path), false))) {
+        unref_listing(e->listing);
+        e->listing = NULL;
+    }
+}
+
+/* Forgets everything about the object at path, e.g. because it's being
+ * created anew, along with its parent group's listing
+ */
+void
+cache_evict(struct tutorial_cache *cache, const char *path)
+{
+    uint64_t             hash = hash_string(path, strlen(path));
+    struct cache_entry **ep   = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    for (ep = &(cache->buckets[hash & (cache->nbuckets - 1)]); *ep; ep = &((*ep)->next)) {
+        struct cache_entry *e = *ep;
+
+        if (e->hash == hash && strcmp(e->path, path) == 0) {
+            *ep = e->next;
+            free_entry(cache, e);
+            cache->nentries--;
+            break;
+        }
+    }
+
+    drop_parent_listing(cache, path);
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/* The same as cache_evict(), but for everything under path too, because
+ * it's been deleted
+ */
+void
+cache_evict_tree(struct tutorial_cache *cache, const char *path)
+{
+    size_t len = strlen(path);
+
+    pthread_mutex_lock(&cache->lock);
+
+    for (size_t i = 0; i < cache->nbuckets; i++)
+        for (struct cache_entry **ep = &(cache->buckets[i]); *ep;) {
+            struct cache_entry *e = *ep;
+
+            if (strncmp(e->path, path, len) == 0 && ('\0' == e->path[len] || '/' == e->path[len])) {
+                *ep = e->next;
+                free_entry(cache, e);
+                cache->nentries--;
+            }
+            else
+                ep = &(e->next);
+        }
+
+    drop_parent_listing(cache, path);
+
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,39 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Per-file metadata cache for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_CACHE_H
+#define TUTORIAL_CACHE_H
+
+#include <dirent.h>
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+struct tutorial_cache *create_cache(void);
+void                   free_cache(struct tutorial_cache *cache);
+
+hbool_t cache_lookup_dataset(struct tutorial_cache *cache, const char *path, struct tutorial_dataset *dset);
+void    cache_store_dataset(struct tutorial_cache *cache, const char *path, const struct tutorial_dataset *dset);
+hbool_t cache_release_dataset(struct tutorial_cache *cache, const char *path, struct tutorial_dataset *dset);
+
+DIR *   cache_lookup_dir(struct tutorial_cache *cache, const char *path);
+hbool_t cache_release_dir(struct tutorial_cache *cache, const char *path, DIR *dir);
+
+struct tutorial_listing *cache_lookup_listing(struct tutorial_cache *cache, const char *path);
+void cache_store_listing(struct tutorial_cache *cache, const char *path, struct tutorial_listing *listing);
+void cache_release_listing(struct tutorial_cache *cache, struct tutorial_listing *listing);
+
+struct tutorial_attrs *cache_lookup_attrs(struct tutorial_cache *cache, const char *path);
+void cache_store_attrs(struct tutorial_cache *cache, const char *path, struct tutorial_attrs *attrs);
+void cache_release_attrs(struct tutorial_cache *cache, struct tutorial_attrs *attrs);
+
+void cache_evict(struct tutorial_cache *cache, const char *path);
+void cache_evict_tree(struct tutorial_cache *cache, const char *path);
+
+#endif /* TUTORIAL_CACHE_H */
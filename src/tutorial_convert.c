@@ -0,0 +1,427 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Element type description and datatype conversion for a
+ *              simple tutorial virtual object layer (VOL) connector
+ */
+
+#include <hdf5.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tutorial_convert.h"
+#include "tutorial_internal.h"
+
+/* Types with a hand-written conversion loop (native byte order only) */
+enum fast_kind {
+    FAST_NONE,
+    FAST_INT32,
+    FAST_INT64,
+    FAST_FLOAT,
+    FAST_DOUBLE,
+};
+
+/*************/
+/* TYPE INFO */
+/*************/
+
+H5T_order_t
+native_order(void)
+{
+    const uint16_t one = 1;
+
+    return (*(const unsigned char *)&one) ? H5T_ORDER_LE : H5T_ORDER_BE;
+}
+
+herr_t
+type_from_hid(hid_t type_id, struct tutorial_type *type)
+{
+    H5T_class_t cls = H5Tget_class(type_id);
+
+    memset(type, 0, sizeof(*type));
+
+    /* Only plain integers and IEEE floats are described. Anything else
+     * (including integers with padding bits) goes through H5Tconvert.
+     */
+    if (H5T_INTEGER == cls) {
+        type->size = H5Tget_size(type_id);
+        type->sign = H5Tget_sign(type_id);
+        if (H5Tget_precision(type_id) != 8 * type->size || H5Tget_offset(type_id) != 0)
+            return -1;
+    }
+    else if (H5T_FLOAT == cls) {
+        if (H5Tequal(type_id, H5T_IEEE_F32LE) <= 0 && H5Tequal(type_id, H5T_IEEE_F32BE) <= 0 &&
+            H5Tequal(type_id, H5T_IEEE_F64LE) <= 0 && H5Tequal(type_id, H5T_IEEE_F64BE) <= 0)
+            return -1;
+        type->size = H5Tget_size(type_id);
+        type->sign = H5T_SGN_NONE;
+    }
+    else
+        return -1;
+
+    type->cls   = cls;
+    type->order = H5Tget_order(type_id);
+    if (H5T_ORDER_LE != type->order && H5T_ORDER_BE != type->order)
+        return -1;
+
+    return 0;
+}
+
+hid_t
+type_to_hid(const struct tutorial_type *type)
+{
+    hid_t base = H5I_INVALID_HID;
+    hid_t id   = H5I_INVALID_HID;
+
+    if (H5T_FLOAT == type->cls)
+        base = (4 == type->size) ? H5T_IEEE_F32LE : H5T_IEEE_F64LE;
+    else {
+        hbool_t is_signed = (H5T_SGN_2 == type->sign);
+
+        switch (type->size) {
+            case 1:
+                base = is_signed ? H5T_STD_I8LE : H5T_STD_U8LE;
+                break;
+            case 2:
+                base = is_signed ? H5T_STD_I16LE : H5T_STD_U16LE;
+                break;
+            case 4:
+                base = is_signed ? H5T_STD_I32LE : H5T_STD_U32LE;
+                break;
+            default:
+                base = is_signed ? H5T_STD_I64LE : H5T_STD_U64LE;
+                break;
+        }
+    }
+
+    if ((id = H5Tcopy(base)) < 0)
+        return H5I_INVALID_HID;
+    if (H5Tset_order(id, type->order) < 0) {
+        H5Tclose(id);
+        return H5I_INVALID_HID;
+    }
+
+    return id;
+}
+
+/* Whether elements of this type can be stored in a dataset */
+hbool_t
+type_is_storable(const struct tutorial_type *type)
+{
+    if (H5T_INTEGER == type->cls)
+        return 1 == type->size || 2 == type->size || 4 == type->size || 8 == type->size;
+    if (H5T_FLOAT == type->cls)
+        return 4 == type->size || 8 == type->size;
+
+    return false;
+}
+
+hbool_t
+types_equal(const struct tutorial_type *a, const struct tutorial_type *b)
+{
+    return a->cls == b->cls && a->size == b->size && a->sign == b->sign && a->order == b->order;
+}
+
+/* The datatype file holds one line:
+ *
+ *  INTEGER 4 SIGNED LE
+ *  FLOAT 8 BE
+ */
+void
+type_to_string(const struct tutorial_type *type, char *out, size_t len)
+{
+    const char *order = (H5T_ORDER_BE == type->order) ? "BE" : "LE";
+
+    if (H5T_FLOAT == type->cls)
+        snprintf(out, len, "FLOAT %zu %s", type->size, order);
+    else
+        snprintf(out, len, "INTEGER %zu %s %s", type->size, H5T_SGN_2 == type->sign ? "SIGNED" : "UNSIGNED",
+                 order);
+}
+
+herr_t
+type_from_string(const char *str, struct tutorial_type *type)
+{
+    char   cls[16];
+    char   sign[16];
+    char   order[16];
+    size_t size = 0;
+
+    memset(type, 0, sizeof(*type));
+
+    /* Legacy datasets always stored native ints */
+    if (strncmp(str, TUTORIAL_DATA_TYPE_INT_STRING, strlen(TUTORIAL_DATA_TYPE_INT_STRING)) == 0 ||
+        strncmp(str, TUTORIAL_DATA_TYPE_FLOAT_STRING, strlen(TUTORIAL_DATA_TYPE_FLOAT_STRING)) == 0) {
+        type->cls   = H5T_INTEGER;
+        type->size  = sizeof(int);
+        type->sign  = H5T_SGN_2;
+        type->order = native_order();
+        return 0;
+    }
+
+    if (sscanf(str, "%15s %zu", cls, &size) != 2)
+        return -1;
+
+    if (strcmp(cls, "FLOAT") == 0) {
+        if (sscanf(str, "%*s %*u %15s", order) != 1)
+            return -1;
+        type->cls  = H5T_FLOAT;
+        type->sign = H5T_SGN_NONE;
+    }
+    else if (strcmp(cls, "INTEGER") == 0) {
+        if (sscanf(str, "%*s %*u %15s %15s", sign, order) != 2)
+            return -1;
+        type->cls  = H5T_INTEGER;
+        type->sign = (strcmp(sign, "SIGNED") == 0) ? H5T_SGN_2 : H5T_SGN_NONE;
+    }
+    else
+        return -1;
+
+    type->size  = size;
+    type->order = (strcmp(order, "BE") == 0) ? H5T_ORDER_BE : H5T_ORDER_LE;
+
+    return type_is_storable(type) ? 0 : -1;
+}
+
+/************/
+/* ELEMENTS */
+/************/
+
+/* Reverses the bytes of n elements. in and out may be the same buffer. */
+static void
+swap_copy(const void *in, void *out, size_t n, size_t size)
+{
+    const char *src = (const char *)in;
+    char *      dst = (char *)out;
+
+    /* Written as shifts on whole words so the compiler can use bswap
+     * and vectorize the loops.
+     */
+    switch (size) {
+        case 2:
+            for (size_t i = 0; i < n; i++) {
+                uint16_t v;
+
+                memcpy(&v, src + 2 * i, 2);
+                v = (uint16_t)((v << 8) | (v >> 8));
+                memcpy(dst + 2 * i, &v, 2);
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < n; i++) {
+                uint32_t v;
+
+                memcpy(&v, src + 4 * i, 4);
+                v = ((v & 0x000000FFu) << 24) | ((v & 0x0000FF00u) << 8) | ((v & 0x00FF0000u) >> 8) |
+                    ((v & 0xFF000000u) >> 24);
+                memcpy(dst + 4 * i, &v, 4);
+            }
+            break;
+        case 8:
+            for (size_t i = 0; i < n; i++) {
+                uint64_t v;
+
+                memcpy(&v, src + 8 * i, 8);
+                v = ((v & 0x00000000000000FFull) << 56) | ((v & 0x000000000000FF00ull) << 40) |
+                    ((v & 0x0000000000FF0000ull) << 24) | ((v & 0x00000000FF000000ull) << 8) |
+                    ((v & 0x000000FF00000000ull) >> 8) | ((v & 0x0000FF0000000000ull) >> 24) |
+                    ((v & 0x00FF000000000000ull) >> 40) | ((v & 0xFF00000000000000ull) >> 56);
+                memcpy(dst + 8 * i, &v, 8);
+            }
+            break;
+        default:
+            for (size_t i = 0; i < n; i++)
+                for (size_t j = 0; j < size / 2; j++) {
+                    char tmp = src[i * size + j];
+
+                    dst[i * size + j]            = src[i * size + size - 1 - j];
+                    dst[i * size + size - 1 - j] = tmp;
+                }
+            break;
+    }
+}
+
+void
+swap_elements(void *buf, size_t n, size_t size)
+{
+    swap_copy(buf, buf, n, size);
+}
+
+/* Sets n elements of buf to elmt */
+void
+fill_elements(void *buf, size_t n, const void *elmt, size_t size)
+{
+    size_t done  = 0;
+    size_t total = n * size;
+
+    if (0 == n)
+        return;
+
+    /* Double the filled region each time */
+    memcpy(buf, elmt, size);
+    for (done = size; done < total; done *= 2)
+        memcpy((char *)buf + done, buf, (done < total - done) ? done : total - done);
+}
+
+/**************/
+/* CONVERSION */
+/**************/
+
+static enum fast_kind
+get_fast_kind(const struct tutorial_type *type)
+{
+    if (type->order != native_order())
+        return FAST_NONE;
+
+    if (H5T_INTEGER == type->cls && H5T_SGN_2 == type->sign) {
+        if (4 == type->size)
+            return FAST_INT32;
+        if (8 == type->size)
+            return FAST_INT64;
+    }
+    else if (H5T_FLOAT == type->cls) {
+        if (4 == type->size)
+            return FAST_FLOAT;
+        if (8 == type->size)
+            return FAST_DOUBLE;
+    }
+
+    return FAST_NONE;
+}
+
+/* One pass over n elements with no data-dependent branches, so that the
+ * compiler can vectorize it. Unaligned buffers are handled with memcpy.
+ */
+#define CONVERT_LOOP(STYPE, DTYPE, EXPR)                                                                   \
+    do {                                                                                                   \
+        for (size_t i = 0; i < n; i++) {                                                                   \
+            STYPE v;                                                                                       \
+            DTYPE r;                                                                                       \
+                                                                                                           \
+            memcpy(&v, src + i * sizeof(STYPE), sizeof(STYPE));                                           \
+            r = (EXPR);                                                                                    \
+            memcpy(dst + i * sizeof(DTYPE), &r, sizeof(DTYPE));                                            \
+        }                                                                                                  \
+    } while (0)
+
+/* Floating point to integer conversions clamp out-of-range values and turn
+ * NaN into 0, like HDF5's own conversions.
+ */
+#define CLAMP_TO_INT(v, TYPE, MIN, MAX)                                                                    \
+    ((v) != (v) ? (TYPE)0 : (v) >= (MAX) ? (TYPE)(MAX) : (v) <= (MIN) ? (TYPE)(MIN) : (TYPE)(v))
+
+static hbool_t
+convert_fast(enum fast_kind from, enum fast_kind to, size_t n, const void *in, void *out)
+{
+    const char *src = (const char *)in;
+    char *      dst = (char *)out;
+
+    switch (from) {
+        case FAST_INT32:
+            if (FAST_FLOAT == to)
+                CONVERT_LOOP(int32_t, float, (float)v);
+            else if (FAST_DOUBLE == to)
+                CONVERT_LOOP(int32_t, double, (double)v);
+            else if (FAST_INT64 == to)
+                CONVERT_LOOP(int32_t, int64_t, (int64_t)v);
+            else
+                return false;
+            return true;
+        case FAST_INT64:
+            if (FAST_DOUBLE == to)
+                CONVERT_LOOP(int64_t, double, (double)v);
+            else
+                return false;
+            return true;
+        case FAST_FLOAT:
+            if (FAST_DOUBLE == to)
+                CONVERT_LOOP(float, double, (double)v);
+            else if (FAST_INT32 == to)
+                CONVERT_LOOP(float, int32_t, CLAMP_TO_INT(v, int32_t, -2147483648.0f, 2147483647.0f));
+            else
+                return false;
+            return true;
+        case FAST_DOUBLE:
+            if (FAST_FLOAT == to)
+                CONVERT_LOOP(double, float, (float)v);
+            else if (FAST_INT32 == to)
+                CONVERT_LOOP(double, int32_t, CLAMP_TO_INT(v, int32_t, -2147483648.0, 2147483647.0));
+            else
+                return false;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Whether convert_elements can convert between the two types without the
+ * library (and so without HDF5 datatypes, or the calling thread)
+ */
+hbool_t
+convert_is_native(const struct tutorial_type *src, const struct tutorial_type *dst)
+{
+    if (H5T_NO_CLASS == src->cls || H5T_NO_CLASS == dst->cls)
+        return false;
+
+    if (src->cls == dst->cls && src->size == dst->size && src->sign == dst->sign)
+        return true;
+
+    /* Converting nothing just reports whether there's a loop for it */
+    return convert_fast(get_fast_kind(src), get_fast_kind(dst), 0, NULL, NULL);
+}
+
+/* Converts n elements of type src in the in buffer to type dst in the out
+ * buffer. The types may also be given as HDF5 datatypes (or H5I_INVALID_HID),
+ * which is required when the struct doesn't describe the type (cls is
+ * H5T_NO_CLASS). out must hold n elements of the larger of the two types,
+ * and must not overlap in.
+ */
+herr_t
+convert_elements(const struct tutorial_type *src, hid_t src_id, const struct tutorial_type *dst,
+                 hid_t dst_id, size_t n, const void *in, void *out)
+{
+    hid_t  sid = src_id;
+    hid_t  did = dst_id;
+    herr_t ret = 0;
+
+    if (H5T_NO_CLASS != src->cls && H5T_NO_CLASS != dst->cls) {
+        /* Nothing to do */
+        if (types_equal(src, dst)) {
+            memcpy(out, in, n * src->size);
+            return 0;
+        }
+
+        /* Same values, other byte order */
+        if (src->cls == dst->cls && src->size == dst->size && src->sign == dst->sign) {
+            swap_copy(in, out, n, src->size);
+            return 0;
+        }
+
+        /* Common numeric conversions */
+        if (convert_fast(get_fast_kind(src), get_fast_kind(dst), n, in, out))
+            return 0;
+    }
+
+    /* Let the library handle everything else */
+    if (sid < 0 && (sid = type_to_hid(src)) < 0)
+        return -1;
+    if (did < 0 && (did = type_to_hid(dst)) < 0) {
+        ret = -1;
+        goto done;
+    }
+
+    memcpy(out, in, n * H5Tget_size(sid));
+    if (n > 0 && H5Tconvert(sid, did, n, out, NULL, H5P_DEFAULT) < 0)
+        ret = -1;
+
+done:
+    if (src_id < 0 && sid >= 0)
+        H5Tclose(sid);
+    if (dst_id < 0 && did >= 0)
+        H5Tclose(did);
+
+    return ret;
+}
@@ -0,0 +1,31 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Element type description and datatype conversion for a
+ *              simple tutorial virtual object layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_CONVERT_H
+#define TUTORIAL_CONVERT_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+H5T_order_t native_order(void);
+herr_t      type_from_hid(hid_t type_id, struct tutorial_type *type);
+hid_t       type_to_hid(const struct tutorial_type *type);
+hbool_t     type_is_storable(const struct tutorial_type *type);
+hbool_t     types_equal(const struct tutorial_type *a, const struct tutorial_type *b);
+void        type_to_string(const struct tutorial_type *type, char *out, size_t len);
+herr_t      type_from_string(const char *str, struct tutorial_type *type);
+
+void    swap_elements(void *buf, size_t n, size_t size);
+void    fill_elements(void *buf, size_t n, const void *elmt, size_t size);
+hbool_t convert_is_native(const struct tutorial_type *src, const struct tutorial_type *dst);
+herr_t  convert_elements(const struct tutorial_type *src, hid_t src_id, const struct tutorial_type *dst,
+                         hid_t dst_id, size_t n, const void *in, void *out);
+
+#endif /* TUTORIAL_CONVERT_H */
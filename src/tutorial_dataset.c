@@ -8,281 +8,2827 @@
  */
 
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <hdf5.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include "tutorial_batch.h"
+#include "tutorial_cache.h"
+#include "tutorial_convert.h"
+#include "tutorial_filter.h"
+#include "tutorial_index.h"
 #include "tutorial_internal.h"
+#include "tutorial_journal.h"
+#include "tutorial_pool.h"
+#include "tutorial_request.h"
+#include "tutorial_text.h"
 #include "tutorial_util.h"
+#include "tutorial_vol_connector.h"
+#include "tutorial_writeback.h"
 
-/* File extensions for dataset components */
+/* File extensions for dataset components. Datasets created by older versions
+ * have separate text files for the extent, type, fill value and layout
+ * rather than one metadata record.
+ */
+#define META_EXT    "meta"
 #define SPACE_EXT   "dataspace"
 #define DATA_EXT    "data"
 #define TYPE_EXT    "datatype"
 #define FILLVAL_EXT "fillval"
+#define LAYOUT_EXT  "layout"
+#define CHUNK_EXT   "chunk"
+
+/* Added to the name of a file's replacement while it's being written */
+#define TEMP_SUFFIX ".tmp"
+
+/* Binary data files start with this header, followed by the elements in the
+ * byte order given there. Files without the magic number are legacy text
+ * files.
+ */
+#define DATA_MAGIC   "TVDF"
+#define DATA_VERSION 1
+
+struct data_header {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  byte_order; /* H5T_order_t of the stored elements */
+    uint16_t filters;    /* TUTORIAL_FILTER_* applied to the elements (chunks only) */
+    uint32_t elem_size;
+    uint32_t reserved2;
+};
+
+/* A dataset's metadata record, followed by its dims, maxdims and chunk dims
+ * (rank of each, as 64-bit integers). Like the data header, it's in native
+ * byte order.
+ */
+#define META_MAGIC   "TVDM"
+#define META_VERSION 1
+
+struct meta_record {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  rank;
+    uint8_t  format;     /* enum tutorial_data_format */
+    uint8_t  layout;     /* enum tutorial_layout */
+    uint8_t  type_class; /* H5T_class_t of the stored elements */
+    uint8_t  type_sign;  /* H5T_sign_t */
+    uint8_t  type_order; /* H5T_order_t */
+    uint8_t  fill_never;
+    uint32_t type_size;
+    uint8_t  filters; /* TUTORIAL_FILTER_* (chunked only) */
+    uint8_t  deflate_level;
+    uint16_t reserved1;
+    uint8_t  fillval[TUTORIAL_MAX_TYPE_SIZE]; /* In the stored byte order */
+    uint32_t reserved2;
+    uint32_t reserved3; /* Keeps the dims that follow 8-byte aligned */
+};
+
+#define META_MAX_SIZE (sizeof(struct meta_record) + 3 * H5S_MAX_RANK * sizeof(uint64_t))
+
+/* Number of elements buffered when writing fill values */
+#define FILL_BUF_NELMTS 4096
+
+/* Number of elements encoded to text at once, and the number of bytes of
+ * text read at once
+ */
+#define TEXT_BLOCK_NELMTS 32768
+#define TEXT_BUF_SIZE     ((size_t)1024 * 1024)
+
+/* Number of selection sequences fetched from a selection iterator at once */
+#define SEQ_LIST_LEN 128
+
+/* Nearby runs are read with one pread when the bytes between them are at
+ * most COALESCE_GAP and the whole span fits in COALESCE_MAX.
+ */
+#define COALESCE_GAP ((hsize_t)64 * 1024)
+#define COALESCE_MAX ((hsize_t)1024 * 1024)
+
+/* Number of chunks a single read or write keeps in memory at once */
+#define CHUNK_CACHE_NSLOTS 16
+
+/* Large reads and writes are split into one part per thread, as long as
+ * each part is at least this big
+ */
+#define PARALLEL_PART_BYTES ((hsize_t)1024 * 1024)
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 /*************/
 /* DATASPACE */
 /*************/
 
-static void
-read_dataspace_file(struct tutorial_object *obj)
+static hsize_t
+dataset_nelmts(const struct tutorial_dataset *dset)
+{
+    hsize_t n = 1;
+
+    for (int i = 0; i < dset->rank; i++)
+        n *= dset->dims[i];
+
+    return n;
+}
+
+/* Opens one of the dataset's files (<name>.<ext>) in its directory */
+static FILE *
+open_dataset_file(struct tutorial_object *obj, const char *ext, const char *mode)
+{
+    return fopen_at(obj->data.dataset.dir_fd, base_name(obj->name), ext, mode);
+}
+
+static void
+read_dataspace_file(struct tutorial_object *obj)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    /* Seek to the beginning */
+    rewind(dset->space_file);
+
+    /* The file looks like:
+     *
+     *  rank 2
+     *  dims 10 20
+     *  maxdims 10 20
+     *
+     * Legacy files hold a single number, the size of a 1D dataset.
+     */
+    if (fscanf(dset->space_file, "rank %d\n", &(dset->rank)) != 1 || dset->rank < 0 ||
+        dset->rank > H5S_MAX_RANK) {
+        rewind(dset->space_file);
+        dset->rank = 1;
+        fscanf(dset->space_file, "%" PRIuHSIZE "\n", &(dset->dims[0]));
+        dset->maxdims[0] = dset->dims[0];
+        return;
+    }
+
+    fscanf(dset->space_file, "dims");
+    for (int i = 0; i < dset->rank; i++)
+        fscanf(dset->space_file, " %" PRIuHSIZE, &(dset->dims[i]));
+    fscanf(dset->space_file, "\nmaxdims");
+    for (int i = 0; i < dset->rank; i++)
+        if (fscanf(dset->space_file, " %" PRIuHSIZE, &(dset->maxdims[i])) != 1)
+            dset->maxdims[i] = dset->dims[i];
+}
+
+static herr_t
+write_dataspace_file(struct tutorial_object *obj)
+{
+    int                      fd;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    /* Seek to the beginning */
+    rewind(dset->space_file);
+
+    /* Truncate the file */
+    fd = fileno(dset->space_file);
+    if (ftruncate(fd, 0) < 0)
+        return -1;
+
+    /* Write out the new extent */
+    fprintf(dset->space_file, "rank %d\ndims", dset->rank);
+    for (int i = 0; i < dset->rank; i++)
+        fprintf(dset->space_file, " %" PRIuHSIZE, dset->dims[i]);
+    fprintf(dset->space_file, "\nmaxdims");
+    for (int i = 0; i < dset->rank; i++)
+        fprintf(dset->space_file, " %" PRIuHSIZE, dset->maxdims[i]);
+    fprintf(dset->space_file, "\n");
+
+    return fflush(dset->space_file) == 0 && !ferror(dset->space_file) ? 0 : -1;
+}
+
+/************/
+/* DATATYPE */
+/************/
+
+static herr_t
+read_datatype_file(struct tutorial_object *obj)
+{
+    FILE *                   type_file = NULL;
+    char *                   line      = NULL;
+    size_t                   len       = 0;
+    struct tutorial_dataset *dset      = &(obj->data.dataset);
+
+    if (NULL == (type_file = open_dataset_file(obj, TYPE_EXT, "r")))
+        return -1;
+
+    /* Anything unreadable is taken to be a legacy int dataset */
+    if (getline(&line, &len, type_file) < 0 || type_from_string(line, &(dset->type)) < 0)
+        type_from_string(TUTORIAL_DATA_TYPE_INT_STRING, &(dset->type));
+
+    fclose(type_file);
+
+    free(line);
+
+    return 0;
+}
+
+/**************/
+/* FILL VALUE */
+/**************/
+
+static herr_t
+read_fillval_file(struct tutorial_object *obj)
+{
+    FILE *                   fillval_file = NULL;
+    char                     word[64];
+    struct tutorial_dataset *dset         = &(obj->data.dataset);
+
+    if (NULL == (fillval_file = open_dataset_file(obj, FILLVAL_EXT, "r")))
+        return -1;
+
+    /* Extract the value (written in text, so native order) */
+    memset(dset->fillval, 0, sizeof(dset->fillval));
+    if (fscanf(fillval_file, "%63s", word) == 1)
+        parse_element(&(dset->type), word, dset->fillval);
+    if (dset->type.order != native_order())
+        swap_elements(dset->fillval, 1, dset->type.size);
+
+    /* And whether fill values are ever written */
+    dset->fill_never = (fscanf(fillval_file, "%63s", word) == 1 && strcmp(word, "never") == 0);
+
+    fclose(fillval_file);
+
+    return 0;
+}
+
+/* Fill values of all zero bytes don't need writing to sparse files */
+static hbool_t
+fillval_is_zero(const struct tutorial_dataset *dset)
+{
+    for (size_t i = 0; i < dset->type.size; i++)
+        if (dset->fillval[i])
+            return false;
+
+    return true;
+}
+
+/**********/
+/* LAYOUT */
+/**********/
+
+static void
+read_layout_file(struct tutorial_object *obj)
+{
+    FILE *                   layout_file = NULL;
+    char                     word[16];
+    struct tutorial_dataset *dset        = &(obj->data.dataset);
+
+    /* Datasets without a layout file predate chunking */
+    dset->layout = TUTORIAL_LAYOUT_CONTIGUOUS;
+
+    if (NULL != (layout_file = open_dataset_file(obj, LAYOUT_EXT, "r"))) {
+        if (fscanf(layout_file, "%15s", word) == 1 && strcmp(word, "chunked") == 0) {
+            dset->layout = TUTORIAL_LAYOUT_CHUNKED;
+            for (int i = 0; i < dset->rank; i++)
+                fscanf(layout_file, " %" PRIuHSIZE, &(dset->chunk_dims[i]));
+        }
+        fclose(layout_file);
+    }
+}
+
+/************/
+/* METADATA */
+/************/
+
+static herr_t
+write_meta_file(struct tutorial_object *obj)
+{
+    uint64_t                 buf[META_MAX_SIZE / sizeof(uint64_t)];
+    struct meta_record       rec;
+    uint64_t *               dims = buf + sizeof(rec) / sizeof(uint64_t);
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    size_t                   size = sizeof(rec) + 3 * (size_t)dset->rank * sizeof(uint64_t);
+    int                      fd   = fileno(dset->space_file);
+
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.magic, META_MAGIC, sizeof(rec.magic));
+    rec.version       = META_VERSION;
+    rec.rank          = (uint8_t)dset->rank;
+    rec.format        = (uint8_t)dset->format;
+    rec.layout        = (uint8_t)dset->layout;
+    rec.type_class    = (uint8_t)dset->type.cls;
+    rec.type_sign     = (uint8_t)dset->type.sign;
+    rec.type_order    = (uint8_t)dset->type.order;
+    rec.fill_never    = (uint8_t)dset->fill_never;
+    rec.type_size     = (uint32_t)dset->type.size;
+    rec.filters       = (uint8_t)dset->filters;
+    rec.deflate_level = (uint8_t)dset->deflate_level;
+    memcpy(rec.fillval, dset->fillval, sizeof(rec.fillval));
+    memcpy(buf, &rec, sizeof(rec));
+
+    for (int i = 0; i < dset->rank; i++) {
+        dims[i]                  = dset->dims[i];
+        dims[dset->rank + i]     = dset->maxdims[i];
+        dims[2 * dset->rank + i] = dset->chunk_dims[i];
+    }
+
+    /* The whole record goes out in one write, so it's never half updated */
+    if (pwrite(fd, buf, size, 0) != (ssize_t)size || ftruncate(fd, (off_t)size) < 0)
+        return -1;
+
+    return 0;
+}
+
+/* Fills in the dataset from its metadata record, which takes a single read */
+static herr_t
+read_meta_file(struct tutorial_object *obj)
+{
+    uint64_t                 buf[META_MAX_SIZE / sizeof(uint64_t)];
+    struct meta_record       rec;
+    const uint64_t *         dims = buf + sizeof(rec) / sizeof(uint64_t);
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    ssize_t                  size;
+
+    size = pread(fileno(dset->space_file), buf, sizeof(buf), 0);
+    if (size < (ssize_t)sizeof(rec))
+        return -1;
+
+    memcpy(&rec, buf, sizeof(rec));
+    if (memcmp(rec.magic, META_MAGIC, sizeof(rec.magic)) != 0 || rec.version != META_VERSION ||
+        rec.rank > H5S_MAX_RANK || size < (ssize_t)(sizeof(rec) + 3 * rec.rank * sizeof(uint64_t)))
+        return -1;
+
+    dset->rank          = rec.rank;
+    dset->format        = (enum tutorial_data_format)rec.format;
+    dset->layout        = (enum tutorial_layout)rec.layout;
+    dset->type.cls      = (H5T_class_t)rec.type_class;
+    dset->type.sign     = (H5T_sign_t)rec.type_sign;
+    dset->type.order    = (H5T_order_t)rec.type_order;
+    dset->type.size     = rec.type_size;
+    dset->fill_never    = rec.fill_never;
+    dset->filters       = rec.filters;
+    dset->deflate_level = rec.deflate_level;
+    memcpy(dset->fillval, rec.fillval, sizeof(dset->fillval));
+
+    for (int i = 0; i < dset->rank; i++) {
+        dset->dims[i]       = dims[i];
+        dset->maxdims[i]    = dims[dset->rank + i];
+        dset->chunk_dims[i] = dims[2 * dset->rank + i];
+    }
+
+    return 0;
+}
+
+/* Writes out a new extent (or, for a new dataset, all of its metadata) */
+static herr_t
+update_metadata(struct tutorial_object *obj)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    /* Datasets opened from the cache only open the file once it changes */
+    if (NULL == dset->space_file &&
+        NULL == (dset->space_file = open_dataset_file(obj, dset->legacy_meta ? SPACE_EXT : META_EXT, "r+")))
+        return -1;
+
+    if ((dset->legacy_meta ? write_dataspace_file(obj) : write_meta_file(obj)) < 0)
+        return -1;
+
+    /* With a journal, the extent is on disk before anything that relies on
+     * it is written
+     */
+    if (obj->file->journal && fdatasync(fileno(dset->space_file)) < 0)
+        return -1;
+
+    /* Later opens pick up the change from the cache */
+    cache_store_dataset(obj->file->cache, obj->path, dset);
+
+    return 0;
+}
+
+/******************/
+/* DATASET / DATA */
+/******************/
+
+static herr_t
+open_data_file(struct tutorial_object *obj, const char *mode)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    dset->data_file = open_dataset_file(obj, DATA_EXT, mode);
+
+    return dset->data_file ? 0 : -1;
+}
+
+/* With a journal, a file that is rewritten from scratch gets a replacement
+ * instead, which is written, synced, and then renamed over it, so a crash
+ * leaves either the old contents or the new ones. This opens the
+ * replacement for <name>.<ext>.
+ */
+static int
+open_replacement(struct tutorial_object *obj, const char *ext)
+{
+    char temp_ext[NAME_MAX + 1];
+
+    snprintf(temp_ext, sizeof(temp_ext), "%s" TEMP_SUFFIX, ext);
+
+    return open_at(obj->data.dataset.dir_fd, base_name(obj->name), temp_ext, O_RDWR | O_CREAT | O_TRUNC);
+}
+
+/* Puts the replacement written to fd in place of <name>.<ext>, or throws
+ * it away if it couldn't be written (written < 0). The rename is made
+ * durable by syncing the directory, which callers replacing several files
+ * do once for all of them.
+ */
+static herr_t
+replace_file(struct tutorial_object *obj, const char *ext, int fd, herr_t written)
+{
+    int  dir_fd = obj->data.dataset.dir_fd;
+    char name[NAME_MAX + 1];
+    char temp_name[NAME_MAX + 1 + sizeof(TEMP_SUFFIX)];
+
+    snprintf(name, sizeof(name), "%s.%s", base_name(obj->name), ext);
+    snprintf(temp_name, sizeof(temp_name), "%s" TEMP_SUFFIX, name);
+
+    if (written < 0 || fdatasync(fd) < 0 || renameat(dir_fd, temp_name, dir_fd, name) < 0) {
+        unlinkat(dir_fd, temp_name, 0);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Writes that don't go through the journal wait until the dataset's
+ * buffered bytes are written and the journal is emptied, so nothing older
+ * in it can be replayed over them after a crash
+ */
+static herr_t
+settle_journal(struct tutorial_object *obj)
+{
+    if (NULL == obj->file->journal)
+        return 0;
+
+    if (drain_write_buffer(obj->file, obj->path, false) < 0 || checkpoint_journal(obj->file, true) < 0)
+        return -1;
+
+    return 0;
+}
+
+/* Reopens the data file if it has been replaced (by another handle on the
+ * dataset) since this handle opened it
+ */
+static herr_t
+reopen_replaced_data_file(struct tutorial_object *obj)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    struct stat              held;
+    struct stat              current;
+    char                     name[NAME_MAX + 1];
+
+    if (NULL == obj->file->journal || NULL == dset->data_file)
+        return 0;
+
+    snprintf(name, sizeof(name), "%s.%s", base_name(obj->name), DATA_EXT);
+    if (fstat(fileno(dset->data_file), &held) < 0 || fstatat(dset->dir_fd, name, &current, 0) < 0)
+        return -1;
+    if (held.st_ino == current.st_ino && held.st_dev == current.st_dev)
+        return 0;
+
+    fclose(dset->data_file);
+
+    return open_data_file(obj, "r+");
+}
+
+static void
+init_data_header(const struct tutorial_dataset *dset, struct data_header *hdr)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, DATA_MAGIC, sizeof(hdr->magic));
+    hdr->version    = DATA_VERSION;
+    hdr->byte_order = (uint8_t)dset->type.order;
+    hdr->elem_size  = (uint32_t)dset->type.size;
+}
+
+static herr_t
+write_data_header(struct tutorial_object *obj)
+{
+    struct data_header       hdr;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    init_data_header(dset, &hdr);
+
+    if (pwrite(fileno(dset->data_file), &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+        return -1;
+
+    return 0;
+}
+
+static enum tutorial_data_format
+detect_data_format(struct tutorial_object *obj)
+{
+    struct data_header       hdr;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    /* An empty file or one without the magic number is a legacy text file */
+    if (pread(fileno(dset->data_file), &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+        return TUTORIAL_DATA_FORMAT_TEXT;
+    if (memcmp(hdr.magic, DATA_MAGIC, sizeof(hdr.magic)) != 0)
+        return TUTORIAL_DATA_FORMAT_TEXT;
+
+    /* The elements are in whatever order the writer used. Conversion to the
+     * memory type takes care of swapping them.
+     */
+    if (H5T_ORDER_LE == hdr.byte_order || H5T_ORDER_BE == hdr.byte_order)
+        dset->type.order = (H5T_order_t)hdr.byte_order;
+
+    return TUTORIAL_DATA_FORMAT_BINARY;
+}
+
+static void
+unmap_data_file(struct tutorial_object *obj)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    if (dset->map) {
+        munmap(dset->map, dset->map_size);
+        dset->map      = NULL;
+        dset->map_size = 0;
+    }
+}
+
+static herr_t
+map_data_file(struct tutorial_object *obj, size_t size)
+{
+    int                      fd;
+    struct stat              st;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    /* Resize the file to the requested size (0 means keep the current size).
+     * If that fails, the current mapping still matches the file.
+     */
+    fd = fileno(dset->data_file);
+    if (fstat(fd, &st) != 0)
+        return -1;
+    if (size) {
+        if ((size_t)st.st_size != size && ftruncate(fd, (off_t)size) < 0)
+            return -1;
+    }
+    else
+        size = (size_t)st.st_size;
+
+    unmap_data_file(obj);
+
+    /* Empty files can't be mapped */
+    if (0 == size)
+        return 0;
+
+    dset->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == dset->map) {
+        /* Fall back to stdio */
+        dset->map      = NULL;
+        dset->use_mmap = false;
+        return 0;
+    }
+    dset->map_size = size;
+
+    return 0;
+}
+
+static herr_t
+write_data_mapped(struct tutorial_object *obj, hsize_t n, const void *data)
+{
+    struct data_header       hdr;
+    struct tutorial_dataset *dset  = &(obj->data.dataset);
+    size_t                   es    = dset->type.size;
+    char *                   elmts = NULL;
+
+    /* Size the file (and the mapping) to hold exactly n elements */
+    if (map_data_file(obj, sizeof(struct data_header) + (size_t)n * es) < 0)
+        return -1;
+    if (!dset->map)
+        return 0;
+
+    init_data_header(dset, &hdr);
+    memcpy(dset->map, &hdr, sizeof(hdr));
+
+    elmts = (char *)dset->map + sizeof(struct data_header);
+    if (data)
+        memcpy(elmts, data, (size_t)n * es);
+    else {
+        /* Special initial dataset fill value case */
+        fill_elements(elmts, (size_t)n, dset->fillval, es);
+    }
+
+    return 0;
+}
+
+/* The number of parts to split nbytes of I/O into, one per thread as long
+ * as each part gets at least PARALLEL_PART_BYTES
+ */
+static size_t
+parallel_parts(const struct tutorial_file *f, hsize_t nbytes)
+{
+    hsize_t n = nbytes / PARALLEL_PART_BYTES;
+
+    if (n < 1)
+        return 1;
+
+    return n < pool_threads(f) ? (size_t)n : pool_threads(f);
+}
+
+/* Reads nbytes at file_off of the element array, filling anything past the
+ * end of the file with the fill value.
+ */
+static herr_t
+read_span(struct tutorial_object *obj, hsize_t file_off, void *mem, size_t nbytes)
+{
+    struct tutorial_dataset *dset   = &(obj->data.dataset);
+    size_t                   stored = 0;
+
+    if (dset->use_mmap) {
+        /* Copy out of the mapping */
+        size_t avail = 0;
+
+        if (dset->map_size > sizeof(struct data_header) + file_off)
+            avail = dset->map_size - sizeof(struct data_header) - (size_t)file_off;
+        stored = nbytes < avail ? nbytes : avail;
+
+        if (stored)
+            memcpy(mem, (char *)dset->map + sizeof(struct data_header) + file_off, stored);
+    }
+    else {
+        int fd = fileno(dset->data_file);
+
+        /* Only the end of the file stops a read short */
+        while (stored < nbytes) {
+            ssize_t nread = pread(fd, (char *)mem + stored, nbytes - stored,
+                                  (off_t)(sizeof(struct data_header) + file_off + stored));
+
+            if (nread < 0)
+                return -1;
+            if (0 == nread)
+                break;
+            stored += (size_t)nread;
+        }
+    }
+
+    stored -= stored % dset->type.size;
+    fill_elements((char *)mem + stored, (nbytes - stored) / dset->type.size, dset->fillval, dset->type.size);
+
+    return 0;
+}
+
+/* Writes nbytes at file_off of the element array */
+static herr_t
+write_span(struct tutorial_object *obj, hsize_t file_off, const void *mem, size_t nbytes)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    hsize_t                  off  = sizeof(struct data_header) + file_off;
+
+    if (dset->use_mmap) {
+        /* The mapping was sized to the extent before the write started */
+        if (off + nbytes > dset->map_size)
+            return -1;
+        memcpy((char *)dset->map + off, mem, nbytes);
+    }
+    else if (pwrite(fileno(dset->data_file), mem, nbytes, (off_t)off) != (ssize_t)nbytes)
+        return -1;
+
+    return 0;
+}
+
+/* Writes the fill value to nbytes at file_off of the element array (which
+ * starts on an element boundary)
+ */
+static herr_t
+fill_span(struct tutorial_object *obj, hsize_t file_off, size_t nbytes)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    char                     fillbuf[FILL_BUF_NELMTS * TUTORIAL_MAX_TYPE_SIZE];
+    size_t                   done = 0;
+
+    /* The fill buffer holds whole elements, so writes of it that start on
+     * an element boundary stay aligned.
+     */
+    fill_elements(fillbuf, FILL_BUF_NELMTS, dset->fillval, dset->type.size);
+
+    while (done < nbytes) {
+        size_t count = nbytes - done;
+
+        if (count > FILL_BUF_NELMTS * dset->type.size)
+            count = FILL_BUF_NELMTS * dset->type.size;
+        if (write_span(obj, file_off + done, fillbuf, count) < 0)
+            return -1;
+        done += count;
+    }
+
+    return 0;
+}
+
+/* A span of the element array, split into parts for the file's threads */
+struct span_job {
+    struct tutorial_object *obj;
+    hsize_t                 file_off;
+    char *                  mem; /* NULL to write the fill value */
+    hsize_t                 nbytes;
+    hsize_t                 part_bytes; /* A whole number of elements */
+    hbool_t                 write;
+};
+
+static herr_t
+span_part(size_t part, void *job_data)
+{
+    struct span_job *job   = (struct span_job *)job_data;
+    hsize_t          start = (hsize_t)part * job->part_bytes;
+    size_t           len   = (size_t)(job->nbytes - start < job->part_bytes ? job->nbytes - start : job->part_bytes);
+
+    if (!job->write)
+        return read_span(job->obj, job->file_off + start, job->mem + start, len);
+    if (job->mem)
+        return write_span(job->obj, job->file_off + start, job->mem + start, len);
+
+    return fill_span(job->obj, job->file_off + start, len);
+}
+
+/* Reads or writes (or fills, when mem is NULL) nbytes at file_off of the
+ * element array, in parallel when that's worth it
+ */
+static herr_t
+transfer_span(struct tutorial_object *obj, hsize_t file_off, void *mem, hsize_t nbytes, hbool_t write)
+{
+    struct span_job job;
+    size_t          es     = obj->data.dataset.type.size;
+    size_t          nparts = parallel_parts(obj->file, nbytes);
+
+    if (0 == nbytes)
+        return 0;
+
+    job.obj        = obj;
+    job.file_off   = file_off;
+    job.mem        = (char *)mem;
+    job.nbytes     = nbytes;
+    job.part_bytes = (nbytes / nparts + es - 1) / es * es;
+    job.write      = write;
+
+    nparts = (size_t)((nbytes + job.part_bytes - 1) / job.part_bytes);
+
+    return run_parallel(obj->file, nparts, span_part, &job);
+}
+
+/* One block of elements per part, encoded as text */
+struct encode_job {
+    const struct tutorial_type *type;
+    const char *                elmts; /* NULL for the fill value */
+    const char *                fill;  /* A block of fill values */
+    hsize_t                     first; /* The first element of part 0 */
+    hsize_t                     n;     /* The number of elements in all */
+    char **                     text;
+    size_t *                    len;
+};
+
+static herr_t
+encode_part(size_t part, void *job_data)
+{
+    struct encode_job *job   = (struct encode_job *)job_data;
+    hsize_t            start = job->first + (hsize_t)part * TEXT_BLOCK_NELMTS;
+    size_t             count = (job->n - start) < TEXT_BLOCK_NELMTS ? (size_t)(job->n - start) : TEXT_BLOCK_NELMTS;
+    const char *       src   = job->elmts ? job->elmts + start * job->type->size : job->fill;
+
+    job->len[part] = encode_text(job->type, src, count, job->text[part]);
+
+    return 0;
+}
+
+/* Writes n elements of the dataset's type as text, one per line. Each
+ * thread encodes a block at a time, and each block is written in one call.
+ */
+static herr_t
+write_text_elements(struct tutorial_object *obj, hsize_t n, const void *data)
+{
+    struct tutorial_dataset *dset    = &(obj->data.dataset);
+    size_t                   es      = dset->type.size;
+    struct encode_job        job;
+    size_t                   nblocks = pool_threads(obj->file);
+    char *                   fill    = NULL;
+    off_t                    off     = 0;
+    herr_t                   ret     = 0;
+
+    /* No more buffers than there are blocks */
+    if (nblocks > (n + TEXT_BLOCK_NELMTS - 1) / TEXT_BLOCK_NELMTS)
+        nblocks = (size_t)((n + TEXT_BLOCK_NELMTS - 1) / TEXT_BLOCK_NELMTS);
+
+    job.type  = &(dset->type);
+    job.elmts = (const char *)data;
+    job.n     = n;
+    job.text  = calloc(nblocks, sizeof(char *));
+    job.len   = calloc(nblocks, sizeof(size_t));
+    for (size_t i = 0; i < nblocks; i++)
+        job.text[i] = malloc(TEXT_BLOCK_NELMTS * TEXT_MAX_ELMT_LEN);
+
+    /* Special initial dataset fill value case */
+    if (!data) {
+        fill = malloc(TEXT_BLOCK_NELMTS * es);
+        fill_elements(fill, TEXT_BLOCK_NELMTS, dset->fillval, es);
+    }
+    job.fill = fill;
+
+    for (hsize_t i = 0; i < n && ret >= 0; i += (hsize_t)nblocks * TEXT_BLOCK_NELMTS) {
+        size_t count = (size_t)((n - i + TEXT_BLOCK_NELMTS - 1) / TEXT_BLOCK_NELMTS);
+
+        job.first = i;
+        ret       = run_parallel(obj->file, count < nblocks ? count : nblocks, encode_part, &job);
+
+        for (size_t b = 0; b < count && b < nblocks && ret >= 0; b++) {
+            if (pwrite(fileno(dset->data_file), job.text[b], job.len[b], off) != (ssize_t)job.len[b])
+                ret = -1;
+            off += (off_t)job.len[b];
+        }
+    }
+
+    for (size_t i = 0; i < nblocks; i++)
+        free(job.text[i]);
+    free(job.text);
+    free(job.len);
+    free(fill);
+
+    return ret;
+}
+
+/* Text split at token boundaries into parts that are decoded in parallel.
+ * Counting each part's tokens first says where its elements go.
+ */
+struct decode_job {
+    const struct tutorial_type *type;
+    const char *                text;
+    size_t *                    bounds; /* Part i is text[bounds[i]] to text[bounds[i + 1] - 1] */
+    size_t *                    count;  /* Tokens in each part */
+    hsize_t *                   first;  /* Where each part's elements go */
+    size_t *                    got;    /* Elements decoded in each part */
+    hbool_t *                   malformed;
+    char *                      data;
+    hsize_t                     n;
+};
+
+static herr_t
+count_part(size_t part, void *job_data)
+{
+    struct decode_job *job = (struct decode_job *)job_data;
+
+    job->count[part] = count_text(job->text + job->bounds[part], job->bounds[part + 1] - job->bounds[part]);
+
+    return 0;
+}
+
+static herr_t
+decode_part(size_t part, void *job_data)
+{
+    struct decode_job *job   = (struct decode_job *)job_data;
+    hsize_t            first = job->first[part];
+    size_t             used  = 0;
+
+    job->got[part]       = 0;
+    job->malformed[part] = false;
+    if (first >= job->n)
+        return 0;
+
+    job->got[part] = decode_text(job->type, job->text + job->bounds[part],
+                                 job->bounds[part + 1] - job->bounds[part], job->data + first * job->type->size,
+                                 (size_t)(job->n - first), &used, &(job->malformed[part]));
+
+    return 0;
+}
+
+/* Parses up to n elements of the dataset's type from a text data file, a
+ * buffer of TEXT_BUF_SIZE per thread at a time. Sets *stored to the number
+ * of elements that were there.
+ */
+static herr_t
+read_text_elements(struct tutorial_object *obj, hsize_t n, void *data, hsize_t *stored)
+{
+    struct tutorial_dataset *dset     = &(obj->data.dataset);
+    size_t                   nthreads = pool_threads(obj->file);
+    size_t                   size     = nthreads * TEXT_BUF_SIZE;
+    struct decode_job        job;
+    char *                   text = NULL;
+    size_t                   have = 0;
+    off_t                    off  = 0;
+    hsize_t                  done = 0;
+    hbool_t                  eof  = false;
+    hbool_t                  stop = false;
+    herr_t                   ret  = 0;
+
+    /* One extra byte for the newline that ends the last token */
+    text = malloc(size + 1);
+
+    job.type      = &(dset->type);
+    job.text      = text;
+    job.bounds    = malloc((nthreads + 1) * sizeof(size_t));
+    job.count     = malloc(nthreads * sizeof(size_t));
+    job.first     = malloc(nthreads * sizeof(hsize_t));
+    job.got       = malloc(nthreads * sizeof(size_t));
+    job.malformed = malloc(nthreads * sizeof(hbool_t));
+    job.data      = (char *)data;
+    job.n         = n;
+
+    while (done < n && !stop) {
+        size_t usable;
+        size_t nparts;
+
+        while (!eof && have < size) {
+            ssize_t nread = pread(fileno(dset->data_file), text + have, size - have, off);
+
+            if (nread < 0) {
+                ret = -1;
+                break;
+            }
+            if (0 == nread) {
+                eof          = true;
+                text[have++] = '\n';
+            }
+            else {
+                have += (size_t)nread;
+                off += nread;
+            }
+        }
+        if (ret < 0)
+            break;
+
+        /* Only whole tokens are decoded. Stop at the end of the file, or at
+         * a token too long to be a number.
+         */
+        usable = eof ? have : complete_text_len(text, have);
+        if (0 == usable)
+            break;
+
+        nparts = parallel_parts(obj->file, usable);
+
+        job.bounds[0]      = 0;
+        job.bounds[nparts] = usable;
+        for (size_t i = 1; i < nparts; i++) {
+            size_t pos = usable / nparts * i;
+
+            job.bounds[i] = skip_token(text, usable, pos > job.bounds[i - 1] ? pos : job.bounds[i - 1]);
+        }
+
+        if (nparts > 1)
+            run_parallel(obj->file, nparts, count_part, &job);
+
+        job.first[0] = done;
+        for (size_t i = 1; i < nparts; i++)
+            job.first[i] = job.first[i - 1] + job.count[i - 1];
+
+        run_parallel(obj->file, nparts, decode_part, &job);
+
+        /* Anything after a malformed token is ignored */
+        for (size_t i = 0; i < nparts && !stop; i++) {
+            if (job.first[i] >= n)
+                break;
+            done = job.first[i] + job.got[i];
+            stop = job.malformed[i];
+        }
+
+        memmove(text, text + usable, have - usable);
+        have -= usable;
+    }
+
+    free(job.bounds);
+    free(job.count);
+    free(job.first);
+    free(job.got);
+    free(job.malformed);
+    free(text);
+
+    *stored = done;
+
+    return ret;
+}
+
+static herr_t
+write_data(struct tutorial_object *obj, hsize_t n, const void *data)
+{
+    int                      fd;
+    struct tutorial_dataset *dset     = &(obj->data.dataset);
+    size_t                   es       = dset->type.size;
+    FILE *                   old_file = NULL;
+    herr_t                   ret      = 0;
+
+    if (dset->use_mmap) {
+        if (write_data_mapped(obj, n, data) < 0)
+            return -1;
+        if (dset->use_mmap)
+            return 0;
+    }
+
+    /* Write a replacement, with a journal, or truncate the file */
+    if (obj->file->journal) {
+        FILE *temp_file = NULL;
+
+        if ((fd = open_replacement(obj, DATA_EXT)) < 0)
+            return -1;
+        if (NULL == (temp_file = fdopen(fd, "r+"))) {
+            close(fd);
+            return -1;
+        }
+        old_file        = dset->data_file;
+        dset->data_file = temp_file;
+    }
+    else {
+        fd = fileno(dset->data_file);
+        if (ftruncate(fd, 0) < 0)
+            return -1;
+    }
+
+    if (TUTORIAL_DATA_FORMAT_BINARY == dset->format) {
+        /* No data is the special initial dataset fill value case */
+        if (write_data_header(obj) < 0 || transfer_span(obj, 0, (void *)data, n * es, true) < 0)
+            ret = -1;
+    }
+    else
+        ret = write_text_elements(obj, n, data);
+
+    /* Keep the old file if the replacement wasn't written in full or can't
+     * take its place
+     */
+    if (old_file) {
+        if (replace_file(obj, DATA_EXT, fd, ret) < 0) {
+            fclose(dset->data_file);
+            dset->data_file = old_file;
+            ret             = -1;
+        }
+        else {
+            fclose(old_file);
+            if (fsync(dset->dir_fd) < 0)
+                ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+static herr_t
+read_data(struct tutorial_object *obj, hsize_t n, void *data)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    size_t                   es   = dset->type.size;
+    hsize_t                  stored;
+
+    /* Anything past the end of the file reads as the fill value */
+    if (TUTORIAL_DATA_FORMAT_BINARY == dset->format)
+        return transfer_span(obj, 0, data, n * es, false);
+
+    if (read_text_elements(obj, n, data, &stored) < 0)
+        return -1;
+    fill_elements((char *)data + stored * es, (size_t)(n - stored), dset->fillval, es);
+
+    return 0;
+}
+
+static herr_t
+truncate_data(struct tutorial_object *obj, hsize_t n)
+{
+    int                      fd;
+    struct stat              st;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    size_t                   size = sizeof(struct data_header) + (size_t)n * dset->type.size;
+
+    /* Drops any elements past the first n from a binary data file */
+    fd = fileno(dset->data_file);
+    if (fstat(fd, &st) != 0)
+        return -1;
+    if ((size_t)st.st_size <= size)
+        return 0;
+
+    if (ftruncate(fd, (off_t)size) < 0)
+        return -1;
+
+    if (dset->use_mmap && map_data_file(obj, size) < 0)
+        return -1;
+
+    return 0;
+}
+
+/* The number of elements a binary data file of size bytes completely holds */
+static hsize_t
+stored_nelmts(const struct tutorial_dataset *dset, off_t size)
+{
+    if ((size_t)size <= sizeof(struct data_header))
+        return 0;
+
+    return ((size_t)size - sizeof(struct data_header)) / dset->type.size;
+}
+
+/* Whether growing a binary data file writes fill values into the gap */
+static hbool_t
+fills_gaps(const struct tutorial_dataset *dset)
+{
+    return !fillval_is_zero(dset) && !dset->fill_never;
+}
+
+static herr_t
+extend_data(struct tutorial_object *obj, hsize_t n, hbool_t overwrite)
+{
+    int                      fd;
+    struct stat              st;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    size_t                   size = sizeof(struct data_header) + (size_t)n * dset->type.size;
+
+    /* Makes sure a binary data file holds at least n elements. Storage is
+     * only allocated as far as something has been written, so this is where
+     * the gap between the old end of the file and a write gets its fill
+     * values. The gap is left as a hole when the caller is about to
+     * overwrite all of it, when the fill value is all zero bytes (holes
+     * read back as zeros), or when fill values are never written.
+     */
+    fd = fileno(dset->data_file);
+    if (fstat(fd, &st) != 0)
+        return -1;
+    if ((size_t)st.st_size >= size)
+        return 0;
+
+    /* Grow the file (and the mapping, which is kept in step with it) */
+    if (dset->use_mmap ? map_data_file(obj, size) < 0 : ftruncate(fd, (off_t)size) < 0)
+        return -1;
+
+    /* Fill from the first element the file didn't completely hold */
+    if (!overwrite && fills_gaps(dset)) {
+        hsize_t first = stored_nelmts(dset, st.st_size);
+
+        return transfer_span(obj, first * dset->type.size, NULL, (n - first) * dset->type.size, true);
+    }
+
+    return 0;
+}
+
+/**************/
+/* SELECTIONS */
+/**************/
+
+/* A run of elements that is contiguous in both the file and memory
+ * selections. Offsets and sizes are in bytes. File offsets are into the
+ * row-major element array, not counting the data file header.
+ */
+struct io_seg {
+    hsize_t file_off;
+    hsize_t mem_off;
+    size_t  len;
+};
+
+/* Callback for a batch of segments, in selection order */
+typedef herr_t (*selection_op_t)(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs,
+                                 void *buf, void *op_data);
+
+/* Paired file and memory selections. They're walked with the library as
+ * they're used, or flattened into segments beforehand so that they can be
+ * used on a background thread.
+ */
+struct selection {
+    hid_t          file_space_id;
+    hid_t          mem_space_id;
+    size_t         elmt_size;
+    hbool_t        flat;
+    struct io_seg *segs;
+    size_t         nsegs;
+    size_t         max_segs;
+};
+
+/* A batch of sequences pulled from a selection iterator */
+struct seq_list {
+    hid_t   iter_id;
+    size_t  nseq;
+    size_t  cur;
+    hsize_t off[SEQ_LIST_LEN];
+    size_t  len[SEQ_LIST_LEN];
+};
+
+/* Returns 1 when a sequence was produced, 0 when the selection is exhausted */
+static int
+next_seq(struct seq_list *sl, hsize_t *off, size_t *len)
+{
+    if (sl->cur == sl->nseq) {
+        size_t nbytes = 0;
+
+        if (H5Ssel_iter_get_seq_list(sl->iter_id, SEQ_LIST_LEN, SIZE_MAX, &sl->nseq, &nbytes, sl->off,
+                                     sl->len) < 0)
+            return -1;
+        sl->cur = 0;
+        if (0 == sl->nseq)
+            return 0;
+    }
+
+    *off = sl->off[sl->cur];
+    *len = sl->len[sl->cur];
+    sl->cur++;
+
+    return 1;
+}
+
+/* Walks the file and memory selections in lockstep (in selection order, so
+ * the Nth selected file element pairs with the Nth selected memory element)
+ * and hands op batches of runs that are contiguous in both.
+ */
+static herr_t
+walk_selections(struct tutorial_object *obj, hid_t file_space_id, hid_t mem_space_id, size_t elmt_size,
+                void *buf, selection_op_t op, void *op_data)
+{
+    struct seq_list *fsl   = NULL;
+    struct seq_list *msl   = NULL;
+    struct io_seg *  segs  = NULL;
+    size_t           nsegs = 0;
+    hsize_t          foff  = 0;
+    hsize_t          moff  = 0;
+    size_t           flen  = 0;
+    size_t           mlen  = 0;
+    herr_t           ret   = 0;
+
+    fsl  = calloc(1, sizeof(struct seq_list));
+    msl  = calloc(1, sizeof(struct seq_list));
+    segs = malloc(SEQ_LIST_LEN * sizeof(struct io_seg));
+
+    fsl->iter_id = H5Ssel_iter_create(file_space_id, elmt_size, 0);
+    msl->iter_id = H5Ssel_iter_create(mem_space_id, elmt_size, 0);
+    if (fsl->iter_id < 0 || msl->iter_id < 0) {
+        ret = -1;
+        goto done;
+    }
+
+    for (;;) {
+        size_t nbytes;
+        int    status;
+
+        if (0 == flen && (status = next_seq(fsl, &foff, &flen)) <= 0) {
+            ret = status;
+            break;
+        }
+        if (0 == mlen && (status = next_seq(msl, &moff, &mlen)) <= 0) {
+            ret = status;
+            break;
+        }
+
+        nbytes = flen < mlen ? flen : mlen;
+
+        segs[nsegs].file_off = foff;
+        segs[nsegs].mem_off  = moff;
+        segs[nsegs].len      = nbytes;
+        if (++nsegs == SEQ_LIST_LEN) {
+            if (op(obj, segs, nsegs, buf, op_data) < 0) {
+                ret = -1;
+                break;
+            }
+            nsegs = 0;
+        }
+
+        foff += nbytes;
+        flen -= nbytes;
+        moff += nbytes;
+        mlen -= nbytes;
+    }
+
+    if (ret >= 0 && nsegs)
+        ret = op(obj, segs, nsegs, buf, op_data);
+
+done:
+    if (fsl->iter_id >= 0)
+        H5Ssel_iter_close(fsl->iter_id);
+    if (msl->iter_id >= 0)
+        H5Ssel_iter_close(msl->iter_id);
+    free(fsl);
+    free(msl);
+    free(segs);
+
+    return ret;
+}
+
+static herr_t
+append_segs_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf, void *op_data)
+{
+    struct selection *sel = (struct selection *)op_data;
+
+    if (sel->nsegs + nsegs > sel->max_segs) {
+        sel->max_segs = MAX(2 * sel->max_segs, sel->nsegs + nsegs);
+        sel->segs     = realloc(sel->segs, sel->max_segs * sizeof(struct io_seg));
+    }
+    memcpy(sel->segs + sel->nsegs, segs, nsegs * sizeof(struct io_seg));
+    sel->nsegs += nsegs;
+
+    return 0;
+}
+
+/* Turns the selection into a list of segments, so it no longer depends on
+ * the dataspaces (or on the library)
+ */
+static herr_t
+flatten_selection(struct selection *sel)
+{
+    if (sel->flat)
+        return 0;
+
+    if (walk_selections(NULL, sel->file_space_id, sel->mem_space_id, sel->elmt_size, NULL, append_segs_op,
+                        sel) < 0)
+        return -1;
+
+    sel->flat          = true;
+    sel->file_space_id = H5I_INVALID_HID;
+    sel->mem_space_id  = H5I_INVALID_HID;
+
+    return 0;
+}
+
+/* Hands op the selection's segments, in batches */
+static herr_t
+iterate_selections(struct tutorial_object *obj, const struct selection *sel, void *buf, selection_op_t op,
+                   void *op_data)
+{
+    if (!sel->flat)
+        return walk_selections(obj, sel->file_space_id, sel->mem_space_id, sel->elmt_size, buf, op, op_data);
+
+    for (size_t i = 0; i < sel->nsegs; i += SEQ_LIST_LEN) {
+        size_t n = sel->nsegs - i < SEQ_LIST_LEN ? sel->nsegs - i : SEQ_LIST_LEN;
+
+        if (op(obj, sel->segs + i, n, buf, op_data) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* A flattened selection cut into parts of about the same number of bytes */
+struct selection_job {
+    struct tutorial_object *obj;
+    struct io_seg *         segs;
+    size_t *                starts; /* Part i is segs[starts[i]] to segs[starts[i + 1] - 1] */
+    void *                  buf;
+    selection_op_t          op;
+    void *                  op_data;
+};
+
+static herr_t
+selection_part(size_t part, void *job_data)
+{
+    struct selection_job *job = (struct selection_job *)job_data;
+
+    return job->op(job->obj, job->segs + job->starts[part], job->starts[part + 1] - job->starts[part], job->buf,
+                   job->op_data);
+}
+
+/* Like iterate_selections(), but a large selection (of nbytes in all) is cut
+ * into parts that op handles in parallel. op must cope with running on
+ * different segments at the same time.
+ */
+static herr_t
+iterate_selections_parallel(struct tutorial_object *obj, const struct selection *sel, hsize_t nbytes, void *buf,
+                            selection_op_t op, void *op_data)
+{
+    struct selection     flat    = *sel;
+    struct selection_job job;
+    size_t               nparts  = parallel_parts(obj->file, nbytes);
+    size_t               es      = sel->elmt_size;
+    hsize_t              part_bytes;
+    hsize_t              in_part = 0;
+    size_t               part    = 0;
+    size_t               n       = 0;
+    herr_t               ret     = 0;
+
+    if (nparts < 2)
+        return iterate_selections(obj, sel, buf, op, op_data);
+
+    /* All the segments are needed to cut them up */
+    if (!sel->flat) {
+        flat.segs     = NULL;
+        flat.nsegs    = 0;
+        flat.max_segs = 0;
+        if (flatten_selection(&flat) < 0) {
+            free(flat.segs);
+            return -1;
+        }
+    }
+
+    /* Cut segments at the part boundaries (between elements), which adds
+     * at most one segment per part. The last part takes whatever is left.
+     */
+    part_bytes = (nbytes / nparts + es - 1) / es * es;
+
+    job.obj       = obj;
+    job.segs      = malloc((flat.nsegs + nparts) * sizeof(struct io_seg));
+    job.starts    = malloc((nparts + 1) * sizeof(size_t));
+    job.buf       = buf;
+    job.op        = op;
+    job.op_data   = op_data;
+    job.starts[0] = 0;
+
+    for (size_t i = 0; i < flat.nsegs; i++) {
+        struct io_seg seg = flat.segs[i];
+
+        while (seg.len > 0) {
+            size_t take = seg.len;
+
+            if (part + 1 < nparts && take > part_bytes - in_part)
+                take = (size_t)(part_bytes - in_part);
+
+            job.segs[n].file_off = seg.file_off;
+            job.segs[n].mem_off  = seg.mem_off;
+            job.segs[n].len      = take;
+            n++;
+
+            seg.file_off += take;
+            seg.mem_off += take;
+            seg.len -= take;
+            in_part += take;
+
+            if (part + 1 < nparts && in_part == part_bytes) {
+                job.starts[++part] = n;
+                in_part            = 0;
+            }
+        }
+    }
+    while (part < nparts)
+        job.starts[++part] = n;
+
+    ret = run_parallel(obj->file, nparts, selection_part, &job);
+
+    free(job.segs);
+    free(job.starts);
+    if (!sel->flat)
+        free(flat.segs);
+
+    return ret;
+}
+
+static herr_t
+read_elements_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf,
+                 void *op_data)
+{
+    struct tutorial_dataset *dset    = &(obj->data.dataset);
+    char *                   scratch = NULL;
+    size_t                   i       = 0;
+    herr_t                   ret     = 0;
+
+    while (i < nsegs && ret >= 0) {
+        hsize_t start = segs[i].file_off;
+        hsize_t end   = segs[i].file_off + segs[i].len;
+        size_t  j     = i + 1;
+
+        /* Row-major runs of a tile (or of a strided selection) sit close
+         * together in the file. Cover nearby runs with a single read so a
+         * 2D window costs a handful of preads instead of one per row.
+         */
+        if (!dset->use_mmap)
+            while (j < nsegs && segs[j].file_off >= end && segs[j].file_off - end <= COALESCE_GAP &&
+                   segs[j].file_off + segs[j].len - start <= COALESCE_MAX) {
+                end = segs[j].file_off + segs[j].len;
+                j++;
+            }
+
+        if (j == i + 1)
+            ret = read_span(obj, segs[i].file_off, (char *)buf + segs[i].mem_off, segs[i].len);
+        else {
+            if (!scratch)
+                scratch = malloc(COALESCE_MAX);
+            ret = read_span(obj, start, scratch, (size_t)(end - start));
+            for (size_t k = i; k < j; k++)
+                memcpy((char *)buf + segs[k].mem_off, scratch + (segs[k].file_off - start), segs[k].len);
+        }
+
+        i = j;
+    }
+
+    free(scratch);
+
+    return ret;
+}
+
+static herr_t
+write_elements_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf,
+                  void *op_data)
+{
+    /* The elements are already in the stored type and byte order. Only the
+     * selected bytes are written to the file.
+     */
+    for (size_t i = 0; i < nsegs; i++)
+        if (write_span(obj, segs[i].file_off, (char *)buf + segs[i].mem_off, segs[i].len) < 0)
+            return -1;
+
+    return 0;
+}
+
+/* Writes a dataset's runs from the file's write buffer. The data file is
+ * extended first, as far as the furthest run, as the writes themselves
+ * would have done.
+ */
+static herr_t
+write_buffered(struct tutorial_object *obj, const struct tutorial_wb_run *runs, size_t nruns,
+               const char *data)
+{
+    hsize_t end = 0;
+
+    if (reopen_replaced_data_file(obj) < 0)
+        return -1;
+
+    for (size_t i = 0; i < nruns; i++)
+        end = MAX(end, runs[i].file_off + runs[i].len);
+    if (extend_data(obj, end / obj->data.dataset.type.size, false) < 0)
+        return -1;
+
+    for (size_t i = 0; i < nruns; i++) {
+        if (write_span(obj, runs[i].file_off, data, runs[i].len) < 0)
+            return -1;
+        data += runs[i].len;
+    }
+
+    return 0;
+}
+
+/* Logs a dataset's runs from the file's write buffer in the journal, as
+ * writes to its data file. The fill write_buffered() puts between the end
+ * of the data file and the runs is logged ahead of them, or replaying runs
+ * past the end of the file would leave a hole there.
+ */
+static herr_t
+log_buffered(struct tutorial_object *obj, const struct tutorial_wb_run *runs, size_t nruns, const char *data)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    size_t                   es   = dset->type.size;
+    char                     path[PATH_MAX];
+
+    /* Journal paths are relative to the file, and every object's path
+     * starts with the root group's
+     */
+    if ((size_t)snprintf(path, sizeof(path), "%s/%s.%s", obj->path + strlen(obj->file->root->path) + 1,
+                         base_name(obj->name), DATA_EXT) >= sizeof(path))
+        return -1;
+
+    if (fills_gaps(dset)) {
+        struct stat st;
+        hsize_t     end = 0;
+        hsize_t     first;
+
+        if (reopen_replaced_data_file(obj) < 0 || fstat(fileno(dset->data_file), &st) < 0)
+            return -1;
+
+        for (size_t i = 0; i < nruns; i++)
+            end = MAX(end, runs[i].file_off + runs[i].len);
+        first = stored_nelmts(dset, st.st_size);
+        if (end / es > first)
+            journal_add_fill(obj->file, path, sizeof(struct data_header) + first * es,
+                             (end / es - first) * es, dset->fillval, es);
+    }
+
+    for (size_t i = 0; i < nruns; i++) {
+        journal_add(obj->file, path, sizeof(struct data_header) + runs[i].file_off, data, runs[i].len);
+        data += runs[i].len;
+    }
+
+    return 0;
+}
+
+static const struct tutorial_wb_class buffered_class = {log_buffered, write_buffered};
+
+/* Big writes (which only a file with a journal buffers) go into the write
+ * buffer a buffer's worth at a time, draining it in between, so neither the
+ * buffer nor the journal's next transaction ever holds all of them
+ */
+static herr_t
+buffer_elements_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf,
+                   void *op_data)
+{
+    size_t es    = obj->data.dataset.type.size;
+    size_t piece = MAX(es, obj->file->write_buffer_size / es * es);
+
+    for (size_t i = 0; i < nsegs; i++)
+        for (size_t done = 0; done < segs[i].len; done += piece) {
+            size_t len = MIN(segs[i].len - done, piece);
+
+            buffer_write(obj, segs[i].file_off + done, (char *)buf + segs[i].mem_off + done, len,
+                         &buffered_class);
+            if (check_write_buffer(obj->file) < 0)
+                return -1;
+        }
+
+    return 0;
+}
+
+static herr_t
+copy_from_array_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf,
+                   void *op_data)
+{
+    for (size_t i = 0; i < nsegs; i++)
+        memcpy((char *)buf + segs[i].mem_off, (char *)op_data + segs[i].file_off, segs[i].len);
+
+    return 0;
+}
+
+static herr_t
+copy_to_array_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf,
+                 void *op_data)
+{
+    for (size_t i = 0; i < nsegs; i++)
+        memcpy((char *)op_data + segs[i].file_off, (char *)buf + segs[i].mem_off, segs[i].len);
+
+    return 0;
+}
+
+/**********/
+/* CHUNKS */
+/**********/
+
+/* A chunk held in memory for the duration of one read or write */
+struct chunk_slot {
+    hsize_t coords[H5S_MAX_RANK]; /* In chunks, not elements */
+    char *  data;
+    hbool_t dirty;
+};
+
+/* A run of elements within one chunk, for chunks handled in parallel */
+struct chunk_run {
+    hsize_t chunk;    /* Row-major index of the chunk */
+    size_t  seq;      /* Position in the selection, to keep runs in order */
+    hsize_t in_chunk; /* Offset of the first element in the chunk */
+    hsize_t mem_off;  /* In bytes */
+    size_t  n;        /* Number of elements */
+};
+
+struct chunk_io {
+    hbool_t           write;
+    size_t            nslots;
+    size_t            next_evict;
+    struct chunk_slot slots[CHUNK_CACHE_NSLOTS];
+
+    /* Runs are collected instead of copied when the chunks are handled in
+     * parallel
+     */
+    hbool_t           collect;
+    struct chunk_run *runs;
+    size_t            nruns;
+    size_t            max_runs;
+};
+
+static size_t
+chunk_nbytes(const struct tutorial_dataset *dset)
+{
+    hsize_t n = 1;
+
+    for (int i = 0; i < dset->rank; i++)
+        n *= dset->chunk_dims[i];
+
+    return (size_t)n * dset->type.size;
+}
+
+/* The number of chunks along dimension d */
+static hsize_t
+chunks_in_dim(const struct tutorial_dataset *dset, int d)
+{
+    return (dset->dims[d] + dset->chunk_dims[d] - 1) / dset->chunk_dims[d];
+}
+
+/* Big enough for a chunk file's extension */
+#define CHUNK_EXT_SIZE (16 + H5S_MAX_RANK * 21)
+
+/* A chunk's file is <name>.chunk.<c0>.<c1>... in the dataset's directory.
+ * This fills in everything after <name>.
+ */
+static void
+make_chunk_ext(const struct tutorial_dataset *dset, const hsize_t *coords, char *ext)
+{
+    char *ptr = ext;
+
+    ptr += sprintf(ptr, CHUNK_EXT);
+    for (int i = 0; i < dset->rank; i++)
+        ptr += sprintf(ptr, ".%" PRIuHSIZE, coords[i]);
+}
+
+static int
+open_chunk_file(struct tutorial_object *obj, const hsize_t *coords, int flags)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    char                     ext[CHUNK_EXT_SIZE];
+
+    make_chunk_ext(dset, coords, ext);
+
+    return open_at(dset->dir_fd, base_name(obj->name), ext, flags);
+}
+
+/* Reads and unfilters the rest of a chunk's file, after its header, into
+ * data, which holds *nbytes. On return, *nbytes is the number of bytes it
+ * held. Fails if the file can't be read or doesn't decode.
+ */
+static herr_t
+load_filtered_chunk(int fd, unsigned filters, size_t elmt_size, char *data, size_t *nbytes)
+{
+    struct stat st;
+    char *      buf  = NULL;
+    size_t      size = 0;
+    herr_t      ret  = 0;
+
+    if (fstat(fd, &st) < 0 || st.st_size <= (off_t)sizeof(struct data_header))
+        return -1;
+
+    size = (size_t)st.st_size - sizeof(struct data_header);
+    if (NULL == (buf = malloc(size)) ||
+        pread(fd, buf, size, (off_t)sizeof(struct data_header)) != (ssize_t)size ||
+        decode_chunk(filters, elmt_size, buf, size, data, nbytes) < 0)
+        ret = -1;
+
+    free(buf);
+
+    return ret;
+}
+
+/* Reads a chunk into data, with the fill value for elements it doesn't
+ * hold (all of them, for a chunk that was never written). Fails if the
+ * chunk's file is there but can't be read.
+ */
+static herr_t
+load_chunk(struct tutorial_object *obj, const hsize_t *coords, char *data)
+{
+    struct tutorial_dataset *dset   = &(obj->data.dataset);
+    struct data_header       hdr;
+    size_t                   nbytes = chunk_nbytes(dset);
+    size_t                   stored = 0;
+    herr_t                   ret    = 0;
+    int                      fd;
+
+    /* Chunks that were never written don't exist on disk */
+    if ((fd = open_chunk_file(obj, coords, O_RDONLY)) < 0) {
+        if (ENOENT != errno)
+            return -1;
+    }
+    else {
+        if (pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+            ret = -1;
+        else if (hdr.filters) {
+            size_t size = nbytes;
+
+            if (load_filtered_chunk(fd, hdr.filters, dset->type.size, data, &size) < 0)
+                ret = -1;
+            else
+                stored = size / dset->type.size;
+        }
+        else {
+            ssize_t nread = pread(fd, data, nbytes, (off_t)sizeof(hdr));
+
+            if (nread < 0)
+                ret = -1;
+            else
+                stored = (size_t)nread / dset->type.size;
+        }
+
+        /* Keep the whole dataset in one byte order */
+        if (ret >= 0 && hdr.byte_order != (uint8_t)dset->type.order)
+            swap_elements(data, stored, dset->type.size);
+
+        close(fd);
+    }
+
+    if (ret < 0)
+        return -1;
+
+    fill_elements(data + stored * dset->type.size, nbytes / dset->type.size - stored, dset->fillval,
+                  dset->type.size);
+
+    return 0;
+}
+
+static herr_t
+store_chunk(struct tutorial_object *obj, const hsize_t *coords, const char *data)
+{
+    struct tutorial_dataset *dset    = &(obj->data.dataset);
+    struct data_header       hdr;
+    herr_t                   ret     = 0;
+    size_t                   size    = chunk_nbytes(dset);
+    void *                   encoded = NULL;
+    char                     ext[CHUNK_EXT_SIZE];
+    int                      fd;
+
+    init_data_header(dset, &hdr);
+
+    /* Chunks the filters don't shrink are stored as they are */
+    encoded = encode_chunk(dset->filters, dset->deflate_level, dset->type.size, data, size, &size);
+    if (encoded) {
+        hdr.filters = (uint16_t)dset->filters;
+        data        = encoded;
+    }
+
+    /* With a journal, the chunk's file is replaced rather than rewritten */
+    make_chunk_ext(dset, coords, ext);
+    if (obj->file->journal)
+        fd = open_replacement(obj, ext);
+    else
+        fd = open_at(dset->dir_fd, base_name(obj->name), ext, O_WRONLY | O_CREAT | O_TRUNC);
+
+    if (fd < 0)
+        ret = -1;
+    else {
+        if (pwrite(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+            pwrite(fd, data, size, (off_t)sizeof(hdr)) != (ssize_t)size)
+            ret = -1;
+        if (obj->file->journal)
+            ret = replace_file(obj, ext, fd, ret);
+        close(fd);
+    }
+
+    free(encoded);
+
+    return ret;
+}
+
+static struct chunk_slot *
+get_chunk(struct tutorial_object *obj, struct chunk_io *io, const hsize_t *coords)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+    struct chunk_slot *      slot = NULL;
+    size_t                   size = (size_t)dset->rank * sizeof(hsize_t);
+
+    for (size_t i = 0; i < io->nslots; i++)
+        if (memcmp(io->slots[i].coords, coords, size) == 0)
+            return &(io->slots[i]);
+
+    /* Take a free slot, or evict one round-robin */
+    if (io->nslots < CHUNK_CACHE_NSLOTS) {
+        slot       = &(io->slots[io->nslots++]);
+        slot->data = malloc(chunk_nbytes(dset));
+    }
+    else {
+        slot           = &(io->slots[io->next_evict]);
+        io->next_evict = (io->next_evict + 1) % CHUNK_CACHE_NSLOTS;
+        if (slot->dirty && store_chunk(obj, slot->coords, slot->data) < 0)
+            return NULL;
+    }
+
+    memcpy(slot->coords, coords, size);
+    slot->dirty = false;
+    if (load_chunk(obj, coords, slot->data) < 0)
+        return NULL;
+
+    return slot;
+}
+
+static herr_t
+finish_chunk_io(struct tutorial_object *obj, struct chunk_io *io)
+{
+    herr_t ret = 0;
+
+    for (size_t i = 0; i < io->nslots; i++) {
+        if (io->slots[i].dirty && store_chunk(obj, io->slots[i].coords, io->slots[i].data) < 0)
+            ret = -1;
+        free(io->slots[i].data);
+    }
+
+    return ret;
+}
+
+/* Splits each segment into runs along the fastest-changing dimension that
+ * stay inside one chunk, and copies them to or from that chunk.
+ */
+static herr_t
+chunk_io_op(struct tutorial_object *obj, const struct io_seg *segs, size_t nsegs, void *buf, void *op_data)
 {
     struct tutorial_dataset *dset = &(obj->data.dataset);
+    struct chunk_io *        io   = (struct chunk_io *)op_data;
+    size_t                   es   = dset->type.size;
+    int                      last = dset->rank - 1;
+
+    for (size_t i = 0; i < nsegs; i++) {
+        hsize_t coords[H5S_MAX_RANK];
+        hsize_t elmt = segs[i].file_off / es;
+        hsize_t n    = segs[i].len / es;
+        char *  mem  = (char *)buf + segs[i].mem_off;
+
+        /* Row-major element index -> coordinates */
+        for (int d = last; d >= 0; d--) {
+            coords[d] = elmt % dset->dims[d];
+            elmt /= dset->dims[d];
+        }
+
+        while (n > 0) {
+            hsize_t            chunk[H5S_MAX_RANK];
+            hsize_t            in_chunk = 0;
+            hsize_t            run;
+            struct chunk_slot *slot;
+
+            /* Stop at the end of the chunk or of the row */
+            run = dset->chunk_dims[last] - coords[last] % dset->chunk_dims[last];
+            if (run > dset->dims[last] - coords[last])
+                run = dset->dims[last] - coords[last];
+            if (run > n)
+                run = n;
+
+            for (int d = 0; d <= last; d++) {
+                chunk[d] = coords[d] / dset->chunk_dims[d];
+                in_chunk = in_chunk * dset->chunk_dims[d] + coords[d] % dset->chunk_dims[d];
+            }
+
+            if (io->collect) {
+                struct chunk_run *r;
+
+                if (io->nruns == io->max_runs) {
+                    io->max_runs = MAX(2 * io->max_runs, SEQ_LIST_LEN);
+                    io->runs     = realloc(io->runs, io->max_runs * sizeof(struct chunk_run));
+                }
+                r           = &(io->runs[io->nruns]);
+                r->chunk    = 0;
+                r->seq      = io->nruns++;
+                r->in_chunk = in_chunk;
+                r->mem_off  = (hsize_t)(mem - (char *)buf);
+                r->n        = (size_t)run;
+                for (int d = 0; d <= last; d++)
+                    r->chunk = r->chunk * chunks_in_dim(dset, d) + chunk[d];
+            }
+            else {
+                if (NULL == (slot = get_chunk(obj, io, chunk)))
+                    return -1;
+
+                if (io->write) {
+                    memcpy(slot->data + in_chunk * es, mem, (size_t)run * es);
+                    slot->dirty = true;
+                }
+                else
+                    memcpy(mem, slot->data + in_chunk * es, (size_t)run * es);
+            }
+
+            mem += run * es;
+            n -= run;
+
+            /* Advance, carrying into slower dimensions at the end of a row */
+            coords[last] += run;
+            for (int d = last; d > 0 && coords[d] == dset->dims[d]; d--) {
+                coords[d] = 0;
+                coords[d - 1]++;
+            }
+        }
+    }
 
-    /* Seek to the beginning */
-    rewind(dset->space_file);
+    return 0;
+}
+
+static int
+compare_chunk_runs(const void *_a, const void *_b)
+{
+    const struct chunk_run *a = (const struct chunk_run *)_a;
+    const struct chunk_run *b = (const struct chunk_run *)_b;
 
-    /* Extract the value */
-    fscanf(dset->space_file, "%" PRIuHSIZE "\n", &(dset->dims));
+    if (a->chunk != b->chunk)
+        return a->chunk < b->chunk ? -1 : 1;
+
+    return a->seq < b->seq ? -1 : (a->seq > b->seq);
 }
 
-static void
-write_dataspace_file(struct tutorial_object *obj, hsize_t dims)
+/* Chunks split between the parts of a job. Each chunk belongs to one part,
+ * which loads it, copies all its runs and stores it if it was written.
+ */
+struct chunk_job {
+    struct tutorial_object *obj;
+    struct chunk_io *       io;
+    size_t *                groups; /* Chunk i's runs start at io->runs[groups[i]] */
+    size_t                  nchunks;
+    size_t                  nparts;
+    char *                  buf;
+};
+
+static herr_t
+chunk_part(size_t part, void *job_data)
 {
-    int                      fd;
-    struct tutorial_dataset *dset = &(obj->data.dataset);
+    struct chunk_job *       job  = (struct chunk_job *)job_data;
+    struct tutorial_dataset *dset = &(job->obj->data.dataset);
+    size_t                   es   = dset->type.size;
+    size_t                   from = job->nchunks * part / job->nparts;
+    size_t                   to   = job->nchunks * (part + 1) / job->nparts;
+    char *                   data = NULL;
+    herr_t                   ret  = 0;
+
+    data = malloc(chunk_nbytes(dset));
+
+    for (size_t g = from; g < to && ret >= 0; g++) {
+        const struct chunk_run *runs = job->io->runs;
+        hsize_t                 coords[H5S_MAX_RANK];
+        hsize_t                 index = runs[job->groups[g]].chunk;
+
+        /* Row-major chunk index -> chunk coordinates */
+        for (int d = dset->rank - 1; d >= 0; d--) {
+            coords[d] = index % chunks_in_dim(dset, d);
+            index /= chunks_in_dim(dset, d);
+        }
+
+        if (load_chunk(job->obj, coords, data) < 0) {
+            ret = -1;
+            break;
+        }
+
+        for (size_t r = job->groups[g]; r < job->groups[g + 1]; r++) {
+            char *mem = job->buf + runs[r].mem_off;
+
+            if (job->io->write)
+                memcpy(data + runs[r].in_chunk * es, mem, runs[r].n * es);
+            else
+                memcpy(mem, data + runs[r].in_chunk * es, runs[r].n * es);
+        }
+
+        if (job->io->write)
+            ret = store_chunk(job->obj, coords, data);
+    }
 
-    /* Seek to the beginning */
-    rewind(dset->space_file);
+    free(data);
 
-    /* Truncate the file */
-    fd = fileno(dset->space_file);
-    ftruncate(fd, 0);
+    return ret;
+}
+
+static herr_t
+chunked_io_parallel(struct tutorial_object *obj, struct chunk_io *io, void *buf, size_t nparts)
+{
+    struct chunk_job job;
+    herr_t           ret = 0;
+
+    /* Group the runs by chunk */
+    qsort(io->runs, io->nruns, sizeof(struct chunk_run), compare_chunk_runs);
+
+    job.obj     = obj;
+    job.io      = io;
+    job.groups  = malloc((io->nruns + 1) * sizeof(size_t));
+    job.nchunks = 0;
+    job.buf     = (char *)buf;
+    for (size_t r = 0; r < io->nruns; r++)
+        if (0 == r || io->runs[r].chunk != io->runs[r - 1].chunk)
+            job.groups[job.nchunks++] = r;
+    job.groups[job.nchunks] = io->nruns;
+
+    job.nparts = nparts < job.nchunks ? nparts : job.nchunks;
+    if (job.nparts > 0)
+        ret = run_parallel(obj->file, job.nparts, chunk_part, &job);
 
-    /* Write out the new size */
-    fprintf(dset->space_file, "%" PRIuHSIZE "\n", dims);
+    free(job.groups);
+
+    return ret;
 }
 
-static void
-open_dataspace_file(struct tutorial_object *obj, hbool_t create)
+static herr_t
+chunked_io(struct tutorial_object *obj, const struct selection *sel, hsize_t nbytes, void *buf, hbool_t write)
 {
-    char *                   path = NULL;
-    const char *             mode = "r+";
-    struct tutorial_dataset *dset = &(obj->data.dataset);
+    struct chunk_io *io     = NULL;
+    size_t           nparts = parallel_parts(obj->file, nbytes);
+    herr_t           ret    = 0;
+
+    io          = calloc(1, sizeof(struct chunk_io));
+    io->write   = write;
+    io->collect = nparts > 1;
 
-    if (create)
-        mode = "w";
+    ret = iterate_selections(obj, sel, buf, chunk_io_op, io);
 
-    path = make_path(obj->path, obj->name, SPACE_EXT);
+    if (io->collect) {
+        if (ret >= 0)
+            ret = chunked_io_parallel(obj, io, buf, nparts);
+        free(io->runs);
+    }
+    else if (finish_chunk_io(obj, io) < 0)
+        ret = -1;
 
-    dset->space_file = fopen(path, mode);
+    /* Make the renames of replaced chunks durable */
+    if (write && obj->file->journal && fsync(obj->data.dataset.dir_fd) < 0)
+        ret = -1;
 
-    if (create)
-        write_dataspace_file(obj, 0);
-    else
-        read_dataspace_file(obj);
+    free(io);
 
-    free(path);
+    return ret;
 }
 
 /************/
-/* DATATYPE */
+/* TRANSFER */
 /************/
 
-static void
-read_datatype_file(struct tutorial_object *obj)
-{
-    char *                   path      = NULL;
-    FILE *                   type_file = NULL;
-    char *                   line      = NULL;
-    size_t                   len       = 0;
-    ssize_t                  size      = 0;
-    struct tutorial_dataset *dset      = &(obj->data.dataset);
+/* A dataset read or write. Everything that needs the library is worked out
+ * on the calling thread when the transfer is set up. Running it only does
+ * file I/O and conversions that don't need the library, so it can happen on
+ * the file's background thread.
+ */
+struct transfer {
+    struct tutorial_object *obj;
 
-    path = make_path(obj->path, obj->name, TYPE_EXT);
+    /* Read the whole data file, with no selection handling */
+    hbool_t whole;
 
-    type_file = fopen(path, "r");
+    /* Dataset elements <-> buf (or <-> fbuf, when converting) */
+    struct selection file_sel;
 
-    size = getline(&line, &len, type_file);
+    /* fbuf, converted in mbuf <-> buf (reads that convert) */
+    struct selection mem_sel;
 
-    if (strncmp(line, TUTORIAL_DATA_TYPE_INT_STRING, (size_t)size - 1) == 0)
-        dset->type = TUTORIAL_DATA_TYPE_INT;
-    else
-        dset->type = TUTORIAL_DATA_TYPE_FLOAT;
+    /* The elements to write, or where the read elements go */
+    void *buf;
 
-    fclose(type_file);
+    /* The selected elements, in the stored and memory types */
+    char *fbuf;
+    char *mbuf;
 
-    free(line);
-    free(path);
-}
+    hsize_t              npoints;
+    struct tutorial_type mtype;
+    hid_t                mem_type_id;
+
+    /* Writes: the extent afterwards (and the number of elements before),
+     * and how many elements a binary data file has to hold
+     */
+    int     rank;
+    hsize_t dims[H5S_MAX_RANK];
+    hsize_t nelmts;
+    hsize_t old_nelmts;
+    hsize_t alloc_nelmts;
+
+    /* Writes: put the elements in the file's write buffer, or write out
+     * what the dataset has there (and settle the journal) before writing
+     * them. Batched writes do neither: they run on the thread pool, and
+     * flush_batch() has settled the journal for them.
+     */
+    hbool_t buffer;
+    hbool_t drain;
+};
 
 static void
-write_datatype_file(struct tutorial_object *obj, enum tutorial_data_type type)
+init_selection(struct selection *sel, hid_t file_space_id, hid_t mem_space_id, size_t elmt_size)
 {
-    char *path      = NULL;
-    FILE *type_file = NULL;
+    memset(sel, 0, sizeof(*sel));
+    sel->file_space_id = file_space_id;
+    sel->mem_space_id  = mem_space_id;
+    sel->elmt_size     = elmt_size;
+}
 
-    path = make_path(obj->path, obj->name, TYPE_EXT);
+static void
+free_transfer(void *task_data)
+{
+    struct transfer *xfer = (struct transfer *)task_data;
 
-    type_file = fopen(path, "w");
+    free(xfer->file_sel.segs);
+    free(xfer->mem_sel.segs);
+    free(xfer->fbuf);
+    free(xfer->mbuf);
+    free(xfer);
+}
 
-    if (TUTORIAL_DATA_TYPE_INT == type)
-        fprintf(type_file, "%s\n", TUTORIAL_DATA_TYPE_INT_STRING);
-    else
-        fprintf(type_file, "%s\n", TUTORIAL_DATA_TYPE_FLOAT_STRING);
+/* Describes the memory type. Types that can't be described this way are
+ * left to the library to convert.
+ */
+static void
+get_mem_type(hid_t mem_type_id, struct tutorial_type *mtype)
+{
+    if (type_from_hid(mem_type_id, mtype) < 0) {
+        memset(mtype, 0, sizeof(*mtype));
+        mtype->cls  = H5T_NO_CLASS;
+        mtype->size = H5Tget_size(mem_type_id);
+    }
+}
 
-    fclose(type_file);
+/* Reads the file selection (of npoints elements) into the memory selection,
+ * in the stored type
+ */
+static herr_t
+read_selection(struct tutorial_object *obj, const struct selection *sel, hsize_t npoints, void *buf)
+{
+    struct tutorial_dataset *dset   = &(obj->data.dataset);
+    size_t                   es     = dset->type.size;
+    hsize_t                  nbytes = npoints * es;
+    char *                   elmts  = NULL;
+    herr_t                   ret    = 0;
+
+    if (TUTORIAL_LAYOUT_CHUNKED == dset->layout) {
+        /* Only the chunks the selection touches are opened */
+        ret = chunked_io(obj, sel, nbytes, buf, false);
+    }
+    else if (TUTORIAL_DATA_FORMAT_BINARY == dset->format) {
+        /* Read only the selected byte ranges */
+        ret = iterate_selections_parallel(obj, sel, nbytes, buf, read_elements_op, NULL);
+    }
+    else {
+        /* Text can't be addressed by offset, so parse it all and scatter */
+        elmts = malloc((size_t)dataset_nelmts(dset) * es);
+        ret   = read_data(obj, dataset_nelmts(dset), elmts);
+        if (ret >= 0)
+            ret = iterate_selections_parallel(obj, sel, nbytes, buf, copy_from_array_op, elmts);
+        free(elmts);
+    }
 
-    free(path);
+    return ret;
 }
 
-/**************/
-/* FILL VALUE */
-/**************/
+/* Converts a transfer's elements from fbuf to mbuf in parallel (only for
+ * conversions that don't need the library)
+ */
+static herr_t
+convert_part(size_t part, void *job_data)
+{
+    struct transfer *        xfer   = (struct transfer *)job_data;
+    struct tutorial_dataset *dset   = &(xfer->obj->data.dataset);
+    size_t                   nparts = parallel_parts(xfer->obj->file, xfer->npoints * dset->type.size);
+    hsize_t                  from   = xfer->npoints * part / nparts;
+    hsize_t                  to     = xfer->npoints * (part + 1) / nparts;
+
+    return convert_elements(&(dset->type), H5I_INVALID_HID, &(xfer->mtype), H5I_INVALID_HID, (size_t)(to - from),
+                            xfer->fbuf + from * dset->type.size, xfer->mbuf + from * xfer->mtype.size);
+}
 
-static void
-read_fillval_file(struct tutorial_object *obj)
+static herr_t
+run_read(void *task_data)
 {
-    char *                   path         = NULL;
-    FILE *                   fillval_file = NULL;
-    struct tutorial_dataset *dset         = &(obj->data.dataset);
+    struct transfer *        xfer = (struct transfer *)task_data;
+    struct tutorial_object * obj  = xfer->obj;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
 
-    path = make_path(obj->path, obj->name, FILLVAL_EXT);
+    /* Anything still in the write buffer has to be read back */
+    if (drain_write_buffer(obj->file, obj->path, false) < 0 || reopen_replaced_data_file(obj) < 0)
+        return -1;
 
-    fillval_file = fopen(path, "r");
+    /* Whole-dataset reads of a data file need no selection handling */
+    if (xfer->whole)
+        return read_data(obj, dataset_nelmts(dset), xfer->buf);
 
-    /* Extract the value */
-    fscanf(fillval_file, "%d\n", &(dset->fillval));
+    if (NULL == xfer->fbuf)
+        return read_selection(obj, &(xfer->file_sel), xfer->npoints, xfer->buf);
 
-    fclose(fillval_file);
-    free(path);
+    /* Gather the selected elements in the stored type, convert them all in
+     * one pass, then scatter them to the memory selection.
+     */
+    if (read_selection(obj, &(xfer->file_sel), xfer->npoints, xfer->fbuf) < 0)
+        return -1;
+    if (convert_is_native(&(dset->type), &(xfer->mtype))) {
+        if (run_parallel(obj->file, parallel_parts(obj->file, xfer->npoints * dset->type.size), convert_part,
+                         xfer) < 0)
+            return -1;
+    }
+    else if (convert_elements(&(dset->type), H5I_INVALID_HID, &(xfer->mtype), xfer->mem_type_id,
+                              (size_t)xfer->npoints, xfer->fbuf, xfer->mbuf) < 0)
+        return -1;
+
+    return iterate_selections_parallel(obj, &(xfer->mem_sel), xfer->npoints * xfer->mtype.size, xfer->buf,
+                                       copy_from_array_op, xfer->mbuf);
 }
 
-static void
-write_fillval_file(struct tutorial_object *obj, int fillval)
+static herr_t
+run_write(void *task_data)
 {
-    char *                   path         = NULL;
-    FILE *                   fillval_file = NULL;
-    struct tutorial_dataset *dset         = &(obj->data.dataset);
+    struct transfer *        xfer  = (struct transfer *)task_data;
+    struct tutorial_object * obj   = xfer->obj;
+    struct tutorial_dataset *dset  = &(obj->data.dataset);
+    size_t                   es    = dset->type.size;
+    char *                   elmts = NULL;
+    herr_t                   ret   = 0;
+
+    /* Small writes wait in the write buffer, and others go after what's
+     * already there
+     */
+    if (xfer->buffer) {
+        if (iterate_selections(obj, &(xfer->file_sel), xfer->buf, buffer_elements_op, NULL) < 0)
+            return -1;
+        return check_write_buffer(obj->file);
+    }
+    if (xfer->drain && (drain_write_buffer(obj->file, obj->path, false) < 0 || settle_journal(obj) < 0))
+        return -1;
+    if (reopen_replaced_data_file(obj) < 0)
+        return -1;
+
+    if (TUTORIAL_LAYOUT_CHUNKED == dset->layout) {
+        /* Only the chunks the selection touches are rewritten */
+        ret = chunked_io(obj, &(xfer->file_sel), xfer->npoints * es, xfer->buf, true);
+    }
+    else if (TUTORIAL_DATA_FORMAT_BINARY == dset->format) {
+        if (xfer->nelmts < xfer->old_nelmts && truncate_data(obj, xfer->nelmts) < 0)
+            return -1;
+        if (xfer->alloc_nelmts > 0 && extend_data(obj, xfer->alloc_nelmts, xfer->npoints == xfer->nelmts) < 0)
+            return -1;
+
+        /* Update only the selected elements, in place */
+        ret = iterate_selections_parallel(obj, &(xfer->file_sel), xfer->npoints * es, xfer->buf,
+                                          write_elements_op, NULL);
+
+        /* Writes that skip the journal (ones that change the extent, or
+         * were batched) are on disk before the new extent is
+         */
+        if (ret >= 0 && obj->file->journal && fdatasync(fileno(dset->data_file)) < 0)
+            ret = -1;
+    }
+    else {
+        /* Text can't be patched in place, so merge into the current contents
+         * (unless everything is being overwritten) and rewrite the file.
+         */
+        elmts = malloc((size_t)xfer->nelmts * es);
+        if (xfer->npoints < xfer->nelmts)
+            ret = read_data(obj, xfer->nelmts < xfer->old_nelmts ? xfer->nelmts : xfer->old_nelmts, elmts);
+        if (ret >= 0)
+            ret = iterate_selections_parallel(obj, &(xfer->file_sel), xfer->npoints * es, xfer->buf,
+                                              copy_to_array_op, elmts);
+        if (ret >= 0)
+            ret = write_data(obj, xfer->nelmts, elmts);
+        free(elmts);
+    }
 
-    path = make_path(obj->path, obj->name, FILLVAL_EXT);
+    /* Only touch the dataspace metadata when the extent actually changed */
+    if (ret >= 0 && (xfer->rank != dset->rank ||
+                     memcmp(xfer->dims, dset->dims, (size_t)xfer->rank * sizeof(hsize_t)) != 0)) {
+        hbool_t fits = xfer->rank == dset->rank;
 
-    fillval_file = fopen(path, "w");
+        /* Keep the maximum dims (unlimited ones, say) if they still hold */
+        for (int i = 0; fits && i < xfer->rank; i++)
+            fits = xfer->dims[i] <= dset->maxdims[i];
 
-    fprintf(fillval_file, "%d\n", dset->fillval);
+        dset->rank = xfer->rank;
+        memcpy(dset->dims, xfer->dims, sizeof(xfer->dims));
+        if (!fits)
+            memcpy(dset->maxdims, xfer->dims, sizeof(xfer->dims));
+        ret = update_metadata(obj);
+    }
 
-    fclose(fillval_file);
-    free(path);
+    return ret;
 }
 
-/******************/
-/* DATASET / DATA */
-/******************/
+/**********/
+/* EXTENT */
+/**********/
 
-static void
-write_data(struct tutorial_object *obj, hsize_t n, const int *data)
+/* Whether size differs from the dataset's extent in its first dimension
+ * at most, which is the only change that doesn't move any of the elements
+ * of a contiguous dataset
+ */
+static hbool_t
+only_first_dim_changes(const struct tutorial_dataset *dset, const hsize_t *size)
 {
-    int                      fd;
-    struct tutorial_dataset *dset = &(obj->data.dataset);
+    for (int i = 1; i < dset->rank; i++)
+        if (size[i] != dset->dims[i])
+            return false;
 
-    /* Seek to the beginning */
-    rewind(dset->data_file);
+    return true;
+}
 
-    /* Truncate the file */
-    fd = fileno(dset->data_file);
-    ftruncate(fd, 0);
+/* Rewrites a contiguous dataset's elements where they belong in the
+ * extent size, with the fill value wherever there were none before
+ */
+static herr_t
+relayout_data(struct tutorial_object *obj, const hsize_t *size)
+{
+    struct tutorial_dataset *dset       = &(obj->data.dataset);
+    size_t                   es         = dset->type.size;
+    int                      last       = dset->rank - 1;
+    hsize_t                  old_n      = dataset_nelmts(dset);
+    hsize_t                  new_n      = 1;
+    hsize_t                  nrows      = 1;
+    hsize_t                  row_nelmts = MIN(dset->dims[last], size[last]);
+    hsize_t                  coords[H5S_MAX_RANK];
+    char *                   old_elmts  = NULL;
+    char *                   new_elmts  = NULL;
+    herr_t                   ret        = 0;
+
+    for (int i = 0; i < dset->rank; i++) {
+        new_n *= size[i];
+        if (i < last)
+            nrows *= MIN(dset->dims[i], size[i]);
+        coords[i] = 0;
+    }
 
-    if (data) {
-        for (hsize_t i = 0; i < n; i++)
-            fprintf(dset->data_file, "%d\n", data[i]);
+    old_elmts = malloc((size_t)old_n * es);
+    new_elmts = malloc((size_t)new_n * es);
+    if (read_data(obj, old_n, old_elmts) < 0) {
+        free(old_elmts);
+        free(new_elmts);
+        return -1;
     }
-    else {
-        /* Special initial dataset fill value case */
-        for (hsize_t i = 0; i < n; i++)
-            fprintf(dset->data_file, "%d\n", dset->fillval);
+    fill_elements(new_elmts, (size_t)new_n, dset->fillval, es);
+
+    /* Copy the rows the two extents have in common */
+    for (hsize_t r = 0; r < nrows && row_nelmts > 0; r++) {
+        hsize_t old_off = 0;
+        hsize_t new_off = 0;
+
+        for (int i = 0; i < last; i++) {
+            old_off = old_off * dset->dims[i] + coords[i];
+            new_off = new_off * size[i] + coords[i];
+        }
+        memcpy(new_elmts + new_off * size[last] * es, old_elmts + old_off * dset->dims[last] * es,
+               (size_t)row_nelmts * es);
+
+        for (int i = last - 1; i >= 0; i--) {
+            if (++coords[i] < MIN(dset->dims[i], size[i]))
+                break;
+            coords[i] = 0;
+        }
     }
+
+    ret = write_data(obj, new_n, new_elmts);
+
+    free(old_elmts);
+    free(new_elmts);
+
+    return ret;
 }
 
+/* Sets the elements of a chunk that lie outside the extent size to the
+ * fill value
+ */
 static void
-read_data(struct tutorial_object *obj, hsize_t n, int *data)
+clear_chunk_outside(const struct tutorial_dataset *dset, const hsize_t *coords, const hsize_t *size,
+                    char *data)
 {
-    struct tutorial_dataset *dset = &(obj->data.dataset);
+    size_t  es     = dset->type.size;
+    size_t  nelmts = chunk_nbytes(dset) / es;
+    hsize_t local[H5S_MAX_RANK];
+
+    memset(local, 0, sizeof(local));
+
+    for (size_t e = 0; e < nelmts; e++) {
+        for (int i = 0; i < dset->rank; i++)
+            if (coords[i] * dset->chunk_dims[i] + local[i] >= size[i]) {
+                fill_elements(data + e * es, 1, dset->fillval, es);
+                break;
+            }
+
+        for (int i = dset->rank - 1; i >= 0; i--) {
+            if (++local[i] < dset->chunk_dims[i])
+                break;
+            local[i] = 0;
+        }
+    }
+}
 
-    /* Seek to the beginning */
-    rewind(dset->data_file);
+/* Removes the chunks of a chunked dataset that are wholly outside the
+ * smaller extent size. The ones it cuts through keep their elements inside
+ * it, and the rest go back to the fill value, so they don't reappear if the
+ * dataset grows again.
+ */
+static herr_t
+shrink_chunks(struct tutorial_object *obj, const hsize_t *size)
+{
+    struct tutorial_dataset *dset  = &(obj->data.dataset);
+    DIR *                    dir   = NULL;
+    struct dirent *          entry = NULL;
+    char *                   data  = NULL;
+    char                     prefix[NAME_MAX + 1];
+    size_t                   prefix_len;
+    hsize_t                  coords[H5S_MAX_RANK];
+    herr_t                   ret   = 0;
+
+    prefix_len = (size_t)snprintf(prefix, sizeof(prefix), "%s." CHUNK_EXT ".", base_name(obj->name));
+
+    if (NULL == (dir = opendir_at(dset->dir_fd, ".")))
+        return -1;
+    data = malloc(chunk_nbytes(dset));
+
+    while (NULL != (entry = readdir(dir))) {
+        const char *ptr     = entry->d_name + prefix_len;
+        hbool_t     outside = false;
+        hbool_t     cut     = false;
+        int         i;
+
+        if (strncmp(entry->d_name, prefix, prefix_len) != 0)
+            continue;
+
+        /* The chunk's coordinates are in its name, and nothing else is (a
+         * replacement left behind by a crash has a suffix)
+         */
+        for (i = 0; i < dset->rank; i++) {
+            char *end = NULL;
+
+            coords[i] = (hsize_t)strtoull(ptr, &end, 10);
+            if (end == ptr || (*end != '.' && *end != '\0'))
+                break;
+            ptr = *end ? end + 1 : end;
+        }
+        if (i < dset->rank || *ptr != '\0')
+            continue;
+
+        for (i = 0; i < dset->rank; i++) {
+            hsize_t start = coords[i] * dset->chunk_dims[i];
+
+            if (start >= size[i])
+                outside = true;
+            else if (start + dset->chunk_dims[i] > size[i] && size[i] < dset->dims[i])
+                cut = true;
+        }
+
+        if (outside) {
+            if (unlinkat(dset->dir_fd, entry->d_name, 0) < 0)
+                ret = -1;
+        }
+        else if (cut) {
+            /* A chunk that can't be read is left as it is */
+            if (load_chunk(obj, coords, data) < 0) {
+                ret = -1;
+                continue;
+            }
+            clear_chunk_outside(dset, coords, size, data);
+            if (store_chunk(obj, coords, data) < 0)
+                ret = -1;
+        }
+    }
+
+    free(data);
+    closedir(dir);
+
+    if (obj->file->journal && fsync(dset->dir_fd) < 0)
+        ret = -1;
+
+    return ret;
+}
+
+/* Changes the extent of a dataset to size, within its maximum dims */
+static herr_t
+set_extent(struct tutorial_object *obj, const hsize_t *size)
+{
+    struct tutorial_dataset *dset   = &(obj->data.dataset);
+    hsize_t                  nelmts = 1;
+    hbool_t                  shrink = false;
+
+    /* Scalar datasets don't have an extent to change */
+    if (0 == dset->rank)
+        return -1;
+
+    for (int i = 0; i < dset->rank; i++) {
+        if (size[i] > dset->maxdims[i])
+            return -1;
+        if (size[i] < dset->dims[i])
+            shrink = true;
+        nelmts *= size[i];
+    }
+
+    if (memcmp(size, dset->dims, (size_t)dset->rank * sizeof(hsize_t)) == 0)
+        return 0;
 
-    for (hsize_t i = 0; i < n; i++)
-        (void)fscanf(dset->data_file, "%d\n", &(data[i]));
+    /* Elements that move would be overwritten by replaying older writes to
+     * where they used to be
+     */
+    if (settle_journal(obj) < 0)
+        return -1;
+
+    if (TUTORIAL_LAYOUT_CHUNKED == dset->layout) {
+        /* Chunks are found by their coordinates, which don't depend on the
+         * extent, so only shrinking has anything to do
+         */
+        if (shrink && shrink_chunks(obj, size) < 0)
+            return -1;
+    }
+    else if (!only_first_dim_changes(dset, size) || (shrink && TUTORIAL_DATA_FORMAT_TEXT == dset->format)) {
+        if (relayout_data(obj, size) < 0)
+            return -1;
+    }
+    else if (shrink && truncate_data(obj, nelmts) < 0)
+        return -1;
+
+    /* Growing the first dimension of a contiguous dataset needs nothing
+     * more than the new extent, since everything past the end of the data
+     * file reads as the fill value. Appends then only write the new
+     * elements.
+     */
+    memcpy(dset->dims, size, (size_t)dset->rank * sizeof(hsize_t));
+
+    return update_metadata(obj);
 }
 
+/************/
+/* CREATION */
+/************/
+
+/* The on-disk part of creating a dataset */
+struct create_task {
+    struct tutorial_object *obj;
+
+    /* The parent group, which stays open since closing it waits for the
+     * file's tasks. Its directory is looked up when the task runs, as the
+     * parent may still be being created.
+     */
+    struct tutorial_object *parent;
+
+    /* Write the fill values now rather than as elements are written */
+    hbool_t alloc_early;
+};
+
+/* Works out everything about a new dataset from the property lists. The
+ * dataset's files are made by create_dataset_files().
+ */
 static struct tutorial_object *
-create_dataset(struct tutorial_object *parent, const char *name, hid_t sid, hid_t tid, hid_t dcpl_id)
+create_dataset(struct tutorial_object *parent, const char *name, hid_t sid, hid_t tid, hid_t dcpl_id,
+               hid_t dapl_id, hbool_t *alloc_early)
 {
     struct tutorial_object *obj  = NULL;
-    const char *            mode = "w+";
-    char *                  path = NULL;
-    enum tutorial_data_type type;
-    hsize_t                 maxdims;
+    struct tutorial_type    type;
+    hid_t                   ftid = H5I_INVALID_HID;
+    H5D_alloc_time_t        alloc_time;
+    H5D_fill_time_t         fill_time;
+    unsigned                filters;
+    int                     deflate_level;
+
+    /* Only integer and floating-point elements can be stored */
+    if (type_from_hid(tid, &type) < 0 || !type_is_storable(&type))
+        return NULL;
+
+    /* Only filters that can be applied are allowed, unless they're optional */
+    if (get_filters(dcpl_id, &filters, &deflate_level) < 0)
+        return NULL;
 
     /* Create a new dataset object */
-    obj = make_object(H5I_DATASET, parent->path, name);
+    obj = make_object(parent->file, H5I_DATASET, parent->path, name);
 
     struct tutorial_dataset *dset = &(obj->data.dataset);
 
+    dset->dir_fd = -1;
+    dset->type   = type;
+
+    /* Get the shape of the dataspace */
+    dset->rank = H5Sget_simple_extent_ndims(sid);
+    if (dset->rank < 0 || dset->rank > H5S_MAX_RANK)
+        dset->rank = 0;
+    H5Sget_simple_extent_dims(sid, dset->dims, dset->maxdims);
+
+    /* Pick the data file format, with the DCPL overriding the file default */
+    dset->format = parent->file->data_format;
+    switch (get_int_property(dcpl_id, TUTORIAL_VOL_DATA_FORMAT_PROP, -1)) {
+        case TUTORIAL_VOL_DATA_FORMAT_BINARY:
+            dset->format = TUTORIAL_DATA_FORMAT_BINARY;
+            break;
+        case TUTORIAL_VOL_DATA_FORMAT_TEXT:
+            dset->format = TUTORIAL_DATA_FORMAT_TEXT;
+            break;
+        default:
+            break;
+    }
+
+    /* Chunked datasets keep each chunk in its own binary file, created the
+     * first time the chunk is written.
+     */
+    dset->layout = TUTORIAL_LAYOUT_CONTIGUOUS;
+    if (H5D_CHUNKED == H5Pget_layout(dcpl_id) && dset->rank > 0 &&
+        H5Pget_chunk(dcpl_id, dset->rank, dset->chunk_dims) == dset->rank) {
+        dset->layout = TUTORIAL_LAYOUT_CHUNKED;
+        dset->format = TUTORIAL_DATA_FORMAT_BINARY;
+    }
+
+    /* As in HDF5, filters are applied chunk by chunk, so they need chunks */
+    if (filters && TUTORIAL_LAYOUT_CHUNKED != dset->layout) {
+        destroy_object(&obj);
+        return NULL;
+    }
+    dset->filters       = filters;
+    dset->deflate_level = deflate_level;
+
+    /* Text holds values rather than bytes, so it's always native order */
+    if (TUTORIAL_DATA_FORMAT_TEXT == dset->format)
+        dset->type.order = native_order();
+
+    /* Get the fill value, converted to the stored type */
+    ftid = type_to_hid(&(dset->type));
+    H5Pget_fill_value(dcpl_id, ftid, dset->fillval);
+    H5Tclose(ftid);
+    if (H5Pget_fill_time(dcpl_id, &fill_time) >= 0)
+        dset->fill_never = (H5D_FILL_TIME_NEVER == fill_time);
+
+    /* Mapping only makes sense for binary data, and writes to a mapping
+     * can't be logged in the journal
+     */
+    dset->use_mmap = (0 != get_int_property(dapl_id, TUTORIAL_VOL_MMAP_PROP, parent->file->use_mmap)) &&
+                     TUTORIAL_DATA_FORMAT_BINARY == dset->format &&
+                     TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout && NULL == parent->file->journal;
+
+    /* Only early allocation writes the fill values now. Otherwise the data
+     * file starts out empty and reads of unwritten elements return the fill
+     * value, so creating a dataset costs the same whatever its size.
+     */
+    *alloc_early = H5Pget_alloc_time(dcpl_id, &alloc_time) >= 0 && H5D_ALLOC_TIME_EARLY == alloc_time &&
+                   !dset->fill_never;
+
+    return obj;
+}
+
+static herr_t
+create_dataset_files(void *task_data)
+{
+    struct create_task *     task = (struct create_task *)task_data;
+    struct tutorial_object * obj  = task->obj;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
     /* We put all the dataset stuff in a directory.
      * This would be helpful if we implemented links.
      */
-    mkdir(obj->path, 0700);
+    mkdirat(group_fd(task->parent), obj->name, 0700);
+    if ((dset->dir_fd = openat(group_fd(task->parent), obj->name, O_RDONLY | O_DIRECTORY)) < 0)
+        return -1;
+    if (index_insert(group_fd(task->parent), obj->name, H5I_DATASET) < 0)
+        return -1;
+
+    /* Write the metadata record, which also replaces anything cached for an
+     * earlier object at the path
+     */
+    if (NULL == (dset->space_file = open_dataset_file(obj, META_EXT, "w+")))
+        return -1;
+    cache_evict(obj->file->cache, obj->path);
+    if (update_metadata(obj) < 0)
+        return -1;
 
-    /* Get the number of elements in the memory space */
-    H5Sget_simple_extent_dims(sid, &(dset->dims), &maxdims);
+    if (TUTORIAL_LAYOUT_CHUNKED == dset->layout)
+        return 0;
 
-    /* Create the dataspace file and write the size to it */
-    open_dataspace_file(obj, true);
-    write_dataspace_file(obj, dset->dims);
+    /* Create the data file */
+    if (open_data_file(obj, "w+") < 0)
+        return -1;
 
-    /* Get the fill value */
-    H5Pget_fill_value(dcpl_id, H5T_NATIVE_INT, &(dset->fillval));
-    write_fillval_file(obj, dset->fillval);
+    return write_data(obj, task->alloc_early ? dataset_nelmts(dset) : 0, NULL);
+}
 
-    /* Create the type file */
-    if (tid == H5T_NATIVE_INT)
-        type = TUTORIAL_DATA_TYPE_INT;
-    else
-        type = TUTORIAL_DATA_TYPE_FLOAT;
-    write_datatype_file(obj, type);
+/* Whether the directory name, relative to dir_fd, holds a dataset rather
+ * than a group (by looking for its metadata file)
+ */
+hbool_t
+is_dataset_dir(int dir_fd, const char *name)
+{
+    char path[2 * NAME_MAX + 16];
 
-    /* Create the data file */
-    path            = make_path(obj->path, obj->name, DATA_EXT);
-    dset->data_file = fopen(path, mode);
-    free(path);
+    snprintf(path, sizeof(path), "%s/%s." META_EXT, name, base_name(name));
+    if (0 == faccessat(dir_fd, path, F_OK, 0))
+        return true;
 
-    /* Write fill value data */
-    write_data(obj, dset->dims, NULL);
+    snprintf(path, sizeof(path), "%s/%s." SPACE_EXT, name, base_name(name));
 
-    return obj;
+    return 0 == faccessat(dir_fd, path, F_OK, 0);
+}
+
+/* Reads a dataset's metadata and opens its data file. Fails if there's no
+ * dataset at the object's path.
+ */
+static herr_t
+read_dataset_files(struct tutorial_object *obj)
+{
+    struct tutorial_dataset *dset = &(obj->data.dataset);
+
+    /* Everything is in the metadata record, unless the dataset is from an
+     * older version
+     */
+    dset->space_file = open_dataset_file(obj, META_EXT, "r+");
+
+    if (dset->space_file && read_meta_file(obj) >= 0) {
+        if (TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout)
+            return open_data_file(obj, "r+");
+        return 0;
+    }
+
+    if (dset->space_file) {
+        fclose(dset->space_file);
+        dset->space_file = NULL;
+    }
+    dset->legacy_meta = true;
+
+    /* Read the dataspace file */
+    if (NULL == (dset->space_file = open_dataset_file(obj, SPACE_EXT, "r+")))
+        return -1;
+    read_dataspace_file(obj);
+
+    /* Read the datatype file */
+    if (read_datatype_file(obj) < 0)
+        return -1;
+
+    /* Chunked datasets have no single data file */
+    read_layout_file(obj);
+    if (TUTORIAL_LAYOUT_CHUNKED == dset->layout) {
+        dset->format = TUTORIAL_DATA_FORMAT_BINARY;
+        return read_fillval_file(obj);
+    }
+
+    /* Open the data file */
+    if (open_data_file(obj, "r+") < 0)
+        return -1;
+
+    /* Binary files are self-describing, anything else is legacy text */
+    dset->format = detect_data_format(obj);
+
+    /* Get the fill value from the file (once the byte order is known) */
+    return read_fillval_file(obj);
 }
 
 static struct tutorial_object *
-open_dataset(struct tutorial_object *parent, const char *name)
+open_dataset(struct tutorial_object *parent, const char *name, hid_t dapl_id)
 {
-    struct tutorial_object *obj  = NULL;
-    const char *            mode = "r+";
-    char *                  path = NULL;
+    struct tutorial_object *obj = NULL;
 
     /* Create a new dataset object */
-    obj = make_object(H5I_DATASET, parent->path, name);
+    obj = make_object(parent->file, H5I_DATASET, parent->path, name);
 
     struct tutorial_dataset *dset = &(obj->data.dataset);
 
-    /* Read the dataspace file */
-    open_dataspace_file(obj, false);
-
-    /* Get the fill value from the file */
-    read_fillval_file(obj);
+    dset->dir_fd = -1;
 
-    /* Read the datatype file */
-    read_datatype_file(obj);
+    /* Datasets that were opened (or created) before don't need their
+     * metadata files read again, and may still have their files open
+     */
+    if (!cache_lookup_dataset(obj->file->cache, obj->path, dset)) {
+        if ((dset->dir_fd = openat(group_fd(parent), obj->name, O_RDONLY | O_DIRECTORY)) < 0 ||
+            read_dataset_files(obj) < 0) {
+            tutorial_dataset_close(obj, H5P_DEFAULT, NULL);
+            return NULL;
+        }
+        cache_store_dataset(obj->file->cache, obj->path, dset);
+    }
+    else {
+        if (dset->dir_fd < 0 && (dset->dir_fd = openat(group_fd(parent), obj->name, O_RDONLY | O_DIRECTORY)) < 0) {
+            tutorial_dataset_close(obj, H5P_DEFAULT, NULL);
+            return NULL;
+        }
+        if (TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout && NULL == dset->data_file)
+            open_data_file(obj, "r+");
+    }
 
-    /* Create or open the data file */
-    path            = make_path(obj->path, obj->name, DATA_EXT);
-    dset->data_file = fopen(path, mode);
-    free(path);
+    /* Mapping only makes sense for binary data, and writes to a mapping
+     * can't be logged in the journal
+     */
+    dset->use_mmap = (0 != get_int_property(dapl_id, TUTORIAL_VOL_MMAP_PROP, parent->file->use_mmap)) &&
+                     TUTORIAL_DATA_FORMAT_BINARY == dset->format &&
+                     TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout && NULL == parent->file->journal;
+    if (dset->use_mmap && map_data_file(obj, 0) < 0)
+        dset->use_mmap = false;
 
     return obj;
 }
@@ -298,6 +2844,8 @@ tutorial_dataset_create(void *_parent, const H5VL_loc_params_t *loc_params, cons
 {
     struct tutorial_object *new_obj = NULL;
     struct tutorial_object *parent  = NULL;
+    struct create_task *    task    = NULL;
+    hbool_t                 alloc_early;
 
     /* Get the parent group */
     if (H5I_FILE == loc_params->obj_type) {
@@ -308,8 +2856,29 @@ tutorial_dataset_create(void *_parent, const H5VL_loc_params_t *loc_params, cons
         parent = (struct tutorial_object *)_parent;
     }
 
+    /* Absolute names are looked up from the root group */
+    parent = resolve_name(parent, &name);
+
     /* Create the dataset */
-    new_obj = create_dataset(parent, name, space_id, type_id, dcpl_id);
+    new_obj = create_dataset(parent, name, space_id, type_id, dcpl_id, dapl_id, &alloc_early);
+    if (NULL == new_obj)
+        return NULL;
+
+    /* The files can be made in the background, or held back in the file's
+     * batch. Anything else done with the dataset is queued behind them.
+     */
+    task              = malloc(sizeof(struct create_task));
+    task->obj         = new_obj;
+    task->parent      = parent;
+    task->alloc_early = alloc_early;
+
+    if (NULL == req && batch_create(new_obj, create_dataset_files, free, task))
+        return new_obj;
+
+    if (submit_task(parent->file, create_dataset_files, free, task, false, req) < 0) {
+        tutorial_dataset_close(new_obj, dxpl_id, NULL);
+        return NULL;
+    }
 
     return new_obj;
 }
@@ -330,8 +2899,14 @@ tutorial_dataset_open(void *_parent, const H5VL_loc_params_t *loc_params, const
         parent = (struct tutorial_object *)_parent;
     }
 
+    /* Absolute names are looked up from the root group */
+    parent = resolve_name(parent, &name);
+
+    /* The dataset may still be being created */
+    wait_for_tasks(parent->file);
+
     /* Open the dataset */
-    new_obj = open_dataset(parent, name);
+    new_obj = open_dataset(parent, name, dapl_id);
 
     return (void *)new_obj;
 }
@@ -340,32 +2915,295 @@ herr_t
 tutorial_dataset_read(void *_obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t dxpl_id,
                       void *buf, void **req)
 {
-    struct tutorial_object * obj  = (struct tutorial_object *)_obj;
-    struct tutorial_dataset *dset = &(obj->data.dataset);
+    struct tutorial_object * obj     = (struct tutorial_object *)_obj;
+    struct tutorial_dataset *dset    = &(obj->data.dataset);
+    struct transfer *        xfer    = NULL;
+    hid_t                    fsid    = file_space_id;
+    hid_t                    msid    = mem_space_id;
+    hid_t                    esid    = H5I_INVALID_HID;
+    hid_t                    tsid    = H5I_INVALID_HID;
+    hbool_t                  convert = false;
+    hssize_t                 npoints = 0;
+    herr_t                   ret     = 0;
+
+    xfer              = calloc(1, sizeof(struct transfer));
+    xfer->obj         = obj;
+    xfer->buf         = buf;
+    xfer->mem_type_id = mem_type_id;
+
+    get_mem_type(mem_type_id, &(xfer->mtype));
+    convert = !types_equal(&(xfer->mtype), &(dset->type));
+
+    /* Conversions that need the library can't run in the background */
+    if (convert && !convert_is_native(&(dset->type), &(xfer->mtype)))
+        req = NULL;
+
+    if (H5S_ALL == file_space_id && H5S_ALL == mem_space_id && TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout &&
+        !convert) {
+        xfer->whole = true;
+        goto run;
+    }
+
+    /* H5S_ALL in the file means the entire extent. In memory it means "the
+     * same as the file selection".
+     */
+    if (H5S_ALL == file_space_id)
+        fsid = esid = H5Screate_simple(dset->rank, dset->dims, NULL);
+    if (H5S_ALL == mem_space_id)
+        msid = fsid;
+
+    npoints = H5Sget_select_npoints(fsid);
+    if (npoints < 0 || npoints != H5Sget_select_npoints(msid)) {
+        ret = -1;
+        goto done;
+    }
+    xfer->npoints = (hsize_t)npoints;
+
+    init_selection(&(xfer->file_sel), fsid, msid, dset->type.size);
+    if (convert && npoints > 0) {
+        hsize_t n = (hsize_t)npoints;
+
+        /* The file selection is read into a contiguous buffer, converted,
+         * and then scattered to the memory selection
+         */
+        tsid = H5Screate_simple(1, &n, NULL);
+        init_selection(&(xfer->file_sel), fsid, tsid, dset->type.size);
+        init_selection(&(xfer->mem_sel), tsid, msid, xfer->mtype.size);
+        xfer->fbuf = malloc((size_t)n * dset->type.size);
+        xfer->mbuf = malloc((size_t)n * MAX(dset->type.size, xfer->mtype.size));
+    }
+
+    /* The dataspaces go away when this returns */
+    if (req && (flatten_selection(&(xfer->file_sel)) < 0 ||
+                (xfer->mbuf && flatten_selection(&(xfer->mem_sel)) < 0))) {
+        ret = -1;
+        goto done;
+    }
 
-    /* Assuming H5S_ALL for now */
+run:
+    ret  = submit_task(obj->file, run_read, free_transfer, xfer, true, req);
+    xfer = NULL;
 
-    read_data(obj, dset->dims, (int *)buf);
+done:
+    if (xfer)
+        free_transfer(xfer);
+    if (tsid >= 0)
+        H5Sclose(tsid);
+    if (esid >= 0)
+        H5Sclose(esid);
 
-    return 0;
+    return ret;
 }
 
 herr_t
 tutorial_dataset_write(void *_obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t dxpl_id,
                        const void *buf, void **req)
 {
-    struct tutorial_object *obj = (struct tutorial_object *)_obj;
-    hsize_t                 dims;
-    hsize_t                 maxdims;
+    struct tutorial_object * obj     = (struct tutorial_object *)_obj;
+    struct tutorial_dataset *dset    = &(obj->data.dataset);
+    size_t                   es      = dset->type.size;
+    struct transfer *        xfer    = NULL;
+    hid_t                    fsid    = file_space_id;
+    hid_t                    msid    = mem_space_id;
+    hid_t                    esid    = H5I_INVALID_HID;
+    hid_t                    tsid    = H5I_INVALID_HID;
+    struct tutorial_type     mtype;
+    char *                   mbuf    = NULL;
+    hbool_t                  resize  = false;
+    hbool_t                  convert = false;
+    hbool_t                  batched = false;
+    hssize_t                 npoints = 0;
+    herr_t                   ret     = 0;
+
+    xfer      = calloc(1, sizeof(struct transfer));
+    xfer->obj = obj;
+    xfer->buf = (void *)buf;
+
+    xfer->rank = dset->rank;
+    memcpy(xfer->dims, dset->dims, sizeof(xfer->dims));
+    xfer->old_nelmts = dataset_nelmts(dset);
+    xfer->nelmts     = xfer->old_nelmts;
+
+    /* Writing the whole memory space to H5S_ALL with a different number of
+     * elements resizes the dataset to the memory space.
+     */
+    if (H5S_ALL == file_space_id) {
+        if (H5S_ALL != mem_space_id && (hsize_t)H5Sget_select_npoints(mem_space_id) != xfer->old_nelmts) {
+            xfer->rank = H5Sget_simple_extent_ndims(mem_space_id);
+            if (H5Sget_select_type(mem_space_id) != H5S_SEL_ALL || xfer->rank < 0 ||
+                xfer->rank > H5S_MAX_RANK) {
+                ret = -1;
+                goto done;
+            }
+            H5Sget_simple_extent_dims(mem_space_id, xfer->dims, NULL);
+            xfer->nelmts = (hsize_t)H5Sget_simple_extent_npoints(mem_space_id);
+            resize       = true;
+        }
+        fsid = esid = H5Screate_simple(xfer->rank, xfer->dims, NULL);
+    }
+    if (H5S_ALL == mem_space_id)
+        msid = fsid;
+
+    npoints = H5Sget_select_npoints(fsid);
+    if (npoints < 0 || npoints != H5Sget_select_npoints(msid)) {
+        ret = -1;
+        goto done;
+    }
+    xfer->npoints = (hsize_t)npoints;
+
+    init_selection(&(xfer->file_sel), fsid, msid, es);
+
+    /* A write to a dataset that's still waiting to be created joins it in
+     * the file's batch (unless it changes the extent, which later operations
+     * are set up against)
+     */
+    batched = NULL == req && !resize && is_batched(obj);
+
+    /* Elements of another type are gathered and converted to the stored
+     * type first, and then written like any other contiguous buffer. This
+     * happens here, so the caller's buffer is free once this returns. Batched
+     * writes gather a copy of the elements, for the same reason.
+     */
+    get_mem_type(mem_type_id, &mtype);
+    convert = !types_equal(&mtype, &(dset->type));
+    if ((convert || batched) && npoints > 0) {
+        struct selection gather;
+        hsize_t          n = (hsize_t)npoints;
+        char *           gathered;
+
+        tsid       = H5Screate_simple(1, &n, NULL);
+        xfer->fbuf = malloc((size_t)n * MAX(es, mtype.size));
+        if (convert)
+            mbuf = malloc((size_t)n * mtype.size);
+        gathered = convert ? mbuf : xfer->fbuf;
+
+        init_selection(&gather, tsid, msid, mtype.size);
+        if (iterate_selections(obj, &gather, (void *)buf, copy_to_array_op, gathered) < 0 ||
+            (convert && convert_elements(&mtype, mem_type_id, &(dset->type), H5I_INVALID_HID, (size_t)n,
+                                         mbuf, xfer->fbuf) < 0)) {
+            ret = -1;
+            goto done;
+        }
+
+        init_selection(&(xfer->file_sel), fsid, tsid, es);
+        xfer->buf = xfer->fbuf;
+    }
+
+    /* Allocate storage up to the last selected element (row-major, so the
+     * selection's bounding box corner is the furthest point).
+     */
+    if (TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout && TUTORIAL_DATA_FORMAT_BINARY == dset->format &&
+        npoints > 0) {
+        hsize_t start[H5S_MAX_RANK];
+        hsize_t end[H5S_MAX_RANK];
+        hsize_t last = 0;
+
+        if (H5Sget_select_bounds(fsid, start, end) >= 0) {
+            for (int i = 0; i < xfer->rank; i++)
+                last = last * xfer->dims[i] + end[i];
+            xfer->alloc_nelmts = last + 1;
+        }
+    }
+
+    /* Later operations are set up against the current extent, so writes
+     * that change it don't run in the background
+     */
+    if (resize)
+        req = NULL;
+
+    /* Small writes to binary data files can wait in the file's write buffer.
+     * A dataset that's still waiting to be created has nothing there.
+     */
+    xfer->buffer = !batched && !resize && TUTORIAL_LAYOUT_CONTIGUOUS == dset->layout &&
+                   TUTORIAL_DATA_FORMAT_BINARY == dset->format && !dset->use_mmap &&
+                   write_buffer_takes(obj->file, xfer->npoints * es);
+    xfer->drain  = !batched && !xfer->buffer;
+
+    /* The dataspaces go away when this returns */
+    if ((req || batched) && flatten_selection(&(xfer->file_sel)) < 0) {
+        ret = -1;
+        goto done;
+    }
+
+    if (batched)
+        batch_task(obj, run_write, free_transfer, xfer);
+    else
+        ret = submit_task(obj->file, run_write, free_transfer, xfer, !resize, req);
+    xfer = NULL;
+
+done:
+    if (xfer)
+        free_transfer(xfer);
+    free(mbuf);
+    if (tsid >= 0)
+        H5Sclose(tsid);
+    if (esid >= 0)
+        H5Sclose(esid);
+
+    return ret;
+}
+
+herr_t
+tutorial_dataset_get(void *_obj, H5VL_dataset_get_args_t *args, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object * obj  = (struct tutorial_object *)_obj;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
 
-    /* Get the number of elements in the memory space */
-    H5Sget_simple_extent_dims(mem_space_id, &dims, &maxdims);
+    switch (args->op_type) {
+        case H5VL_DATASET_GET_SPACE: {
+            if ((args->args.get_space.space_id = H5Screate_simple(dset->rank, dset->dims, dset->maxdims)) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_DATASET_GET_TYPE: {
+            if ((args->args.get_type.type_id = type_to_hid(&(dset->type))) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_DATASET_GET_DAPL:
+        case H5VL_DATASET_GET_DCPL:
+        case H5VL_DATASET_GET_SPACE_STATUS:
+        case H5VL_DATASET_GET_STORAGE_SIZE:
+        default:
+            return -1;
+    }
+
+    return 0;
+}
 
-    /* Write out the data */
-    write_data(obj, dims, (const int *)buf);
+herr_t
+tutorial_dataset_specific(void *_obj, H5VL_dataset_specific_args_t *args, hid_t dxpl_id, void **req)
+{
+    struct tutorial_object * obj  = (struct tutorial_object *)_obj;
+    struct tutorial_dataset *dset = &(obj->data.dataset);
 
-    /* Write out the new dataspace */
-    write_dataspace_file(obj, dims);
+    switch (args->op_type) {
+        case H5VL_DATASET_FLUSH: {
+            wait_for_tasks(obj->file);
+            if (drain_write_buffer(obj->file, obj->path, false) < 0)
+                return -1;
+            if (dset->map)
+                msync(dset->map, dset->map_size, MS_SYNC);
+            if (dset->data_file)
+                fflush(dset->data_file);
+            if (dset->space_file)
+                fflush(dset->space_file);
+            break;
+        }
+        case H5VL_DATASET_SET_EXTENT: {
+            /* Queued and buffered writes were set up against the current
+             * extent
+             */
+            wait_for_tasks(obj->file);
+            if (drain_write_buffer(obj->file, obj->path, false) < 0 || reopen_replaced_data_file(obj) < 0 ||
+                set_extent(obj, args->args.set_extent.size) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_DATASET_REFRESH:
+        default:
+            return -1;
+    }
 
     return 0;
 }
@@ -375,13 +3213,34 @@ tutorial_dataset_close(void *_obj, hid_t dxpl_id, void **req)
 {
     struct tutorial_object * obj  = (struct tutorial_object *)_obj;
     struct tutorial_dataset *dset = &(obj->data.dataset);
+    herr_t                   ret  = 0;
 
-    /* Close the dataset's files */
-    fclose(dset->data_file);
-    fclose(dset->space_file);
+    /* A dataset that's still waiting to be created is closed once it is */
+    if (batch_close(obj, tutorial_dataset_close))
+        return 0;
+
+    /* Finish anything still queued or buffered for the dataset */
+    wait_for_tasks(obj->file);
+    ret = drain_write_buffer(obj->file, obj->path, false);
+
+    /* Write back and drop the mapping */
+    if (dset->map) {
+        msync(dset->map, dset->map_size, MS_SYNC);
+        unmap_data_file(obj);
+    }
+
+    /* Close the dataset's files, or keep them for the next open */
+    if (!cache_release_dataset(obj->file->cache, obj->path, dset)) {
+        if (dset->data_file)
+            fclose(dset->data_file);
+        if (dset->space_file)
+            fclose(dset->space_file);
+        if (dset->dir_fd >= 0)
+            close(dset->dir_fd);
+    }
 
     /* Destroy the object */
     destroy_object(&obj);
 
-    return 0;
+    return ret;
 }
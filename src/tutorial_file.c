@@ -7,9 +7,9 @@
  *              layer (VOL) connector
  */
 
-#define _XOPEN_SOURCE 500
-#include <ftw.h>
+#include <fcntl.h>
 #include <hdf5.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,11 +17,92 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include "tutorial_arena.h"
+#include "tutorial_batch.h"
+#include "tutorial_cache.h"
 #include "tutorial_internal.h"
+#include "tutorial_journal.h"
+#include "tutorial_pool.h"
+#include "tutorial_request.h"
 #include "tutorial_util.h"
+#include "tutorial_vol_connector.h"
+#include "tutorial_writeback.h"
 
 #define MARKER_FILE_NAME "TUTORIAL_VOL_CONNECTOR_FILE"
 
+/* Write buffer size used with a journal when the FAPL doesn't give one, so
+ * writes are committed in groups
+ */
+#define DURABLE_WRITE_BUFFER_SIZE ((size_t)4 * 1024 * 1024)
+
+/* What a file deleted in the background is renamed to first, with the
+ * process ID and a count after it
+ */
+#define TRASH_SUFFIX ".deleting"
+
+/* A file being deleted in the background */
+struct background_delete {
+    struct tutorial_file *scratch;
+    char *                trash;
+};
+
+/* Deletes still running in the background */
+static pthread_mutex_t deletes_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  deletes_done = PTHREAD_COND_INITIALIZER;
+static size_t          ndeletes     = 0;
+static unsigned long   trash_count  = 0;
+
+static void
+get_file_settings(struct tutorial_file *f, hid_t fapl_id)
+{
+    int buffer_size;
+    int nthreads;
+
+    /* Default data file format for new datasets */
+    if (TUTORIAL_VOL_DATA_FORMAT_TEXT ==
+        get_int_property(fapl_id, TUTORIAL_VOL_DATA_FORMAT_PROP, TUTORIAL_VOL_DATA_FORMAT_BINARY))
+        f->data_format = TUTORIAL_DATA_FORMAT_TEXT;
+    else
+        f->data_format = TUTORIAL_DATA_FORMAT_BINARY;
+
+    /* Default data access mode */
+    f->use_mmap = (0 != get_int_property(fapl_id, TUTORIAL_VOL_MMAP_PROP, 0));
+
+    /* Name indexes for new groups */
+    f->use_index = (0 != get_int_property(fapl_id, TUTORIAL_VOL_GROUP_INDEX_PROP, 0));
+
+    /* Batched creation */
+    f->batch_create = (0 != get_int_property(fapl_id, TUTORIAL_VOL_BATCH_CREATE_PROP, 0));
+
+    /* Write-back buffering */
+    buffer_size          = get_int_property(fapl_id, TUTORIAL_VOL_WRITE_BUFFER_PROP, 0);
+    f->write_buffer_size = buffer_size > 0 ? (size_t)buffer_size : 0;
+    f->write_buffer_ms   = get_int_property(fapl_id, TUTORIAL_VOL_WRITE_BUFFER_MS_PROP, 0);
+
+    /* Threads for large reads and writes */
+    nthreads = get_int_property(fapl_id, TUTORIAL_VOL_NTHREADS_PROP, 0);
+    if (nthreads <= 0)
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    f->nthreads = nthreads > 0 ? (size_t)nthreads : 1;
+}
+
+/* Files opened for writing with TUTORIAL_VOL_DURABLE_PROP log their writes
+ * in a journal, and commit them in groups from the write buffer
+ */
+static herr_t
+start_journal(struct tutorial_file *f, hid_t fapl_id)
+{
+    if (0 == get_int_property(fapl_id, TUTORIAL_VOL_DURABLE_PROP, 0))
+        return 0;
+
+    if (NULL == (f->journal = open_journal(f->filename)))
+        return -1;
+    if (0 == f->write_buffer_size)
+        f->write_buffer_size = DURABLE_WRITE_BUFFER_SIZE;
+
+    return 0;
+}
+
 static void
 add_hdf5_marker(const char *filename)
 {
@@ -53,17 +134,107 @@ check_hdf5_marker(const char *filename)
     return ret;
 }
 
-static int
-remove_callback(const char *pathname, const struct stat *sbuf, int type, struct FTW *ftwb)
+static void *
+background_delete_thread(void *arg)
+{
+    struct background_delete *bd = (struct background_delete *)arg;
+
+    remove_tree_parallel(bd->scratch, AT_FDCWD, bd->trash);
+    stop_pool(bd->scratch);
+
+    free(bd->scratch);
+    free(bd->trash);
+    free(bd);
+
+    pthread_mutex_lock(&deletes_lock);
+    if (0 == --ndeletes)
+        pthread_cond_broadcast(&deletes_done);
+    pthread_mutex_unlock(&deletes_lock);
+
+    return NULL;
+}
+
+/* Renames filename out of the way, so the name is free as soon as this
+ * returns, and removes it on a background thread
+ */
+static herr_t
+delete_in_background(struct tutorial_file *scratch, const char *filename)
 {
-    remove(pathname);
+    struct background_delete *bd = NULL;
+    pthread_attr_t            attr;
+    pthread_t                 thread;
+    char *                    trash = NULL;
+    unsigned long             count;
+    int                       len;
+
+    pthread_mutex_lock(&deletes_lock);
+    count = trash_count++;
+    pthread_mutex_unlock(&deletes_lock);
+
+    len   = snprintf(NULL, 0, "%s" TRASH_SUFFIX ".%ld.%lu", filename, (long)getpid(), count);
+    trash = malloc((size_t)len + 1);
+    snprintf(trash, (size_t)len + 1, "%s" TRASH_SUFFIX ".%ld.%lu", filename, (long)getpid(), count);
+
+    if (rename(filename, trash) < 0) {
+        free(trash);
+        return -1;
+    }
+
+    bd          = malloc(sizeof(struct background_delete));
+    bd->scratch = scratch;
+    bd->trash   = trash;
+
+    pthread_mutex_lock(&deletes_lock);
+    ndeletes++;
+    pthread_mutex_unlock(&deletes_lock);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (0 != pthread_create(&thread, &attr, background_delete_thread, bd))
+        /* Without a thread, it's removed now */
+        background_delete_thread(bd);
+    pthread_attr_destroy(&attr);
+
     return 0;
 }
 
-static void
-recursive_removal(const char *root)
+/* Removes a file's directory tree, over the threads the FAPL asks for, or
+ * in the background with TUTORIAL_VOL_DELETE_IN_BACKGROUND_PROP. There's
+ * no open file for the pool to belong to, so a scratch one holds it.
+ */
+static herr_t
+delete_file(const char *filename, hid_t fapl_id)
 {
-    nftw(root, remove_callback, 10, FTW_DEPTH | FTW_MOUNT | FTW_PHYS);
+    struct tutorial_file *scratch = NULL;
+    herr_t                ret     = 0;
+
+    scratch = calloc(1, sizeof(struct tutorial_file));
+    get_file_settings(scratch, fapl_id);
+
+    if (0 != get_int_property(fapl_id, TUTORIAL_VOL_DELETE_IN_BACKGROUND_PROP, 0)) {
+        if (delete_in_background(scratch, filename) < 0) {
+            free(scratch);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (remove_tree_parallel(scratch, AT_FDCWD, filename) < 0)
+        ret = -1;
+    stop_pool(scratch);
+    free(scratch);
+
+    return ret;
+}
+
+/* Waits for the files being deleted in the background */
+void
+wait_for_deletes(void)
+{
+    pthread_mutex_lock(&deletes_lock);
+    while (ndeletes > 0)
+        pthread_cond_wait(&deletes_done, &deletes_lock);
+    pthread_mutex_unlock(&deletes_lock);
 }
 
 void *
@@ -80,13 +251,22 @@ tutorial_file_create(const char *name, unsigned flags, hid_t fcpl_id, hid_t fapl
 
     /* Save this for later */
     f->filename = strdup(name);
+    get_file_settings(f, fapl_id);
+    f->cache = create_cache();
+    f->arena = create_arena();
+    f->nrefs = 1;
 
     /* Create the root group */
-    f->root = init_group(NULL, name, true);
+    f->root = init_group(f, NULL, name, true);
 
     /* Add a marker that this is an HDF5 file */
     add_hdf5_marker(name);
 
+    if (start_journal(f, fapl_id) < 0) {
+        tutorial_file_close(f, dxpl_id, NULL);
+        return NULL;
+    }
+
     return f;
 }
 
@@ -99,13 +279,26 @@ tutorial_file_open(const char *name, unsigned flags, hid_t fapl_id, hid_t dxpl_i
     if (!check_hdf5_marker(name))
         return NULL;
 
+    /* Finish any writes a crash cut short (which takes write access) */
+    if (recover_journal(name, 0 != (flags & H5F_ACC_RDWR)) < 0)
+        return NULL;
+
     f = calloc(1, sizeof(struct tutorial_file));
 
     /* Save this for later */
     f->filename = strdup(name);
+    get_file_settings(f, fapl_id);
+    f->cache = create_cache();
+    f->arena = create_arena();
+    f->nrefs = 1;
 
     /* Open the root group */
-    f->root = init_group(NULL, name, false);
+    f->root = init_group(f, NULL, name, false);
+
+    if ((flags & H5F_ACC_RDWR) && start_journal(f, fapl_id) < 0) {
+        tutorial_file_close(f, dxpl_id, NULL);
+        return NULL;
+    }
 
     return f;
 }
@@ -114,8 +307,24 @@ herr_t
 tutorial_file_specific(void *obj, H5VL_file_specific_args_t *args, hid_t dxpl_id, void **req)
 {
     switch (args->op_type) {
+        case H5VL_FILE_FLUSH: {
+            struct tutorial_file *f = H5I_FILE == args->args.flush.obj_type
+                                          ? (struct tutorial_file *)obj
+                                          : ((struct tutorial_object *)obj)->file;
+
+            /* Finish everything queued, held back or buffered, and report
+             * anything held back or buffered that failed. Then everything
+             * logged in the journal is on disk, so it can be emptied.
+             */
+            wait_for_tasks(f);
+            if (flush_batch(f, true) < 0 || drain_write_buffer(f, NULL, true) < 0 ||
+                checkpoint_journal(f, true) < 0)
+                return -1;
+            break;
+        }
         case H5VL_FILE_DELETE: {
-            recursive_removal(args->args.del.filename);
+            if (delete_file(args->args.del.filename, args->args.del.fapl_id) < 0)
+                return -1;
             break;
         }
         case H5VL_FILE_IS_ACCESSIBLE: {
@@ -139,13 +348,48 @@ tutorial_file_specific(void *obj, H5VL_file_specific_args_t *args, hid_t dxpl_id
 herr_t
 tutorial_file_close(void *file, hid_t dxpl_id, void **req)
 {
-    struct tutorial_file *f = (struct tutorial_file *)file;
+    struct tutorial_file *f   = (struct tutorial_file *)file;
+    herr_t                ret = 0;
+
+    /* Finish any asynchronous operations and anything held back in the
+     * batch or the write buffer, empty the journal, then stop the
+     * background threads
+     */
+    stop_task_thread(f);
+    ret = flush_batch(f, true);
+    if (drain_write_buffer(f, NULL, true) < 0 || checkpoint_journal(f, true) < 0)
+        ret = -1;
+    close_journal(f);
+    stop_pool(f);
 
     /* The root group doesn't have an ID, so we manually close it */
     tutorial_group_close(f->root, dxpl_id, NULL);
 
+    /* Objects can outlive the file's ID, and keep the rest until then */
+    release_file(f);
+
+    return ret;
+}
+
+/* Drops a reference to a file, freeing it once the file and all of its
+ * objects are closed
+ */
+void
+release_file(struct tutorial_file *f)
+{
+    if (--f->nrefs > 0)
+        return;
+
+    /* Anything the objects did after the file was closed has finished
+     * (closing them waits for it), but may have started the threads again
+     */
+    stop_task_thread(f);
+    stop_pool(f);
+
+    /* Close the handles the cache kept, then free every object at once */
+    free_cache(f->cache);
+    free_arena(f->arena);
+
     free(f->filename);
     free(f);
-
-    return 0;
 }
@@ -0,0 +1,168 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Chunk filters for a simple tutorial virtual object layer
+ *              (VOL) connector
+ *
+ *              Chunked datasets can have their chunks shuffled (the bytes
+ *              of the elements regrouped so the first byte of every element
+ *              comes first, then every second byte, and so on) and
+ *              compressed with zlib, as set with H5Pset_shuffle() and
+ *              H5Pset_deflate(). Each chunk is filtered on its own, so
+ *              reading part of a dataset only decompresses the chunks the
+ *              selection touches. A chunk that doesn't get any smaller is
+ *              stored as it is, and its header says which filters were
+ *              applied.
+ */
+
+#include <hdf5.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "tutorial_filter.h"
+#include "tutorial_internal.h"
+
+/* Level used when H5Pset_deflate() didn't give one */
+#define DEFAULT_DEFLATE_LEVEL 6
+
+/* Works out the filters from a dataset creation property list. Filters
+ * other than shuffle and deflate are skipped if they're optional, and
+ * otherwise the dataset can't be created.
+ */
+herr_t
+get_filters(hid_t dcpl_id, unsigned *filters, int *deflate_level)
+{
+    int nfilters;
+
+    *filters       = 0;
+    *deflate_level = DEFAULT_DEFLATE_LEVEL;
+
+    if (H5P_DEFAULT == dcpl_id)
+        return 0;
+
+    if ((nfilters = H5Pget_nfilters(dcpl_id)) < 0)
+        return -1;
+
+    for (unsigned i = 0; i < (unsigned)nfilters; i++) {
+        unsigned     flags;
+        unsigned     cd_values[4];
+        size_t       cd_nelmts = sizeof(cd_values) / sizeof(cd_values[0]);
+        H5Z_filter_t id;
+
+        if ((id = H5Pget_filter2(dcpl_id, i, &flags, &cd_nelmts, cd_values, 0, NULL, NULL)) < 0)
+            return -1;
+
+        switch (id) {
+            case H5Z_FILTER_SHUFFLE:
+                *filters |= TUTORIAL_FILTER_SHUFFLE;
+                break;
+            case H5Z_FILTER_DEFLATE:
+                *filters |= TUTORIAL_FILTER_DEFLATE;
+                if (cd_nelmts > 0 && cd_values[0] <= 9)
+                    *deflate_level = (int)cd_values[0];
+                break;
+            default:
+                if (!(flags & H5Z_FLAG_OPTIONAL))
+                    return -1;
+                break;
+        }
+    }
+
+    return 0;
+}
+
+/* Regroups the bytes of n elements so byte b of every element comes before
+ * byte b + 1 of any
+ */
+static void
+shuffle(const unsigned char *in, unsigned char *out, size_t n, size_t size)
+{
+    for (size_t b = 0; b < size; b++)
+        for (size_t i = 0; i < n; i++)
+            out[b * n + i] = in[i * size + b];
+}
+
+static void
+unshuffle(const unsigned char *in, unsigned char *out, size_t n, size_t size)
+{
+    for (size_t b = 0; b < size; b++)
+        for (size_t i = 0; i < n; i++)
+            out[i * size + b] = in[b * n + i];
+}
+
+/* Runs nbytes of elements through the filters. Returns the filtered bytes
+ * (in *size, to be freed by the caller), or NULL if the filters didn't
+ * make them any smaller and they should be stored as they are.
+ */
+void *
+encode_chunk(unsigned filters, int deflate_level, size_t elmt_size, const void *data, size_t nbytes,
+             size_t *size)
+{
+    unsigned char *shuffled = NULL;
+    unsigned char *out      = NULL;
+    uLongf         out_size;
+
+    /* Shuffling on its own doesn't change the size */
+    if (!(filters & TUTORIAL_FILTER_DEFLATE) || 0 == nbytes)
+        return NULL;
+
+    if ((filters & TUTORIAL_FILTER_SHUFFLE) && elmt_size > 1) {
+        if (NULL == (shuffled = malloc(nbytes)))
+            return NULL;
+        shuffle(data, shuffled, nbytes / elmt_size, elmt_size);
+        data = shuffled;
+    }
+
+    /* Anything that doesn't fit in fewer bytes isn't worth keeping */
+    out_size = (uLongf)nbytes - 1;
+    if (NULL != (out = malloc(nbytes)) &&
+        compress2(out, &out_size, data, (uLong)nbytes, deflate_level) != Z_OK) {
+        free(out);
+        out = NULL;
+    }
+
+    free(shuffled);
+
+    if (out)
+        *size = (size_t)out_size;
+
+    return out;
+}
+
+/* Undoes the filters on size bytes of a stored chunk. *nbytes is the size of
+ * data on the way in, and the number of bytes of elements in it on the way
+ * out.
+ */
+herr_t
+decode_chunk(unsigned filters, size_t elmt_size, const void *in, size_t size, void *data, size_t *nbytes)
+{
+    unsigned char *shuffled = NULL;
+    uLongf         out_size = (uLongf)*nbytes;
+    herr_t         ret      = 0;
+
+    if ((filters & TUTORIAL_FILTER_SHUFFLE) && elmt_size > 1 && NULL == (shuffled = malloc(*nbytes)))
+        return -1;
+
+    if (filters & TUTORIAL_FILTER_DEFLATE) {
+        if (uncompress(shuffled ? shuffled : data, &out_size, in, (uLong)size) != Z_OK)
+            ret = -1;
+    }
+    else {
+        out_size = size < *nbytes ? size : *nbytes;
+        memcpy(shuffled ? shuffled : data, in, out_size);
+    }
+
+    /* Only whole elements can be put back */
+    out_size -= out_size % elmt_size;
+    if (ret >= 0 && shuffled)
+        unshuffle(shuffled, data, out_size / elmt_size, elmt_size);
+
+    free(shuffled);
+
+    *nbytes = (size_t)out_size;
+
+    return ret;
+}
@@ -0,0 +1,24 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Chunk filters for a simple tutorial virtual object layer
+ *              (VOL) connector
+ */
+
+#ifndef TUTORIAL_FILTER_H
+#define TUTORIAL_FILTER_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+herr_t get_filters(hid_t dcpl_id, unsigned *filters, int *deflate_level);
+
+void * encode_chunk(unsigned filters, int deflate_level, size_t elmt_size, const void *data, size_t nbytes,
+                    size_t *size);
+herr_t decode_chunk(unsigned filters, size_t elmt_size, const void *in, size_t size, void *data,
+                    size_t *nbytes);
+
+#endif /* TUTORIAL_FILTER_H */
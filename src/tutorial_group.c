@@ -8,16 +8,22 @@
  */
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <hdf5.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include "tutorial_batch.h"
+#include "tutorial_cache.h"
+#include "tutorial_index.h"
 #include "tutorial_internal.h"
+#include "tutorial_request.h"
 #include "tutorial_util.h"
 
-struct tutorial_object *
-init_group(struct tutorial_object *parent, const char *name, hbool_t create_on_disk)
+static struct tutorial_object *
+make_group(struct tutorial_file *file, struct tutorial_object *parent, const char *name)
 {
     struct tutorial_object *obj = NULL;
 
@@ -26,12 +32,83 @@ init_group(struct tutorial_object *parent, const char *name, hbool_t create_on_d
     /* Create the new group structure */
     if (NULL == parent) {
         /* Special case for root group */
-        obj = make_object(H5I_GROUP, ".", name);
+        obj = make_object(file, H5I_GROUP, ".", name);
     }
     else {
-        obj = make_object(H5I_GROUP, parent->path, name);
+        obj = make_object(parent->file, H5I_GROUP, parent->path, name);
+    }
+
+    return obj;
+}
+
+/* Creating a group in the background needs the parent, which stays open
+ * since closing it waits for the file's tasks. Its directory is looked up
+ * when the task runs, as the parent may still be being created.
+ */
+struct group_task {
+    struct tutorial_object *obj;
+    struct tutorial_object *parent;
+};
+
+/* Creates the group's directory and opens it (a task, so it may run on the
+ * file's background thread)
+ */
+static herr_t
+create_group_dir(void *task_data)
+{
+    struct group_task *     task  = (struct group_task *)task_data;
+    struct tutorial_object *obj   = task->obj;
+    struct tutorial_group * group = &(obj->data.group);
+    hbool_t                 made  = false;
+
+    made = (0 == mkdirat(group_fd(task->parent), obj->name, 0700));
+    if (index_insert(group_fd(task->parent), obj->name, H5I_GROUP) < 0)
+        return -1;
+
+    /* Nothing cached for an earlier object at the path still applies, and
+     * the parent's listing is out of date
+     */
+    cache_evict(obj->file->cache, obj->path);
+
+    if (NULL == (group->dir = opendir_at(group_fd(task->parent), obj->name)))
+        return -1;
+
+    /* A group that was already there keeps the index it had (or didn't) */
+    if (made && obj->file->use_index && create_index(dirfd(group->dir)) < 0)
+        return -1;
+
+    return 0;
+}
+
+/* Opens the group name, relative to parent */
+struct tutorial_object *
+open_group(struct tutorial_object *parent, const char *name)
+{
+    struct tutorial_object *obj = NULL;
+
+    obj = make_group(parent->file, parent, name);
+
+    struct tutorial_group *group = &(obj->data.group);
+
+    /* Reuse the directory handle of a closed group if there is one */
+    if (NULL == (group->dir = cache_lookup_dir(obj->file->cache, obj->path)))
+        group->dir = opendir_at(group_fd(parent), obj->name);
+
+    if (NULL == group->dir) {
+        destroy_object(&obj);
+        return NULL;
     }
 
+    return obj;
+}
+
+struct tutorial_object *
+init_group(struct tutorial_file *file, struct tutorial_object *parent, const char *name, hbool_t create_on_disk)
+{
+    struct tutorial_object *obj = NULL;
+
+    obj = make_group(file, parent, name);
+
     /* Create the group, if desired */
     if (create_on_disk)
         mkdir(obj->path, 0700);
@@ -41,15 +118,262 @@ init_group(struct tutorial_object *parent, const char *name, hbool_t create_on_d
     /* Open and store the directory state */
     group->dir = opendir(obj->path);
 
+    if (create_on_disk && group->dir && file->use_index)
+        create_index(dirfd(group->dir));
+
     return obj;
 }
 
+/* The directory that a group's members are opened relative to */
+int
+group_fd(const struct tutorial_object *obj)
+{
+    return obj->data.group.dir ? dirfd(obj->data.group.dir) : -1;
+}
+
+/* The group an operation's location is relative to (for a file, its root
+ * group)
+ */
+struct tutorial_object *
+loc_group(void *obj, const H5VL_loc_params_t *loc_params)
+{
+    if (H5I_FILE == loc_params->obj_type)
+        return ((struct tutorial_file *)obj)->root;
+
+    return (struct tutorial_object *)obj;
+}
+
+/* Looks up the group name, relative to parent, for a query. Returns parent
+ * itself for ".", or NULL if there's no such group. Pass the result to
+ * release_group() when done.
+ */
+struct tutorial_object *
+lookup_group(struct tutorial_object *parent, const char *name)
+{
+    parent = resolve_name(parent, &name);
+    if (0 == strcmp(name, "."))
+        return parent;
+
+    /* Datasets are directories too */
+    if (!is_subgroup(parent, name))
+        return NULL;
+
+    return open_group(parent, name);
+}
+
+void
+release_group(struct tutorial_object *parent, struct tutorial_object *group)
+{
+    if (group && group != parent && group != parent->file->root)
+        tutorial_group_close(group, H5P_DEFAULT, NULL);
+}
+
+/* Looks up the group that an operation's location names, relative to
+ * parent (which is returned for H5VL_OBJECT_BY_SELF)
+ */
+struct tutorial_object *
+lookup_group_by_loc(struct tutorial_object *parent, const H5VL_loc_params_t *loc_params)
+{
+    struct tutorial_object * group   = NULL;
+    struct tutorial_object * member  = NULL;
+    struct tutorial_listing *listing = NULL;
+    const char *             name    = NULL;
+
+    switch (loc_params->type) {
+        case H5VL_OBJECT_BY_SELF:
+            return parent;
+
+        case H5VL_OBJECT_BY_NAME:
+            return lookup_group(parent, loc_params->loc_data.loc_by_name.name);
+
+        case H5VL_OBJECT_BY_IDX:
+            /* Only the name index exists */
+            if (H5_INDEX_NAME != loc_params->loc_data.loc_by_idx.idx_type)
+                return NULL;
+
+            if (NULL == (group = lookup_group(parent, loc_params->loc_data.loc_by_idx.name)))
+                return NULL;
+
+            if (NULL != (listing = get_listing(group))) {
+                name = listing_name(listing, loc_params->loc_data.loc_by_idx.order,
+                                    loc_params->loc_data.loc_by_idx.n);
+                if (name && is_subgroup(group, name))
+                    member = open_group(group, name);
+                release_listing(group, listing);
+            }
+
+            release_group(parent, group);
+            return member;
+
+        case H5VL_OBJECT_BY_TOKEN:
+        default:
+            return NULL;
+    }
+}
+
+static int
+compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Reads a group's directory into a new listing. Every subdirectory is a
+ * member (the group's other files, like the root group's marker, aren't).
+ */
+static struct tutorial_listing *
+read_listing(struct tutorial_object *group)
+{
+    struct tutorial_listing *listing        = NULL;
+    DIR *                    dir            = NULL;
+    struct dirent *          entry          = NULL;
+    size_t *                 offsets        = NULL;
+    size_t                   noffsets_alloc = 0;
+    size_t                   buf_size       = 0;
+    size_t                   buf_alloc      = 0;
+
+    /* A directory stream of our own, so the group's isn't disturbed */
+    if (NULL == (dir = opendir_at(group_fd(group), ".")))
+        return NULL;
+
+    listing = calloc(1, sizeof(struct tutorial_listing));
+
+    while (NULL != (entry = readdir(dir))) {
+        size_t len = strlen(entry->d_name) + 1;
+
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        if (DT_DIR != entry->d_type) {
+            struct stat st;
+
+            if (DT_UNKNOWN != entry->d_type || fstatat(dirfd(dir), entry->d_name, &st, 0) < 0 ||
+                !S_ISDIR(st.st_mode))
+                continue;
+        }
+
+        /* Names are packed into one buffer and indexed afterwards, since
+         * the buffer moves as it grows
+         */
+        if (listing->nnames == noffsets_alloc) {
+            noffsets_alloc = noffsets_alloc ? noffsets_alloc * 2 : 64;
+            offsets        = realloc(offsets, noffsets_alloc * sizeof(size_t));
+        }
+        if (buf_size + len > buf_alloc) {
+            buf_alloc    = (buf_size + len) * 2;
+            listing->buf = realloc(listing->buf, buf_alloc);
+        }
+
+        offsets[listing->nnames++] = buf_size;
+        memcpy(listing->buf + buf_size, entry->d_name, len);
+        buf_size += len;
+    }
+
+    closedir(dir);
+
+    listing->names = malloc((listing->nnames ? listing->nnames : 1) * sizeof(char *));
+    for (size_t i = 0; i < listing->nnames; i++)
+        listing->names[i] = listing->buf + offsets[i];
+    free(offsets);
+
+    qsort(listing->names, listing->nnames, sizeof(char *), compare_names);
+
+    return listing;
+}
+
+/* Returns a group's member listing, reading the directory only if nothing
+ * has been cached since the group last changed. Pass it to
+ * release_listing() when done.
+ */
+struct tutorial_listing *
+get_listing(struct tutorial_object *group)
+{
+    struct tutorial_listing *listing = NULL;
+
+    if (NULL != (listing = cache_lookup_listing(group->file->cache, group->path)))
+        return listing;
+
+    if (NULL == (listing = read_listing(group)))
+        return NULL;
+
+    listing->refcount = 1;
+    cache_store_listing(group->file->cache, group->path, listing);
+
+    return listing;
+}
+
+void
+release_listing(struct tutorial_object *group, struct tutorial_listing *listing)
+{
+    cache_release_listing(group->file->cache, listing);
+}
+
+void
+free_listing(struct tutorial_listing *listing)
+{
+    free(listing->names);
+    free(listing->buf);
+    free(listing);
+}
+
+/* The nth member in the given order, or NULL if there aren't that many */
+const char *
+listing_name(const struct tutorial_listing *listing, H5_iter_order_t order, hsize_t n)
+{
+    if (n >= listing->nnames)
+        return NULL;
+
+    return listing->names[H5_ITER_DEC == order ? listing->nnames - 1 - n : n];
+}
+
+/* Whether name is a member (a binary search) */
+hbool_t
+listing_contains(const struct tutorial_listing *listing, const char *name)
+{
+    return NULL != bsearch(&name, listing->names, listing->nnames, sizeof(char *), compare_names);
+}
+
+/* Looks up a member in the group's name index, setting *type to H5I_GROUP,
+ * H5I_DATASET or (if there's no such member) H5I_BADID. Fails if the group
+ * doesn't have an index, so the caller can use its listing instead.
+ */
+herr_t
+group_index_lookup(struct tutorial_object *group, const char *name, H5I_type_t *type)
+{
+    struct tutorial_group *g = &(group->data.group);
+
+    if (!g->index_checked) {
+        g->index         = open_index(group_fd(group));
+        g->index_checked = true;
+    }
+
+    if (NULL == g->index)
+        return -1;
+
+    return index_lookup(g->index, name, type);
+}
+
+/* Whether the member name of a group (or a path within it) is a group
+ * itself, which the group's index says for its own members without
+ * looking at the member's directory
+ */
+hbool_t
+is_subgroup(struct tutorial_object *group, const char *name)
+{
+    H5I_type_t type;
+
+    if (NULL == strchr(name, '/') && group_index_lookup(group, name, &type) >= 0 && H5I_BADID != type)
+        return H5I_GROUP == type;
+
+    return !is_dataset_dir(group_fd(group), name);
+}
+
 void *
 tutorial_group_create(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t lcpl_id,
                       hid_t gcpl_id, hid_t gapl_id, hid_t dxpl_id, void **req)
 {
     struct tutorial_object *new_obj = NULL;
     struct tutorial_object *parent  = NULL;
+    struct group_task *     task    = NULL;
 
     /* Get the parent group */
     if (H5I_FILE == loc_params->obj_type) {
@@ -60,8 +384,24 @@ tutorial_group_create(void *obj, const H5VL_loc_params_t *loc_params, const char
         parent = (struct tutorial_object *)obj;
     }
 
-    /* Create the group */
-    new_obj = init_group(parent, name, true);
+    /* Absolute names are looked up from the root group */
+    parent = resolve_name(parent, &name);
+
+    /* Create the group, with the directory made in the background when
+     * there's a request to track it, or held back in the file's batch
+     */
+    new_obj      = make_group(parent->file, parent, name);
+    task         = malloc(sizeof(struct group_task));
+    task->obj    = new_obj;
+    task->parent = parent;
+
+    if (NULL == req && batch_create(new_obj, create_group_dir, free, task))
+        return (void *)new_obj;
+
+    if (submit_task(parent->file, create_group_dir, free, task, false, req) < 0) {
+        destroy_object(&new_obj);
+        return NULL;
+    }
 
     return (void *)new_obj;
 }
@@ -82,20 +422,81 @@ tutorial_group_open(void *_parent, const H5VL_loc_params_t *loc_params, const ch
         parent = (struct tutorial_object *)_parent;
     }
 
+    /* Absolute names are looked up from the root group */
+    parent = resolve_name(parent, &name);
+
+    /* The group may still be being created */
+    wait_for_tasks(parent->file);
+
     /* Open the group */
-    new_obj = init_group(parent, name, false);
+    new_obj = open_group(parent, name);
 
     return (void *)new_obj;
 }
 
+herr_t
+tutorial_group_get(void *obj, H5VL_group_get_args_t *args, hid_t dxpl_id, void **req)
+{
+    switch (args->op_type) {
+        case H5VL_GROUP_GET_GCPL: {
+            /* Groups don't have any creation properties of their own */
+            if ((args->args.get_gcpl.gcpl_id = H5Pcreate(H5P_GROUP_CREATE)) < 0)
+                return -1;
+            break;
+        }
+        case H5VL_GROUP_GET_INFO: {
+            H5VL_group_get_info_args_t *get_info = &(args->args.get_info);
+            struct tutorial_object *    parent   = loc_group(obj, &(get_info->loc_params));
+            struct tutorial_object *    group    = NULL;
+            struct tutorial_listing *   listing  = NULL;
+
+            /* Members may still be being created */
+            wait_for_tasks(parent->file);
+
+            if (NULL == (group = lookup_group_by_loc(parent, &(get_info->loc_params))))
+                return -1;
+            listing = get_listing(group);
+            release_group(parent, group);
+            if (NULL == listing)
+                return -1;
+
+            /* A directory is an index of its members, like dense storage,
+             * and nothing records the creation order
+             */
+            get_info->ginfo->storage_type = H5G_STORAGE_TYPE_DENSE;
+            get_info->ginfo->nlinks       = listing->nnames;
+            get_info->ginfo->max_corder   = 0;
+            get_info->ginfo->mounted      = false;
+
+            release_listing(parent, listing);
+            break;
+        }
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
 herr_t
 tutorial_group_close(void *_obj, hid_t dxpl_id, void **req)
 {
     struct tutorial_object *obj   = (struct tutorial_object *)_obj;
     struct tutorial_group * group = &(obj->data.group);
 
-    /* Close the directory */
-    closedir(group->dir);
+    /* A group that's still waiting to be created is closed once it is */
+    if (batch_close(obj, tutorial_group_close))
+        return 0;
+
+    /* Finish anything still queued for the group */
+    if (obj->file)
+        wait_for_tasks(obj->file);
+
+    close_index(group->index);
+
+    /* Close the directory, or keep it for the next open */
+    if (group->dir && !(obj->file && cache_release_dir(obj->file->cache, obj->path, group->dir)))
+        closedir(group->dir);
 
     /* Destroy the object */
     destroy_object(&obj);
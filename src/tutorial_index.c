@@ -0,0 +1,568 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Per-group name index for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              A group created in a file opened with TUTORIAL_VOL_GROUP_INDEX_PROP
+ *              gets an index file in its directory: an open-addressed hash
+ *              table from member names to object types, followed by a heap
+ *              holding the names. Finding out whether a member exists, and
+ *              whether it's a group or a dataset, is then one probe of the
+ *              (memory-mapped) table instead of a directory scan or stat
+ *              calls.
+ *
+ *              Creating or deleting a member of a group that has an index
+ *              updates it in place, whatever the file was opened with, so
+ *              the index never goes stale. Groups without one (including
+ *              those made by older versions of the connector) are queried
+ *              through their member listing instead.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <hdf5.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tutorial_index.h"
+#include "tutorial_internal.h"
+#include "tutorial_util.h"
+
+#define INDEX_FILE_NAME "TUTORIAL_VOL_GROUP_INDEX"
+#define INDEX_MAGIC     "TVGI"
+#define INDEX_VERSION   1
+
+/* Number of slots in a new index (always a power of two). The table is
+ * doubled whenever it would become more than half full, counting deleted
+ * slots.
+ */
+#define INDEX_INIT_NSLOTS 16
+
+/* Slot states and types */
+#define SLOT_EMPTY   0
+#define SLOT_GROUP   1
+#define SLOT_DATASET 2
+#define SLOT_DELETED 0xFF
+
+/* Bytes of each name kept in its slot, so short names are compared without
+ * looking at the heap
+ */
+#define SLOT_PREFIX_LEN 16
+
+/* The index file: a header, nslots slots, then heap_size bytes of names.
+ * Everything is in native byte order.
+ */
+struct index_header {
+    char     magic[4];
+    uint8_t  version;
+    uint8_t  reserved1[3];
+    uint32_t nslots;
+    uint32_t nused;    /* Slots holding a member */
+    uint32_t ndeleted; /* Slots of deleted members */
+    uint32_t heap_size;
+    uint64_t reserved2;
+};
+
+struct index_slot {
+    uint64_t hash;
+    uint32_t name_offset; /* In the heap */
+    uint8_t  name_len;
+    uint8_t  type; /* SLOT_* */
+    uint16_t reserved;
+    char     prefix[SLOT_PREFIX_LEN];
+};
+
+#define SLOTS_OFFSET     ((off_t)sizeof(struct index_header))
+#define SLOT_OFFSET(i)   (SLOTS_OFFSET + (off_t)(i) * (off_t)sizeof(struct index_slot))
+#define HEAP_OFFSET(hdr) SLOT_OFFSET((hdr)->nslots)
+#define INDEX_SIZE(hdr)  ((size_t)HEAP_OFFSET(hdr) + (hdr)->heap_size)
+
+/* An index mapped for lookups */
+struct tutorial_index {
+    int    fd;
+    void * map;
+    size_t map_size;
+};
+
+/*********/
+/* SLOTS */
+/*********/
+
+static uint8_t
+slot_type(H5I_type_t type)
+{
+    return H5I_GROUP == type ? SLOT_GROUP : SLOT_DATASET;
+}
+
+static H5I_type_t
+object_type(uint8_t type)
+{
+    return SLOT_GROUP == type ? H5I_GROUP : H5I_DATASET;
+}
+
+static void
+fill_slot(struct index_slot *slot, uint64_t hash, const char *name, size_t len, uint32_t name_offset,
+          uint8_t type)
+{
+    memset(slot, 0, sizeof(struct index_slot));
+
+    slot->hash        = hash;
+    slot->name_offset = name_offset;
+    slot->name_len    = (uint8_t)len;
+    slot->type        = type;
+    memcpy(slot->prefix, name, len < SLOT_PREFIX_LEN ? len : SLOT_PREFIX_LEN);
+}
+
+/* Whether a slot holds name, given the rest of the name (past the prefix)
+ * from the heap when it's longer than the prefix
+ */
+static hbool_t
+slot_matches(const struct index_slot *slot, uint64_t hash, const char *name, size_t len, const char *rest)
+{
+    if (SLOT_EMPTY == slot->type || SLOT_DELETED == slot->type || slot->hash != hash || slot->name_len != len)
+        return false;
+    if (memcmp(slot->prefix, name, len < SLOT_PREFIX_LEN ? len : SLOT_PREFIX_LEN) != 0)
+        return false;
+
+    return len <= SLOT_PREFIX_LEN ||
+           (rest && memcmp(rest, name + SLOT_PREFIX_LEN, len - SLOT_PREFIX_LEN) == 0);
+}
+
+/***********/
+/* UPDATES */
+/***********/
+
+/* Opens the index of the group holding name (relative to dir_fd), and
+ * points name at the name's last component
+ */
+static int
+open_parent_index(int dir_fd, const char **name, int flags)
+{
+    const char *slash = strrchr(*name, '/');
+    char        path[PATH_MAX];
+
+    if (slash) {
+        snprintf(path, sizeof(path), "%.*s/" INDEX_FILE_NAME, (int)(slash - *name), *name);
+        *name = slash + 1;
+    }
+    else
+        snprintf(path, sizeof(path), INDEX_FILE_NAME);
+
+    return openat(dir_fd, path, flags);
+}
+
+/* Opens the index of the group holding name for changing it. Members of a
+ * group can be created on several threads at once (by a batch), so the
+ * index stays locked until it's closed.
+ */
+static int
+lock_parent_index(int dir_fd, const char **name)
+{
+    int fd;
+
+    if ((fd = open_parent_index(dir_fd, name, O_RDWR)) < 0)
+        return -1;
+
+    if (flock(fd, LOCK_EX) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static herr_t
+read_header(int fd, struct index_header *hdr)
+{
+    if (pread(fd, hdr, sizeof(struct index_header), 0) != (ssize_t)sizeof(struct index_header))
+        return -1;
+    if (memcmp(hdr->magic, INDEX_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != INDEX_VERSION ||
+        0 == hdr->nslots || 0 != (hdr->nslots & (hdr->nslots - 1)))
+        return -1;
+
+    return 0;
+}
+
+static herr_t
+write_index(int fd, const struct index_header *hdr, const struct index_slot *slots, const char *heap)
+{
+    size_t slots_size = (size_t)hdr->nslots * sizeof(struct index_slot);
+
+    if (pwrite(fd, hdr, sizeof(struct index_header), 0) != (ssize_t)sizeof(struct index_header) ||
+        pwrite(fd, slots, slots_size, SLOTS_OFFSET) != (ssize_t)slots_size ||
+        (hdr->heap_size > 0 && pwrite(fd, heap, hdr->heap_size, HEAP_OFFSET(hdr)) != (ssize_t)hdr->heap_size))
+        return -1;
+
+    return 0;
+}
+
+/* Rewrites the index with nslots slots, dropping deleted members. It's
+ * rewritten in place (rather than replaced) so the mappings of open
+ * indexes stay valid, and never shrinks for the same reason.
+ */
+static herr_t
+rebuild_index(int fd, struct index_header *hdr, uint32_t nslots)
+{
+    struct index_slot * old_slots = NULL;
+    struct index_slot * new_slots = NULL;
+    char *              old_heap  = NULL;
+    char *              new_heap  = NULL;
+    struct index_header new_hdr   = *hdr;
+    size_t              old_size  = (size_t)hdr->nslots * sizeof(struct index_slot);
+    herr_t              ret       = -1;
+
+    old_slots = malloc(old_size);
+    old_heap  = malloc(hdr->heap_size + 1);
+    new_slots = calloc(nslots, sizeof(struct index_slot));
+    new_heap  = malloc(hdr->heap_size + 1);
+    if (!old_slots || !old_heap || !new_slots || !new_heap)
+        goto done;
+
+    if (pread(fd, old_slots, old_size, SLOTS_OFFSET) != (ssize_t)old_size ||
+        pread(fd, old_heap, hdr->heap_size, HEAP_OFFSET(hdr)) != (ssize_t)hdr->heap_size)
+        goto done;
+
+    new_hdr.nslots    = nslots;
+    new_hdr.nused     = 0;
+    new_hdr.ndeleted  = 0;
+    new_hdr.heap_size = 0;
+
+    for (uint32_t i = 0; i < hdr->nslots; i++) {
+        struct index_slot *slot = &old_slots[i];
+        uint32_t           j;
+
+        if (SLOT_EMPTY == slot->type || SLOT_DELETED == slot->type)
+            continue;
+
+        j = (uint32_t)slot->hash & (nslots - 1);
+        while (SLOT_EMPTY != new_slots[j].type)
+            j = (j + 1) & (nslots - 1);
+
+        memcpy(new_heap + new_hdr.heap_size, old_heap + slot->name_offset, slot->name_len);
+        new_slots[j]             = *slot;
+        new_slots[j].name_offset = new_hdr.heap_size;
+        new_hdr.heap_size += slot->name_len;
+        new_hdr.nused++;
+    }
+
+    if (write_index(fd, &new_hdr, new_slots, new_heap) < 0)
+        goto done;
+
+    *hdr = new_hdr;
+    ret  = 0;
+
+done:
+    free(old_slots);
+    free(old_heap);
+    free(new_slots);
+    free(new_heap);
+
+    return ret;
+}
+
+/* Finds name's slot, or (if it isn't there) the slot it would go in. Sets
+ * *found accordingly.
+ */
+static herr_t
+find_slot(int fd, const struct index_header *hdr, uint64_t hash, const char *name, size_t len, uint32_t *pos,
+          struct index_slot *slot, hbool_t *found)
+{
+    hbool_t  have_free = false;
+    uint32_t free_pos  = 0;
+    char     rest[NAME_MAX];
+
+    *found = false;
+
+    for (uint32_t i = (uint32_t)hash & (hdr->nslots - 1), n = 0; n < hdr->nslots;
+         i = (i + 1) & (hdr->nslots - 1), n++) {
+        struct index_slot s;
+
+        if (pread(fd, &s, sizeof(s), SLOT_OFFSET(i)) != (ssize_t)sizeof(s))
+            return -1;
+
+        if (SLOT_EMPTY == s.type) {
+            if (!have_free) {
+                free_pos = i;
+                *slot    = s;
+            }
+            *pos = free_pos;
+            return 0;
+        }
+        if (SLOT_DELETED == s.type) {
+            if (!have_free) {
+                have_free = true;
+                free_pos  = i;
+                *slot     = s;
+            }
+            continue;
+        }
+
+        if (s.hash == hash && s.name_len == len && len > SLOT_PREFIX_LEN &&
+            pread(fd, rest, len - SLOT_PREFIX_LEN, HEAP_OFFSET(hdr) + s.name_offset + SLOT_PREFIX_LEN) !=
+                (ssize_t)(len - SLOT_PREFIX_LEN))
+            return -1;
+        if (slot_matches(&s, hash, name, len, rest)) {
+            *pos   = i;
+            *slot  = s;
+            *found = true;
+            return 0;
+        }
+    }
+
+    /* The table is never full, but a deleted slot will do */
+    if (!have_free)
+        return -1;
+    *pos = free_pos;
+
+    return 0;
+}
+
+/* Creates an empty index in a new group's directory */
+herr_t
+create_index(int dir_fd)
+{
+    struct index_header hdr;
+    struct index_slot   slots[INDEX_INIT_NSLOTS];
+    herr_t              ret;
+    int                 fd;
+
+    if ((fd = openat(dir_fd, INDEX_FILE_NAME, O_RDWR | O_CREAT | O_TRUNC, 0666)) < 0)
+        return -1;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version = INDEX_VERSION;
+    hdr.nslots  = INDEX_INIT_NSLOTS;
+    memset(slots, 0, sizeof(slots));
+
+    ret = write_index(fd, &hdr, slots, NULL);
+    close(fd);
+
+    return ret;
+}
+
+/* Records that name (relative to dir_fd) is a new group or dataset, if the
+ * group holding it has an index
+ */
+herr_t
+index_insert(int dir_fd, const char *name, H5I_type_t type)
+{
+    struct index_header hdr;
+    struct index_slot   slot;
+    uint64_t            hash;
+    uint32_t            pos;
+    size_t              len;
+    hbool_t             found;
+    herr_t              ret = -1;
+    int                 fd;
+
+    if ((fd = lock_parent_index(dir_fd, &name)) < 0)
+        return ENOENT == errno ? 0 : -1;
+
+    len  = strlen(name);
+    hash = hash_string(name, len);
+
+    if (read_header(fd, &hdr) < 0 || find_slot(fd, &hdr, hash, name, len, &pos, &slot, &found) < 0)
+        goto done;
+
+    /* An object made again where one was before may have a new type */
+    if (found) {
+        slot.type = slot_type(type);
+        if (pwrite(fd, &slot, sizeof(slot), SLOT_OFFSET(pos)) == (ssize_t)sizeof(slot))
+            ret = 0;
+        goto done;
+    }
+
+    /* Keep the table at most half full, doubling it if dropping the deleted
+     * members isn't enough
+     */
+    if (2 * ((size_t)hdr.nused + hdr.ndeleted + 1) > hdr.nslots) {
+        uint32_t nslots = hdr.nslots;
+
+        if (2 * ((size_t)hdr.nused + 1) > nslots)
+            nslots *= 2;
+
+        if (rebuild_index(fd, &hdr, nslots) < 0 ||
+            find_slot(fd, &hdr, hash, name, len, &pos, &slot, &found) < 0)
+            goto done;
+    }
+
+    /* Append the name to the heap, then fill in the slot and the header */
+    if (pwrite(fd, name, len, HEAP_OFFSET(&hdr) + hdr.heap_size) != (ssize_t)len)
+        goto done;
+
+    if (SLOT_DELETED == slot.type)
+        hdr.ndeleted--;
+    fill_slot(&slot, hash, name, len, hdr.heap_size, slot_type(type));
+    hdr.heap_size += (uint32_t)len;
+    hdr.nused++;
+
+    if (pwrite(fd, &slot, sizeof(slot), SLOT_OFFSET(pos)) == (ssize_t)sizeof(slot) &&
+        pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr))
+        ret = 0;
+
+done:
+    close(fd);
+
+    return ret;
+}
+
+/* Records that name (relative to dir_fd) was deleted, if the group holding
+ * it has an index
+ */
+herr_t
+index_remove(int dir_fd, const char *name)
+{
+    struct index_header hdr;
+    struct index_slot   slot;
+    uint32_t            pos;
+    size_t              len;
+    hbool_t             found;
+    herr_t              ret = -1;
+    int                 fd;
+
+    if ((fd = lock_parent_index(dir_fd, &name)) < 0)
+        return ENOENT == errno ? 0 : -1;
+
+    len = strlen(name);
+
+    if (read_header(fd, &hdr) < 0 ||
+        find_slot(fd, &hdr, hash_string(name, len), name, len, &pos, &slot, &found) < 0)
+        goto done;
+
+    if (!found) {
+        ret = 0;
+        goto done;
+    }
+
+    slot.type = SLOT_DELETED;
+    hdr.nused--;
+    hdr.ndeleted++;
+
+    if (pwrite(fd, &slot, sizeof(slot), SLOT_OFFSET(pos)) == (ssize_t)sizeof(slot) &&
+        pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr))
+        ret = 0;
+
+done:
+    close(fd);
+
+    return ret;
+}
+
+/***********/
+/* LOOKUPS */
+/***********/
+
+/* Maps the whole index file, which may have grown since it was last mapped */
+static herr_t
+map_index(struct tutorial_index *index)
+{
+    struct stat st;
+
+    if (index->map)
+        munmap(index->map, index->map_size);
+    index->map      = NULL;
+    index->map_size = 0;
+
+    if (fstat(index->fd, &st) < 0 || (size_t)st.st_size < sizeof(struct index_header))
+        return -1;
+
+    if (MAP_FAILED == (index->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, index->fd, 0))) {
+        index->map = NULL;
+        return -1;
+    }
+    index->map_size = (size_t)st.st_size;
+
+    return 0;
+}
+
+/* Opens the index in a group's directory for lookups. Returns NULL if the
+ * group doesn't have one.
+ */
+struct tutorial_index *
+open_index(int dir_fd)
+{
+    struct tutorial_index *index = NULL;
+    int                    fd;
+
+    if ((fd = openat(dir_fd, INDEX_FILE_NAME, O_RDONLY)) < 0)
+        return NULL;
+
+    index     = calloc(1, sizeof(struct tutorial_index));
+    index->fd = fd;
+
+    if (map_index(index) < 0) {
+        close_index(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+void
+close_index(struct tutorial_index *index)
+{
+    if (NULL == index)
+        return;
+
+    if (index->map)
+        munmap(index->map, index->map_size);
+    close(index->fd);
+    free(index);
+}
+
+/* Looks up a member of the group, setting *type to H5I_GROUP, H5I_DATASET,
+ * or H5I_BADID if there's no such member. Fails if the index is damaged.
+ */
+herr_t
+index_lookup(struct tutorial_index *index, const char *name, H5I_type_t *type)
+{
+    const struct index_header *hdr   = index->map;
+    const struct index_slot *  slots = NULL;
+    const char *               heap  = NULL;
+    size_t                     len   = strlen(name);
+    uint64_t                   hash  = hash_string(name, len);
+
+    *type = H5I_BADID;
+
+    if (memcmp(hdr->magic, INDEX_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != INDEX_VERSION)
+        return -1;
+
+    /* Members added since the file was mapped may be past the end of the
+     * mapping
+     */
+    if (INDEX_SIZE(hdr) > index->map_size) {
+        if (map_index(index) < 0)
+            return -1;
+        hdr = index->map;
+        if (INDEX_SIZE(hdr) > index->map_size)
+            return -1;
+    }
+
+    slots = (const struct index_slot *)((const char *)index->map + SLOTS_OFFSET);
+    heap  = (const char *)index->map + HEAP_OFFSET(hdr);
+
+    for (uint32_t i = (uint32_t)hash & (hdr->nslots - 1), n = 0; n < hdr->nslots;
+         i = (i + 1) & (hdr->nslots - 1), n++) {
+        const struct index_slot *slot = &slots[i];
+
+        if (SLOT_EMPTY == slot->type)
+            break;
+        if (slot_matches(slot, hash, name, len, heap + slot->name_offset + SLOT_PREFIX_LEN)) {
+            *type = object_type(slot->type);
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Per-group name index for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_INDEX_H
+#define TUTORIAL_INDEX_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+herr_t create_index(int dir_fd);
+herr_t index_insert(int dir_fd, const char *name, H5I_type_t type);
+herr_t index_remove(int dir_fd, const char *name);
+
+struct tutorial_index *open_index(int dir_fd);
+void                   close_index(struct tutorial_index *index);
+herr_t                 index_lookup(struct tutorial_index *index, const char *name, H5I_type_t *type);
+
+#endif /* TUTORIAL_INDEX_H */
@@ -16,38 +16,103 @@
 
 #include <dirent.h>
 #include <hdf5.h>
+#include <stdint.h>
 #include <stdio.h>
 
+struct tutorial_arena;
+struct tutorial_attrs;
+struct tutorial_batch;
+struct tutorial_batch_entry;
+struct tutorial_wb_entry;
+struct tutorial_write_buffer;
+struct tutorial_cache;
 struct tutorial_dataset;
 struct tutorial_file;
 struct tutorial_group;
+struct tutorial_journal;
 struct tutorial_link;
+struct tutorial_listing;
 struct tutorial_object;
+struct tutorial_pool;
+struct tutorial_task_queue;
 
-enum tutorial_data_type {
-    TUTORIAL_DATA_TYPE_FLOAT,
-    TUTORIAL_DATA_TYPE_INT,
-};
-
+/* Legacy datatype file contents. Datasets created with these only ever
+ * stored native ints.
+ */
 #define TUTORIAL_DATA_TYPE_FLOAT_STRING "TUTORIAL_DATA_TYPE_FLOAT"
 #define TUTORIAL_DATA_TYPE_INT_STRING   "TUTORIAL_DATA_TYPE_INT"
 
+/* Largest element the connector stores (a 64-bit integer or a double) */
+#define TUTORIAL_MAX_TYPE_SIZE 8
+
+/* An integer or floating-point element type */
+struct tutorial_type {
+    H5T_class_t cls;   /* H5T_INTEGER or H5T_FLOAT */
+    size_t      size;  /* In bytes */
+    H5T_sign_t  sign;  /* H5T_SGN_NONE or H5T_SGN_2 (integers only) */
+    H5T_order_t order; /* H5T_ORDER_LE or H5T_ORDER_BE */
+};
+
+/* On-disk format of a dataset's data file */
+enum tutorial_data_format {
+    TUTORIAL_DATA_FORMAT_BINARY, /* Versioned header + raw elements */
+    TUTORIAL_DATA_FORMAT_TEXT,   /* One element per line (legacy) */
+};
+
+/* Storage layout of a dataset's elements */
+enum tutorial_layout {
+    TUTORIAL_LAYOUT_CONTIGUOUS, /* One data file */
+    TUTORIAL_LAYOUT_CHUNKED,    /* One binary file per chunk that has been written */
+};
+
+/* Filters applied to each chunk of a chunked dataset, in this order */
+#define TUTORIAL_FILTER_SHUFFLE 0x01 /* Byte shuffle */
+#define TUTORIAL_FILTER_DEFLATE 0x02 /* zlib */
+
 struct tutorial_dataset {
+    /* The dataset's directory, which its files are opened relative to */
+    int dir_fd;
+
     /* The dataset's data file */
     FILE *data_file;
 
-    /* The dataset's dataspace file */
+    /* The dataset's metadata record (or, with legacy_meta, its dataspace
+     * file), which holds the extent
+     */
     FILE *space_file;
 
-    /* Dataspace info */
-    hsize_t dims;
+    /* The metadata is in separate text files (datasets from older versions) */
+    hbool_t legacy_meta;
+
+    /* Dataspace info (row-major, like HDF5) */
+    int     rank;
+    hsize_t dims[H5S_MAX_RANK];
+    hsize_t maxdims[H5S_MAX_RANK];
+
+    /* The type of the stored elements */
+    struct tutorial_type type;
+
+    /* The fill value, as a stored element (in the stored byte order) */
+    unsigned char fillval[TUTORIAL_MAX_TYPE_SIZE];
 
-    /* Datatype info */
-    /* NOT USED AT THIS TIME */
-    enum tutorial_data_type type;
+    /* Fill values are never written (H5D_FILL_TIME_NEVER) */
+    hbool_t fill_never;
 
-    /* The fill value */
-    int fillval;
+    /* The format of the data file */
+    enum tutorial_data_format format;
+
+    /* Storage layout */
+    enum tutorial_layout layout;
+    hsize_t              chunk_dims[H5S_MAX_RANK];
+
+    /* The chunks' filters (TUTORIAL_FILTER_*), and the zlib level */
+    unsigned filters;
+    int      deflate_level;
+
+    /* Memory-mapped binary data file (when use_mmap is set) */
+    hbool_t use_mmap;
+    void *  map;
+    size_t  map_size;
 };
 
 struct tutorial_file {
@@ -56,30 +121,190 @@ struct tutorial_file {
 
     /* The file's name */
     char *filename;
+
+    /* Data file format used for new datasets unless the DCPL says otherwise */
+    enum tutorial_data_format data_format;
+
+    /* Memory-map dataset data files unless the DAPL says otherwise */
+    hbool_t use_mmap;
+
+    /* Give new groups a name index */
+    hbool_t use_index;
+
+    /* Hold back creating objects on disk until they're needed (batch is NULL
+     * while nothing is held back), and whether anything held back failed
+     * since that was last reported
+     */
+    hbool_t                batch_create;
+    struct tutorial_batch *batch;
+    hbool_t                batch_failed;
+
+    /* Buffer small writes until there are write_buffer_size bytes of them,
+     * or the oldest is write_buffer_ms old (write_buffer is NULL while
+     * nothing is buffered), and whether anything drained failed since that
+     * was last reported
+     */
+    size_t                        write_buffer_size;
+    int                           write_buffer_ms;
+    struct tutorial_write_buffer *write_buffer;
+    hbool_t                       write_buffer_failed;
+
+    /* Log writes to binary data files before making them, and replace
+     * other files rather than rewriting them (journal is NULL unless the
+     * file was opened for writing with TUTORIAL_VOL_DURABLE_PROP)
+     */
+    struct tutorial_journal *journal;
+
+    /* Background thread for asynchronous operations (NULL until needed) */
+    struct tutorial_task_queue *tasks;
+
+    /* Threads that share the work of large reads and writes (the pool is
+     * NULL until needed)
+     */
+    size_t                nthreads;
+    struct tutorial_pool *pool;
+
+    /* Metadata and idle handles of the objects opened so far */
+    struct tutorial_cache *cache;
+
+    /* Memory for the file's objects and their names and paths */
+    struct tutorial_arena *arena;
+
+    /* The file's handle and each of its objects hold a reference, so
+     * objects left open when the file is closed can still be used (and
+     * closed), and the file is freed along with the last of them
+     */
+    size_t nrefs;
 };
 
 struct tutorial_group {
     /* The directory representing a group */
     DIR *dir;
+
+    /* The group's name index, opened on the first lookup (index_checked is
+     * set then, so a group without one isn't checked again)
+     */
+    struct tutorial_index *index;
+    hbool_t                index_checked;
+};
+
+/* A group's members, sorted by name. Listings are shared through the file's
+ * cache, and the reference count is guarded by the cache's lock.
+ */
+struct tutorial_listing {
+    size_t refcount;
+
+    size_t nnames;
+    char **names;
+
+    /* The names themselves, one after another */
+    char *buf;
+};
+
+/* An attribute, as described by its object's attribute record */
+struct tutorial_attr_info {
+    /* The attribute's name, and the order it was created in */
+    const char *name;
+    uint32_t    corder;
+
+    /* The extent */
+    H5S_class_t space_class;
+    int         rank;
+    hsize_t     dims[H5S_MAX_RANK];
+
+    /* The stored type, as encoded by H5Tencode() */
+    const void *type_buf;
+    size_t      type_size;
+
+    /* The value, which is held in the record itself (value), in the blob
+     * file (at blob_offset) or, until it's first written, nowhere
+     */
+    hsize_t     data_size;
+    const void *value;
+    uint64_t    blob_offset;
+    hbool_t     in_blob;
+};
+
+/* An object's attributes, read from its attribute record in one go. Tables
+ * are shared through the file's cache and replaced, rather than changed,
+ * when an attribute is. The reference count is guarded by the cache's lock.
+ */
+struct tutorial_attrs {
+    size_t refcount;
+
+    /* In creation order, and sorted by name */
+    size_t                      nattrs;
+    struct tutorial_attr_info * attrs;
+    struct tutorial_attr_info **by_name;
+
+    /* The creation order of the next attribute */
+    uint32_t next_corder;
+
+    /* The record the attributes' names, types and values point into */
+    char *buf;
+};
+
+/* An open attribute. Its object may be closed first, so it has its own
+ * handle on the object's directory.
+ */
+struct tutorial_attribute {
+    /* The directory of the attribute's object, and the object's path */
+    int         dir_fd;
+    const char *owner_path;
+
+    /* The stored type and the extent */
+    hid_t type_id;
+    hid_t space_id;
 };
 
 struct tutorial_object {
     /* Dataset or group (and eventually datatype) */
     H5I_type_t type;
 
-    /* The name of this object */
-    char *name;
+    /* The name of this object (owned by the file's arena) */
+    const char *name;
+
+    /* The full path to the object, including the name, as opened by the user
+     * (owned by the file's arena)
+     */
+    const char *path;
 
-    /* The full path to the object, including the name, as opened by the user */
-    char *path;
+    /* The file this object belongs to */
+    struct tutorial_file *file;
+
+    /* Where the object waits in its file's batch, while its creation is held
+     * back
+     */
+    struct tutorial_batch_entry *batched;
+
+    /* The object's bytes in its file's write buffer (shared with its other
+     * handles), if it has any
+     */
+    struct tutorial_wb_entry *buffered;
 
     /* The object's data */
     union {
-        struct tutorial_dataset dataset;
-        struct tutorial_group   group;
+        struct tutorial_dataset   dataset;
+        struct tutorial_group     group;
+        struct tutorial_attribute attr;
     } data;
 };
 
+/* Attribute callbacks */
+void * tutorial_attr_create(void *obj, const H5VL_loc_params_t *loc_params, const char *attr_name,
+                            hid_t type_id, hid_t space_id, hid_t acpl_id, hid_t aapl_id, hid_t dxpl_id,
+                            void **req);
+void * tutorial_attr_open(void *obj, const H5VL_loc_params_t *loc_params, const char *attr_name,
+                          hid_t aapl_id, hid_t dxpl_id, void **req);
+herr_t tutorial_attr_read(void *attr, hid_t mem_type_id, void *buf, hid_t dxpl_id, void **req);
+herr_t tutorial_attr_write(void *attr, hid_t mem_type_id, const void *buf, hid_t dxpl_id, void **req);
+herr_t tutorial_attr_get(void *obj, H5VL_attr_get_args_t *args, hid_t dxpl_id, void **req);
+herr_t tutorial_attr_specific(void *obj, const H5VL_loc_params_t *loc_params, H5VL_attr_specific_args_t *args,
+                              hid_t dxpl_id, void **req);
+herr_t tutorial_attr_close(void *attr, hid_t dxpl_id, void **req);
+/* Attribute utility function (needed by the cache) */
+void free_attrs(struct tutorial_attrs *attrs);
+
 /* Dataset callbacks */
 void *tutorial_dataset_create(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t lcpl_id,
                               hid_t type_id, hid_t space_id, hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id,
@@ -90,7 +315,11 @@ herr_t tutorial_dataset_read(void *obj, hid_t mem_type_id, hid_t mem_space_id, h
                              hid_t dxpl_id, void *buf, void **req);
 herr_t tutorial_dataset_write(void *obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id,
                               hid_t dxpl_id, const void *buf, void **req);
+herr_t tutorial_dataset_get(void *obj, H5VL_dataset_get_args_t *args, hid_t dxpl_id, void **req);
+herr_t tutorial_dataset_specific(void *obj, H5VL_dataset_specific_args_t *args, hid_t dxpl_id, void **req);
 herr_t tutorial_dataset_close(void *dset, hid_t dxpl_id, void **req);
+/* Dataset utility function (needed to tell datasets from groups) */
+hbool_t is_dataset_dir(int dir_fd, const char *name);
 
 /* File callbacks */
 void * tutorial_file_create(const char *name, unsigned flags, hid_t fcpl_id, hid_t fapl_id, hid_t dxpl_id,
@@ -98,15 +327,47 @@ void * tutorial_file_create(const char *name, unsigned flags, hid_t fcpl_id, hid
 void * tutorial_file_open(const char *name, unsigned flags, hid_t fapl_id, hid_t dxpl_id, void **req);
 herr_t tutorial_file_specific(void *obj, H5VL_file_specific_args_t *args, hid_t dxpl_id, void **req);
 herr_t tutorial_file_close(void *file, hid_t dxpl_id, void **req);
+/* File utility functions */
+void release_file(struct tutorial_file *f);
+void wait_for_deletes(void);
 
 /* Group callbacks */
 void * tutorial_group_create(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t lcpl_id,
                              hid_t gcpl_id, hid_t gapl_id, hid_t dxpl_id, void **req);
 void * tutorial_group_open(void *obj, const H5VL_loc_params_t *loc_params, const char *name, hid_t gapl_id,
                            hid_t dxpl_id, void **req);
+herr_t tutorial_group_get(void *obj, H5VL_group_get_args_t *args, hid_t dxpl_id, void **req);
 herr_t tutorial_group_close(void *grp, hid_t dxpl_id, void **req);
-/* Group utility function (needed to create root group in file code) */
-struct tutorial_object *init_group(struct tutorial_object *parent, const char *name, hbool_t create_on_disk);
+/* Group utility functions (needed to create root group in file code, and to
+ * open a group's members)
+ */
+struct tutorial_object * init_group(struct tutorial_file *file, struct tutorial_object *parent,
+                                    const char *name, hbool_t create_on_disk);
+int                      group_fd(const struct tutorial_object *obj);
+struct tutorial_object * open_group(struct tutorial_object *parent, const char *name);
+struct tutorial_object * lookup_group(struct tutorial_object *parent, const char *name);
+void                     release_group(struct tutorial_object *parent, struct tutorial_object *group);
+struct tutorial_object * loc_group(void *obj, const H5VL_loc_params_t *loc_params);
+struct tutorial_object * lookup_group_by_loc(struct tutorial_object *parent, const H5VL_loc_params_t *loc_params);
+struct tutorial_listing *get_listing(struct tutorial_object *group);
+void                     release_listing(struct tutorial_object *group, struct tutorial_listing *listing);
+const char *             listing_name(const struct tutorial_listing *listing, H5_iter_order_t order, hsize_t n);
+hbool_t                  listing_contains(const struct tutorial_listing *listing, const char *name);
+herr_t                   group_index_lookup(struct tutorial_object *group, const char *name, H5I_type_t *type);
+hbool_t                  is_subgroup(struct tutorial_object *group, const char *name);
+void                     free_listing(struct tutorial_listing *listing);
+
+/* Link callbacks */
+herr_t tutorial_link_get(void *obj, const H5VL_loc_params_t *loc_params, H5VL_link_get_args_t *args,
+                         hid_t dxpl_id, void **req);
+herr_t tutorial_link_specific(void *obj, const H5VL_loc_params_t *loc_params, H5VL_link_specific_args_t *args,
+                              hid_t dxpl_id, void **req);
+
+/* Request callbacks */
+herr_t tutorial_request_wait(void *req, uint64_t timeout, H5VL_request_status_t *status);
+herr_t tutorial_request_notify(void *req, H5VL_request_notify_t cb, void *ctx);
+herr_t tutorial_request_cancel(void *req, H5VL_request_status_t *status);
+herr_t tutorial_request_free(void *req);
 
 /* Introspect callbacks */
 herr_t tutorial_introspect_opt_query(void *obj, H5VL_subclass_t subcls, int opt_type, uint64_t *flags);
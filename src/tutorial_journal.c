@@ -0,0 +1,474 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Write-ahead journal for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              In a file opened with TUTORIAL_VOL_DURABLE_PROP, writes to
+ *              binary data files are logged before they're made. Everything
+ *              drained from the write buffer at once is appended to the
+ *              file's journal as one transaction (each write as a record
+ *              with the data file's path, the offset and the bytes, each
+ *              fill of the gap a write leaves past the end of a data file
+ *              as a record with the fill value, then a commit record with a
+ *              checksum of the lot) and synced with a single fdatasync().
+ *              Only then are the bytes written to the data files, so a
+ *              crash partway through leaves a transaction that can be
+ *              written again in full. The data files are synced
+ *              and the journal emptied at a checkpoint: on H5Fflush() and
+ *              H5Fclose(), or once the journal grows too big.
+ *
+ *              Opening a file for writing replays every complete
+ *              transaction left in its journal. A transaction without a
+ *              commit record, or whose checksum doesn't match, was cut
+ *              short before anything in it was written to the data files,
+ *              so it is dropped. Opening a file read-only fails while its
+ *              journal holds a complete transaction, as the data files
+ *              can't be brought up to date.
+ */
+
+#include <fcntl.h>
+#include <hdf5.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+#include "tutorial_internal.h"
+#include "tutorial_journal.h"
+#include "tutorial_util.h"
+
+#define JOURNAL_FILE_NAME "TUTORIAL_VOL_JOURNAL"
+
+/* Record magics */
+#define JOURNAL_WRITE_MAGIC  "TVJW"
+#define JOURNAL_FILL_MAGIC   "TVJF"
+#define JOURNAL_COMMIT_MAGIC "TVJC"
+
+/* Fill records are replayed this many bytes at a time (and their fill
+ * values can't be bigger)
+ */
+#define JOURNAL_FILL_BUF_SIZE 4096
+
+/* Checkpoint once the journal holds this many bytes */
+#define JOURNAL_CHECKPOINT_SIZE ((off_t)64 * 1024 * 1024)
+
+/* On-disk journal record (native byte order). A write record is followed by
+ * its path (path_len bytes, with the terminating NUL) and then its len
+ * bytes. A fill record is followed by its path and then a fill value of
+ * fill_size bytes, repeated over its len bytes. A commit record ends the
+ * transaction whose write and fill records take up the len bytes before it.
+ */
+struct journal_record {
+    char     magic[4];
+    uint32_t path_len; /* Write and fill records only */
+    uint64_t offset;   /* Write and fill records only: into the data file */
+    uint64_t len;
+    uint32_t crc;       /* Commit records only: crc32 of the transaction's other records */
+    uint32_t fill_size; /* Fill records only */
+};
+
+struct tutorial_journal {
+    int fd;
+
+    /* Where the next transaction goes */
+    off_t end;
+
+    /* The transaction being put together */
+    char * buf;
+    size_t size;
+    size_t cap;
+
+    /* The data files written since the last checkpoint, relative to the
+     * file
+     */
+    char **paths;
+    size_t npaths;
+    size_t paths_cap;
+};
+
+/* A data file written to while replaying a journal */
+struct replay_file {
+    const char *path;
+    int         fd;
+};
+
+/* Returns the end of the complete transaction starting at start, or 0 if
+ * there isn't one
+ */
+static size_t
+find_transaction(const char *buf, size_t size, size_t start)
+{
+    struct journal_record rec;
+    size_t                pos = start;
+    hbool_t               is_fill;
+    uint64_t              payload;
+
+    while (size - pos >= sizeof(rec)) {
+        memcpy(&rec, buf + pos, sizeof(rec));
+        pos += sizeof(rec);
+
+        if (memcmp(rec.magic, JOURNAL_COMMIT_MAGIC, sizeof(rec.magic)) == 0) {
+            if (rec.len != pos - sizeof(rec) - start ||
+                rec.crc != (uint32_t)crc32_z(0, (const Bytef *)buf + start, (z_size_t)rec.len))
+                return 0;
+            return pos;
+        }
+
+        is_fill = memcmp(rec.magic, JOURNAL_FILL_MAGIC, sizeof(rec.magic)) == 0;
+        payload = is_fill ? rec.fill_size : rec.len;
+        if ((!is_fill && memcmp(rec.magic, JOURNAL_WRITE_MAGIC, sizeof(rec.magic)) != 0) ||
+            0 == rec.path_len || rec.path_len > size - pos || payload > size - pos - rec.path_len ||
+            buf[pos + rec.path_len - 1] != '\0' ||
+            (is_fill &&
+             (0 == rec.fill_size || rec.fill_size > JOURNAL_FILL_BUF_SIZE || rec.len % rec.fill_size != 0)))
+            return 0;
+        pos += rec.path_len + (size_t)payload;
+    }
+
+    return 0;
+}
+
+/* Writes len bytes of a fill value of fill_size bytes, repeated, at offset
+ * in fd
+ */
+static herr_t
+replay_fill(int fd, uint64_t offset, uint64_t len, const char *fill, size_t fill_size)
+{
+    char   buf[JOURNAL_FILL_BUF_SIZE];
+    size_t buf_len = JOURNAL_FILL_BUF_SIZE / fill_size * fill_size;
+
+    for (size_t i = 0; i < buf_len; i += fill_size)
+        memcpy(buf + i, fill, fill_size);
+
+    while (len > 0) {
+        size_t count = len < buf_len ? (size_t)len : buf_len;
+
+        if (pwrite(fd, buf, count, (off_t)offset) != (ssize_t)count)
+            return -1;
+        offset += count;
+        len -= count;
+    }
+
+    return 0;
+}
+
+/* Writes the records of a complete transaction to their data files. Files
+ * that no longer exist belonged to objects that have since been deleted.
+ */
+static herr_t
+replay_transaction(const char *filename, const char *buf, size_t start, size_t end,
+                   struct replay_file **files, size_t *nfiles)
+{
+    struct journal_record rec;
+    size_t                pos = start;
+    herr_t                ret = 0;
+
+    while (pos < end) {
+        const char *path = NULL;
+        const char *data = NULL;
+        hbool_t     is_fill;
+        size_t      i;
+
+        memcpy(&rec, buf + pos, sizeof(rec));
+        if (memcmp(rec.magic, JOURNAL_COMMIT_MAGIC, sizeof(rec.magic)) == 0)
+            break;
+        is_fill = memcmp(rec.magic, JOURNAL_FILL_MAGIC, sizeof(rec.magic)) == 0;
+        path    = buf + pos + sizeof(rec);
+        data    = path + rec.path_len;
+        pos += sizeof(rec) + rec.path_len + (size_t)(is_fill ? rec.fill_size : rec.len);
+
+        for (i = 0; i < *nfiles; i++)
+            if (strcmp((*files)[i].path, path) == 0)
+                break;
+        if (i == *nfiles) {
+            char *full_path = make_path(filename, path, NULL);
+
+            *files             = realloc(*files, (*nfiles + 1) * sizeof(struct replay_file));
+            (*files)[i].path   = path;
+            (*files)[i].fd     = open(full_path, O_WRONLY);
+            (*nfiles)++;
+            free(full_path);
+        }
+
+        if ((*files)[i].fd < 0)
+            continue;
+        if (is_fill) {
+            if (replay_fill((*files)[i].fd, rec.offset, rec.len, data, rec.fill_size) < 0)
+                ret = -1;
+        }
+        else if (pwrite((*files)[i].fd, data, (size_t)rec.len, (off_t)rec.offset) != (ssize_t)rec.len)
+            ret = -1;
+    }
+
+    return ret;
+}
+
+/* Replays what's left in a file's journal, if it has one, then empties it.
+ * Without replay (for files opened read-only), this only checks that there
+ * is nothing to replay.
+ */
+herr_t
+recover_journal(const char *filename, hbool_t replay)
+{
+    struct replay_file *files  = NULL;
+    size_t              nfiles = 0;
+    struct stat         st;
+    char *              path   = NULL;
+    char *              buf    = NULL;
+    size_t              size   = 0;
+    size_t              pos    = 0;
+    size_t              end    = 0;
+    herr_t              ret    = 0;
+    int                 fd;
+
+    path = make_path(filename, JOURNAL_FILE_NAME, NULL);
+    fd   = open(path, replay ? O_RDWR : O_RDONLY);
+    free(path);
+
+    /* Files that never had a journal, or were checkpointed, are done */
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (0 == st.st_size) {
+        close(fd);
+        return 0;
+    }
+
+    size = (size_t)st.st_size;
+    if (NULL == (buf = malloc(size)) || pread(fd, buf, size, 0) != (ssize_t)size) {
+        free(buf);
+        close(fd);
+        return -1;
+    }
+
+    if (!replay) {
+        ret = find_transaction(buf, size, 0) ? -1 : 0;
+        free(buf);
+        close(fd);
+        return ret;
+    }
+
+    /* Transactions are replayed in order, up to the first incomplete one */
+    while (ret >= 0 && 0 != (end = find_transaction(buf, size, pos))) {
+        ret = replay_transaction(filename, buf, pos, end, &files, &nfiles);
+        pos = end;
+    }
+
+    for (size_t i = 0; i < nfiles; i++)
+        if (files[i].fd >= 0) {
+            if (fdatasync(files[i].fd) < 0)
+                ret = -1;
+            close(files[i].fd);
+        }
+
+    /* The journal is only emptied once everything in it is safely written */
+    if (ret >= 0 && (ftruncate(fd, 0) < 0 || fdatasync(fd) < 0))
+        ret = -1;
+
+    free(files);
+    free(buf);
+    close(fd);
+
+    return ret;
+}
+
+/* Opens a file's (empty) journal, creating it if needed */
+struct tutorial_journal *
+open_journal(const char *filename)
+{
+    struct tutorial_journal *j    = NULL;
+    char *                   path = NULL;
+    int                      fd;
+
+    path = make_path(filename, JOURNAL_FILE_NAME, NULL);
+    fd   = open(path, O_RDWR | O_CREAT, 0666);
+    free(path);
+
+    if (fd < 0)
+        return NULL;
+
+    j     = calloc(1, sizeof(struct tutorial_journal));
+    j->fd = fd;
+
+    return j;
+}
+
+/* Adds a record for the file at path (relative to the file) to f's next
+ * transaction, followed by data_len bytes of data
+ */
+static void
+add_record(struct tutorial_file *f, struct journal_record *rec, const char *path, const void *data,
+           size_t data_len)
+{
+    struct tutorial_journal *j        = f->journal;
+    size_t                   path_len = strlen(path) + 1;
+    size_t                   i;
+
+    if (j->size + sizeof(*rec) + path_len + data_len > j->cap) {
+        j->cap = 2 * j->cap;
+        if (j->cap < j->size + sizeof(*rec) + path_len + data_len)
+            j->cap = j->size + sizeof(*rec) + path_len + data_len;
+        j->buf = realloc(j->buf, j->cap);
+    }
+
+    rec->path_len = (uint32_t)path_len;
+
+    memcpy(j->buf + j->size, rec, sizeof(*rec));
+    memcpy(j->buf + j->size + sizeof(*rec), path, path_len);
+    memcpy(j->buf + j->size + sizeof(*rec) + path_len, data, data_len);
+    j->size += sizeof(*rec) + path_len + data_len;
+
+    /* Remember the data file, to sync it at the next checkpoint */
+    for (i = 0; i < j->npaths; i++)
+        if (strcmp(j->paths[i], path) == 0)
+            break;
+    if (i == j->npaths) {
+        if (j->npaths == j->paths_cap) {
+            j->paths_cap = j->paths_cap ? 2 * j->paths_cap : 16;
+            j->paths     = realloc(j->paths, j->paths_cap * sizeof(char *));
+        }
+        j->paths[j->npaths++] = strdup(path);
+    }
+}
+
+/* Adds a write of len bytes at offset in the file at path (relative to
+ * the file) to f's next transaction
+ */
+void
+journal_add(struct tutorial_file *f, const char *path, hsize_t offset, const void *data, size_t len)
+{
+    struct journal_record rec;
+
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.magic, JOURNAL_WRITE_MAGIC, sizeof(rec.magic));
+    rec.offset = offset;
+    rec.len    = len;
+
+    add_record(f, &rec, path, data, len);
+}
+
+/* Adds a fill of len bytes at offset in the file at path (relative to the
+ * file) with a fill value of fill_size bytes to f's next transaction
+ */
+void
+journal_add_fill(struct tutorial_file *f, const char *path, hsize_t offset, hsize_t len, const void *fill,
+                 size_t fill_size)
+{
+    struct journal_record rec;
+
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.magic, JOURNAL_FILL_MAGIC, sizeof(rec.magic));
+    rec.offset    = offset;
+    rec.len       = len;
+    rec.fill_size = (uint32_t)fill_size;
+
+    add_record(f, &rec, path, fill, fill_size);
+}
+
+/* Appends f's next transaction to its journal, with its commit record, and
+ * syncs it. Once this returns, the transaction's writes survive a crash.
+ */
+herr_t
+commit_journal(struct tutorial_file *f)
+{
+    struct tutorial_journal *j = f->journal;
+    struct journal_record    rec;
+    herr_t                   ret = 0;
+
+    if (0 == j->size)
+        return 0;
+
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.magic, JOURNAL_COMMIT_MAGIC, sizeof(rec.magic));
+    rec.len = j->size;
+    rec.crc = (uint32_t)crc32_z(0, (const Bytef *)j->buf, j->size);
+
+    if (j->size + sizeof(rec) > j->cap) {
+        j->cap = j->size + sizeof(rec);
+        j->buf = realloc(j->buf, j->cap);
+    }
+    memcpy(j->buf + j->size, &rec, sizeof(rec));
+    j->size += sizeof(rec);
+
+    /* A transaction that doesn't make it is overwritten by the next one */
+    if (pwrite(j->fd, j->buf, j->size, j->end) != (ssize_t)j->size || fdatasync(j->fd) < 0)
+        ret = -1;
+    else
+        j->end += (off_t)j->size;
+
+    j->size = 0;
+
+    return ret;
+}
+
+/* Drops f's next transaction without committing it */
+void
+abort_journal(struct tutorial_file *f)
+{
+    f->journal->size = 0;
+}
+
+/* Syncs the data files written since the last checkpoint, then empties f's
+ * journal. Unless always is set, this waits until the journal has grown
+ * big enough to be worth it.
+ */
+herr_t
+checkpoint_journal(struct tutorial_file *f, hbool_t always)
+{
+    struct tutorial_journal *j   = f->journal;
+    herr_t                   ret = 0;
+
+    if (NULL == j || 0 == j->end || (!always && j->end < JOURNAL_CHECKPOINT_SIZE))
+        return 0;
+
+    for (size_t i = 0; i < j->npaths; i++) {
+        char *path = make_path(f->filename, j->paths[i], NULL);
+        int   fd   = open(path, O_WRONLY);
+
+        /* Data files of deleted objects are gone, along with their data */
+        if (fd >= 0) {
+            if (fdatasync(fd) < 0)
+                ret = -1;
+            close(fd);
+        }
+
+        free(path);
+    }
+
+    if (ret < 0 || ftruncate(j->fd, 0) < 0 || fdatasync(j->fd) < 0)
+        return -1;
+
+    for (size_t i = 0; i < j->npaths; i++)
+        free(j->paths[i]);
+    j->npaths = 0;
+    j->end    = 0;
+
+    return 0;
+}
+
+void
+close_journal(struct tutorial_file *f)
+{
+    struct tutorial_journal *j = f->journal;
+
+    if (NULL == j)
+        return;
+
+    for (size_t i = 0; i < j->npaths; i++)
+        free(j->paths[i]);
+    free(j->paths);
+    free(j->buf);
+    close(j->fd);
+    free(j);
+
+    f->journal = NULL;
+}
@@ -0,0 +1,27 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Write-ahead journal for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_JOURNAL_H
+#define TUTORIAL_JOURNAL_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+herr_t                   recover_journal(const char *filename, hbool_t replay);
+struct tutorial_journal *open_journal(const char *filename);
+void   journal_add(struct tutorial_file *f, const char *path, hsize_t offset, const void *data, size_t len);
+void   journal_add_fill(struct tutorial_file *f, const char *path, hsize_t offset, hsize_t len,
+                        const void *fill, size_t fill_size);
+herr_t commit_journal(struct tutorial_file *f);
+void   abort_journal(struct tutorial_file *f);
+herr_t checkpoint_journal(struct tutorial_file *f, hbool_t always);
+void   close_journal(struct tutorial_file *f);
+
+#endif /* TUTORIAL_JOURNAL_H */
@@ -0,0 +1,329 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Link functionality for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              Every object is a hard link from its group, named after its
+ *              directory. Queries go through the group's name index if it
+ *              has one, and otherwise its cached member listing, so checking
+ *              that a link exists is a hash probe or a binary search rather
+ *              than a directory scan, and iteration by index doesn't read the
+ *              directory again.
+ */
+
+#include <hdf5.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tutorial_cache.h"
+#include "tutorial_index.h"
+#include "tutorial_internal.h"
+#include "tutorial_journal.h"
+#include "tutorial_request.h"
+#include "tutorial_util.h"
+#include "tutorial_writeback.h"
+
+/* A link looked up from an operation's location */
+struct link_loc {
+    /* The group holding the link, and its members */
+    struct tutorial_object * group;
+    struct tutorial_listing *listing;
+
+    /* The link's name (in its group), and whether it's there */
+    const char *name;
+    hbool_t     exists;
+};
+
+/* Looks up the group holding the link name (relative to parent), and points
+ * link_name at the last component of the name. Returns NULL if the group
+ * doesn't exist.
+ */
+static struct tutorial_object *
+lookup_link_group(struct tutorial_object *parent, const char *name, const char **link_name)
+{
+    struct tutorial_object *group      = NULL;
+    const char *            slash      = NULL;
+    char *                  group_name = NULL;
+
+    parent = resolve_name(parent, &name);
+
+    if (NULL == (slash = strrchr(name, '/'))) {
+        *link_name = name;
+        return parent;
+    }
+
+    group_name = strndup(name, (size_t)(slash - name));
+    group      = lookup_group(parent, group_name);
+    free(group_name);
+
+    *link_name = slash + 1;
+
+    return group;
+}
+
+/* Looks up the link that an operation's location names (by name or by index
+ * in its group), relative to parent. Fails if the group holding it doesn't
+ * exist. Pass the link to release_link() afterwards either way.
+ */
+static herr_t
+find_link(struct tutorial_object *parent, const H5VL_loc_params_t *loc_params, struct link_loc *link)
+{
+    memset(link, 0, sizeof(struct link_loc));
+
+    switch (loc_params->type) {
+        case H5VL_OBJECT_BY_NAME: {
+            H5I_type_t type;
+
+            link->group = lookup_link_group(parent, loc_params->loc_data.loc_by_name.name, &(link->name));
+            if (NULL == link->group)
+                return -1;
+
+            if (group_index_lookup(link->group, link->name, &type) >= 0) {
+                link->exists = (H5I_BADID != type);
+                break;
+            }
+
+            if (NULL == (link->listing = get_listing(link->group)))
+                return -1;
+
+            link->exists = listing_contains(link->listing, link->name);
+            break;
+        }
+
+        case H5VL_OBJECT_BY_IDX:
+            /* Only the name index exists */
+            if (H5_INDEX_NAME != loc_params->loc_data.loc_by_idx.idx_type)
+                return -1;
+
+            link->group = lookup_group(parent, loc_params->loc_data.loc_by_idx.name);
+            if (NULL == link->group || NULL == (link->listing = get_listing(link->group)))
+                return -1;
+
+            link->name   = listing_name(link->listing, loc_params->loc_data.loc_by_idx.order,
+                                      loc_params->loc_data.loc_by_idx.n);
+            link->exists = (NULL != link->name);
+            break;
+
+        case H5VL_OBJECT_BY_SELF:
+        case H5VL_OBJECT_BY_TOKEN:
+        default:
+            return -1;
+    }
+
+    return 0;
+}
+
+static void
+release_link(struct tutorial_object *parent, struct link_loc *link)
+{
+    if (link->listing)
+        release_listing(link->group, link->listing);
+    release_group(parent, link->group);
+}
+
+/* Every link is a hard link, and the creation order isn't recorded */
+static void
+get_link_info(H5L_info2_t *info)
+{
+    memset(info, 0, sizeof(H5L_info2_t));
+
+    info->type         = H5L_TYPE_HARD;
+    info->corder_valid = false;
+    info->cset         = H5T_CSET_ASCII;
+}
+
+/* Calls the iteration callback for the group's members from *idx on, and
+ * (when visiting) for everything in its subgroups after each one. Names are
+ * relative to the group the iteration started from, which prefix leads to
+ * this one from. Stops at the first nonzero callback return, which is
+ * returned, leaving *idx just past the member it was called for.
+ */
+static herr_t
+iterate_links(struct tutorial_object *group, const char *prefix, const H5VL_link_iterate_args_t *args,
+              hid_t group_id, hsize_t *idx)
+{
+    struct tutorial_listing *listing = NULL;
+    H5L_info2_t              info;
+    herr_t                   ret = 0;
+
+    if (NULL == (listing = get_listing(group)))
+        return -1;
+
+    /* Starting past the end is an error, unless there's nothing to skip */
+    if (*idx > 0 && *idx >= listing->nnames) {
+        release_listing(group, listing);
+        return -1;
+    }
+
+    get_link_info(&info);
+
+    for (; 0 == ret && *idx < listing->nnames; (*idx)++) {
+        const char *name      = listing_name(listing, args->order, *idx);
+        char *      full_name = prefix ? make_path(prefix, name, NULL) : NULL;
+
+        ret = args->op(group_id, full_name ? full_name : name, &info, args->op_data);
+
+        if (0 == ret && args->recursive && is_subgroup(group, name)) {
+            struct tutorial_object *subgroup = NULL;
+            hsize_t                 sub_idx  = 0;
+
+            if (NULL == (subgroup = lookup_group(group, name)))
+                ret = -1;
+            else {
+                ret = iterate_links(subgroup, full_name ? full_name : name, args, group_id, &sub_idx);
+                release_group(group, subgroup);
+            }
+        }
+
+        free(full_name);
+    }
+
+    release_listing(group, listing);
+
+    return ret;
+}
+
+herr_t
+tutorial_link_get(void *obj, const H5VL_loc_params_t *loc_params, H5VL_link_get_args_t *args, hid_t dxpl_id,
+                  void **req)
+{
+    struct tutorial_object *parent = loc_group(obj, loc_params);
+    struct link_loc         link;
+    herr_t                  ret = 0;
+
+    /* Links may still be being created */
+    wait_for_tasks(parent->file);
+
+    if (find_link(parent, loc_params, &link) < 0 || !link.exists) {
+        release_link(parent, &link);
+        return -1;
+    }
+
+    switch (args->op_type) {
+        case H5VL_LINK_GET_INFO: {
+            get_link_info(args->args.get_info.linfo);
+            break;
+        }
+        case H5VL_LINK_GET_NAME: {
+            size_t len = strlen(link.name);
+
+            *args->args.get_name.name_len = len;
+
+            /* The name may be truncated to fit */
+            if (args->args.get_name.name && args->args.get_name.name_size > 0) {
+                if (len >= args->args.get_name.name_size)
+                    len = args->args.get_name.name_size - 1;
+                memcpy(args->args.get_name.name, link.name, len);
+                args->args.get_name.name[len] = '\0';
+            }
+            break;
+        }
+        case H5VL_LINK_GET_VAL:
+        default:
+            /* There are no soft or external links to have values */
+            ret = -1;
+            break;
+    }
+
+    release_link(parent, &link);
+
+    return ret;
+}
+
+herr_t
+tutorial_link_specific(void *obj, const H5VL_loc_params_t *loc_params, H5VL_link_specific_args_t *args,
+                       hid_t dxpl_id, void **req)
+{
+    struct tutorial_object *parent = loc_group(obj, loc_params);
+    struct link_loc         link;
+    herr_t                  ret = 0;
+
+    /* Links may still be being created */
+    wait_for_tasks(parent->file);
+
+    switch (args->op_type) {
+        case H5VL_LINK_EXISTS: {
+            /* A missing group along the way just means the link isn't there */
+            if (find_link(parent, loc_params, &link) < 0)
+                *args->args.exists.exists = false;
+            else
+                *args->args.exists.exists = link.exists || 0 == strcmp(link.name, ".");
+
+            release_link(parent, &link);
+            break;
+        }
+        case H5VL_LINK_ITER: {
+            H5VL_link_iterate_args_t *iterate = &(args->args.iterate);
+            struct tutorial_object *  group   = NULL;
+            struct tutorial_object *  copy    = NULL;
+            hid_t                     group_id;
+            hsize_t                   idx = iterate->idx_p ? *iterate->idx_p : 0;
+
+            /* Only the name index exists */
+            if (H5_INDEX_NAME != iterate->idx_type)
+                return -1;
+
+            if (NULL == (group = lookup_group_by_loc(parent, loc_params)))
+                return -1;
+
+            /* The callback gets an ID for the group, which it can use like
+             * any other. It's for a new handle, so closing the ID doesn't
+             * close the group the iteration was started from.
+             */
+            copy = open_group(group, ".");
+            if (NULL == copy || (group_id = H5VLwrap_register(copy, H5I_GROUP)) < 0) {
+                if (copy)
+                    tutorial_group_close(copy, H5P_DEFAULT, NULL);
+                release_group(parent, group);
+                return -1;
+            }
+
+            ret = iterate_links(group, NULL, iterate, group_id, &idx);
+
+            if (iterate->idx_p)
+                *iterate->idx_p = idx;
+
+            H5Gclose(group_id);
+            release_group(parent, group);
+            break;
+        }
+        case H5VL_LINK_DELETE: {
+            char *path = NULL;
+
+            if (find_link(parent, loc_params, &link) < 0 || !link.exists) {
+                release_link(parent, &link);
+                return -1;
+            }
+
+            /* Nothing logged for the object may be replayed into another
+             * one created with the same name later
+             */
+            if (parent->file->journal && (drain_write_buffer(parent->file, NULL, false) < 0 ||
+                                          checkpoint_journal(parent->file, true) < 0)) {
+                release_link(parent, &link);
+                return -1;
+            }
+
+            /* Remove the object's directory, then forget everything cached
+             * for it and whatever was inside it
+             */
+            if (remove_tree_parallel(parent->file, group_fd(link.group), link.name) < 0 ||
+                index_remove(group_fd(link.group), link.name) < 0)
+                ret = -1;
+
+            path = make_path(link.group->path, link.name, NULL);
+            cache_evict_tree(parent->file->cache, path);
+            free(path);
+
+            release_link(parent, &link);
+            break;
+        }
+        default:
+            return -1;
+    }
+
+    return ret;
+}
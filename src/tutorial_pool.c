@@ -0,0 +1,224 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Parallel dataset I/O for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              Large reads and writes are split into parts that are handed
+ *              to a per-file pool of threads. The thread that submits a job
+ *              works on its parts too, and idle pool threads take parts
+ *              from whichever job is oldest, so jobs for different datasets
+ *              that are in flight at once share the pool.
+ */
+
+#include <hdf5.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "tutorial_internal.h"
+#include "tutorial_pool.h"
+
+struct job {
+    struct job *   next;
+    tutorial_job_t func;
+    void *         job_data;
+    size_t         nparts;
+    size_t         next_part; /* The next part nobody has claimed */
+    size_t         nfinished;
+    herr_t         ret;
+};
+
+struct tutorial_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t  work;     /* Signaled when a job is queued or the threads should exit */
+    pthread_cond_t  finished; /* Broadcast when a part finishes */
+    struct job *    jobs;     /* Jobs with unclaimed parts, oldest first */
+    size_t          nthreads;
+    pthread_t *     threads;
+    hbool_t         stop;
+};
+
+/* Guards starting a file's pool, which can happen on the calling thread or
+ * the file's background thread
+ */
+static pthread_mutex_t start_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Claims the next part of a job and takes the job off the list once all its
+ * parts are claimed. Called with the pool lock held.
+ */
+static size_t
+claim_part(struct tutorial_pool *pool, struct job *job)
+{
+    size_t part = job->next_part++;
+
+    if (job->next_part == job->nparts) {
+        struct job **jp = &(pool->jobs);
+
+        while (*jp != job)
+            jp = &((*jp)->next);
+        *jp = job->next;
+    }
+
+    return part;
+}
+
+/* Runs a claimed part. Called with the pool lock held, which is dropped
+ * while the part runs.
+ */
+static void
+run_part(struct tutorial_pool *pool, struct job *job, size_t part)
+{
+    herr_t ret;
+
+    pthread_mutex_unlock(&pool->lock);
+    ret = job->func(part, job->job_data);
+    pthread_mutex_lock(&pool->lock);
+
+    if (ret < 0)
+        job->ret = -1;
+    job->nfinished++;
+    pthread_cond_broadcast(&pool->finished);
+}
+
+static void *
+pool_thread(void *arg)
+{
+    struct tutorial_pool *pool = (struct tutorial_pool *)arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        struct job *job;
+
+        while (NULL == pool->jobs && !pool->stop)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        if (NULL == pool->jobs)
+            break;
+
+        job = pool->jobs;
+        run_part(pool, job, claim_part(pool, job));
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static struct tutorial_pool *
+start_pool(struct tutorial_file *f)
+{
+    struct tutorial_pool *pool = NULL;
+
+    pthread_mutex_lock(&start_lock);
+
+    if (f->pool) {
+        pthread_mutex_unlock(&start_lock);
+        return f->pool;
+    }
+
+    pool          = calloc(1, sizeof(struct tutorial_pool));
+    pool->threads = calloc(f->nthreads, sizeof(pthread_t));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+
+    /* The thread that submits a job is one of the workers */
+    while (pool->nthreads < f->nthreads - 1 &&
+           pthread_create(&(pool->threads[pool->nthreads]), NULL, pool_thread, pool) == 0)
+        pool->nthreads++;
+
+    f->pool = pool;
+
+    pthread_mutex_unlock(&start_lock);
+
+    return pool;
+}
+
+/* The number of threads that work on f's jobs, including the caller */
+size_t
+pool_threads(const struct tutorial_file *f)
+{
+    return f->nthreads > 1 ? f->nthreads : 1;
+}
+
+/* Runs func on parts 0 to nparts - 1 of a job, in parallel when f has more
+ * than one thread. Returns once every part has finished, with -1 if any of
+ * them failed.
+ */
+herr_t
+run_parallel(struct tutorial_file *f, size_t nparts, tutorial_job_t func, void *job_data)
+{
+    struct tutorial_pool *pool = NULL;
+    struct job            job;
+    herr_t                ret  = 0;
+
+    if (nparts > 1 && pool_threads(f) > 1)
+        pool = start_pool(f);
+
+    if (NULL == pool || 0 == pool->nthreads) {
+        for (size_t part = 0; part < nparts; part++)
+            if (func(part, job_data) < 0)
+                ret = -1;
+        return ret;
+    }
+
+    job.next      = NULL;
+    job.func      = func;
+    job.job_data  = job_data;
+    job.nparts    = nparts;
+    job.next_part = 0;
+    job.nfinished = 0;
+    job.ret       = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    /* Queue the job behind any others */
+    {
+        struct job **jp = &(pool->jobs);
+
+        while (*jp)
+            jp = &((*jp)->next);
+        *jp = &job;
+    }
+    pthread_cond_broadcast(&pool->work);
+
+    /* Help with this job (only), then wait for the parts others took */
+    while (job.next_part < job.nparts)
+        run_part(pool, &job, claim_part(pool, &job));
+    while (job.nfinished < job.nparts)
+        pthread_cond_wait(&pool->finished, &pool->lock);
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return job.ret;
+}
+
+/* Shuts f's pool down. There are no jobs by then: run_parallel() only
+ * returns once its job is done.
+ */
+void
+stop_pool(struct tutorial_file *f)
+{
+    struct tutorial_pool *pool = f->pool;
+
+    if (NULL == pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->nthreads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+
+    f->pool = NULL;
+}
@@ -0,0 +1,26 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Parallel dataset I/O for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_POOL_H
+#define TUTORIAL_POOL_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+/* Handles one part of a job. Parts run at the same time on different
+ * threads, so they must not call into the HDF5 library.
+ */
+typedef herr_t (*tutorial_job_t)(size_t part, void *job_data);
+
+size_t pool_threads(const struct tutorial_file *f);
+herr_t run_parallel(struct tutorial_file *f, size_t nparts, tutorial_job_t func, void *job_data);
+void   stop_pool(struct tutorial_file *f);
+
+#endif /* TUTORIAL_POOL_H */
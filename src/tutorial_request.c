@@ -0,0 +1,365 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Asynchronous requests for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              Each file gets a background thread (started by its first
+ *              asynchronous operation) that runs tasks in the order they
+ *              were submitted. Callbacks do everything that needs the HDF5
+ *              library up front, on the calling thread, and hand the rest
+ *              to submit_task(). Without a request pointer the task runs
+ *              right away, once the tasks queued ahead of it are done, so
+ *              synchronous and asynchronous operations on a file never
+ *              overtake each other.
+ */
+
+#include <errno.h>
+#include <hdf5.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tutorial_batch.h"
+#include "tutorial_internal.h"
+#include "tutorial_request.h"
+
+/* A file's background thread and its queue of tasks */
+struct tutorial_task_queue {
+    pthread_t                thread;
+    pthread_cond_t           work; /* Signaled when a task is queued or the thread should exit */
+    struct tutorial_request *head;
+    struct tutorial_request *tail;
+    struct tutorial_request *running;
+    hbool_t                  stop;
+};
+
+struct tutorial_request {
+    /* The queue the task is (or was) on, and the next task on it */
+    struct tutorial_task_queue *queue;
+    struct tutorial_request *   next;
+
+    /* The work to do */
+    tutorial_task_t      func;
+    tutorial_task_free_t free_func;
+    void *               task_data;
+    hbool_t              cancelable;
+
+    /* IN_PROGRESS until the task has run or been canceled */
+    H5VL_request_status_t status;
+
+    /* The library has freed its handle, so the request goes once it's done */
+    hbool_t released;
+
+    /* Called when the request completes */
+    H5VL_request_notify_t notify;
+    void *                notify_ctx;
+};
+
+/* Guards all queues and requests. request_done is broadcast whenever a
+ * request completes.
+ */
+static pthread_mutex_t request_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  request_done = PTHREAD_COND_INITIALIZER;
+
+/*********/
+/* TASKS */
+/*********/
+
+/* Marks a request as done and lets anyone waiting for it know. Called with
+ * request_lock held, which is released before the notify callback runs.
+ */
+static void
+complete_request(struct tutorial_request *request, H5VL_request_status_t status)
+{
+    H5VL_request_notify_t notify     = request->notify;
+    void *                notify_ctx = request->notify_ctx;
+    hbool_t               released   = request->released;
+
+    request->status = status;
+    pthread_cond_broadcast(&request_done);
+    pthread_mutex_unlock(&request_lock);
+
+    if (notify)
+        notify(notify_ctx, status);
+    if (released)
+        free(request);
+}
+
+static void *
+task_thread(void *arg)
+{
+    struct tutorial_task_queue *queue = (struct tutorial_task_queue *)arg;
+
+    pthread_mutex_lock(&request_lock);
+
+    for (;;) {
+        struct tutorial_request *request = NULL;
+        herr_t                   ret;
+
+        while (NULL == queue->head && !queue->stop)
+            pthread_cond_wait(&queue->work, &request_lock);
+
+        /* Only exit once everything queued has run */
+        if (NULL == queue->head)
+            break;
+
+        request     = queue->head;
+        queue->head = request->next;
+        if (NULL == queue->head)
+            queue->tail = NULL;
+        queue->running = request;
+        pthread_mutex_unlock(&request_lock);
+
+        ret = request->func(request->task_data);
+        if (request->free_func)
+            request->free_func(request->task_data);
+
+        pthread_mutex_lock(&request_lock);
+        queue->running = NULL;
+        complete_request(request, ret >= 0 ? H5VL_REQUEST_STATUS_SUCCEED : H5VL_REQUEST_STATUS_FAIL);
+        pthread_mutex_lock(&request_lock);
+    }
+
+    pthread_mutex_unlock(&request_lock);
+
+    return NULL;
+}
+
+static struct tutorial_task_queue *
+start_task_thread(struct tutorial_file *f)
+{
+    struct tutorial_task_queue *queue = NULL;
+
+    if (f->tasks)
+        return f->tasks;
+
+    queue = calloc(1, sizeof(struct tutorial_task_queue));
+    pthread_cond_init(&queue->work, NULL);
+
+    if (pthread_create(&queue->thread, NULL, task_thread, queue) != 0) {
+        pthread_cond_destroy(&queue->work);
+        free(queue);
+        return NULL;
+    }
+
+    f->tasks = queue;
+
+    return queue;
+}
+
+/* Runs a task for an operation on f. With a request pointer, the task is
+ * queued for the file's background thread and a request handle is returned
+ * in *req. Otherwise it runs before this returns. Either way task_data is
+ * released with free_func afterwards.
+ */
+herr_t
+submit_task(struct tutorial_file *f, tutorial_task_t func, tutorial_task_free_t free_func, void *task_data,
+            hbool_t cancelable, void **req)
+{
+    struct tutorial_task_queue *queue   = NULL;
+    struct tutorial_request *   request = NULL;
+    herr_t                      ret     = 0;
+
+    /* Without a thread the operation just happens synchronously */
+    if (req)
+        queue = start_task_thread(f);
+
+    /* Anything held back in the file's batch goes before a queued task */
+    if (queue && f->batch)
+        wait_for_tasks(f);
+
+    if (NULL == queue) {
+        wait_for_tasks(f);
+
+        ret = func(task_data);
+        if (free_func)
+            free_func(task_data);
+
+        return ret;
+    }
+
+    request             = calloc(1, sizeof(struct tutorial_request));
+    request->queue      = queue;
+    request->func       = func;
+    request->free_func  = free_func;
+    request->task_data  = task_data;
+    request->cancelable = cancelable;
+    request->status     = H5VL_REQUEST_STATUS_IN_PROGRESS;
+
+    pthread_mutex_lock(&request_lock);
+    if (queue->tail)
+        queue->tail->next = request;
+    else
+        queue->head = request;
+    queue->tail = request;
+    pthread_cond_signal(&queue->work);
+    pthread_mutex_unlock(&request_lock);
+
+    *req = request;
+
+    return 0;
+}
+
+/* Waits until every task submitted for f has finished, and then runs
+ * whatever is held back in its batch
+ */
+void
+wait_for_tasks(struct tutorial_file *f)
+{
+    struct tutorial_task_queue *queue = f->tasks;
+
+    if (queue) {
+        pthread_mutex_lock(&request_lock);
+        while (queue->head || queue->running)
+            pthread_cond_wait(&request_done, &request_lock);
+        pthread_mutex_unlock(&request_lock);
+    }
+
+    flush_batch(f, false);
+}
+
+/* Finishes f's outstanding tasks and shuts its background thread down */
+void
+stop_task_thread(struct tutorial_file *f)
+{
+    struct tutorial_task_queue *queue = f->tasks;
+
+    if (NULL == queue)
+        return;
+
+    pthread_mutex_lock(&request_lock);
+    queue->stop = true;
+    pthread_cond_signal(&queue->work);
+    pthread_mutex_unlock(&request_lock);
+
+    pthread_join(queue->thread, NULL);
+    pthread_cond_destroy(&queue->work);
+    free(queue);
+
+    f->tasks = NULL;
+}
+
+/*************/
+/* CALLBACKS */
+/*************/
+
+herr_t
+tutorial_request_wait(void *_req, uint64_t timeout, H5VL_request_status_t *status)
+{
+    struct tutorial_request *request = (struct tutorial_request *)_req;
+
+    pthread_mutex_lock(&request_lock);
+
+    if (H5ES_WAIT_FOREVER == timeout) {
+        while (H5VL_REQUEST_STATUS_IN_PROGRESS == request->status)
+            pthread_cond_wait(&request_done, &request_lock);
+    }
+    else if (timeout > 0) {
+        struct timespec deadline;
+
+        /* The timeout is in nanoseconds */
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)(timeout / 1000000000);
+        deadline.tv_nsec += (long)(timeout % 1000000000);
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (H5VL_REQUEST_STATUS_IN_PROGRESS == request->status)
+            if (pthread_cond_timedwait(&request_done, &request_lock, &deadline) == ETIMEDOUT)
+                break;
+    }
+
+    *status = request->status;
+
+    pthread_mutex_unlock(&request_lock);
+
+    return 0;
+}
+
+herr_t
+tutorial_request_notify(void *_req, H5VL_request_notify_t cb, void *ctx)
+{
+    struct tutorial_request *request = (struct tutorial_request *)_req;
+    H5VL_request_status_t    status;
+
+    pthread_mutex_lock(&request_lock);
+
+    /* The callback runs on whichever thread completes the request */
+    if (H5VL_REQUEST_STATUS_IN_PROGRESS == request->status) {
+        request->notify     = cb;
+        request->notify_ctx = ctx;
+        pthread_mutex_unlock(&request_lock);
+        return 0;
+    }
+
+    status = request->status;
+    pthread_mutex_unlock(&request_lock);
+
+    return cb(ctx, status);
+}
+
+herr_t
+tutorial_request_cancel(void *_req, H5VL_request_status_t *status)
+{
+    struct tutorial_request *   request = (struct tutorial_request *)_req;
+    struct tutorial_task_queue *queue   = request->queue;
+    struct tutorial_request *   prev    = NULL;
+    struct tutorial_request *   cur     = NULL;
+
+    pthread_mutex_lock(&request_lock);
+
+    /* Only tasks that haven't started can be taken back off the queue */
+    if (H5VL_REQUEST_STATUS_IN_PROGRESS == request->status) {
+        for (cur = queue->head; cur && cur != request; cur = cur->next)
+            prev = cur;
+
+        if (NULL == cur || !request->cancelable) {
+            *status = H5VL_REQUEST_STATUS_CANT_CANCEL;
+            pthread_mutex_unlock(&request_lock);
+            return 0;
+        }
+
+        if (prev)
+            prev->next = request->next;
+        else
+            queue->head = request->next;
+        if (queue->tail == request)
+            queue->tail = prev;
+
+        if (request->free_func)
+            request->free_func(request->task_data);
+
+        *status = H5VL_REQUEST_STATUS_CANCELED;
+        complete_request(request, H5VL_REQUEST_STATUS_CANCELED);
+        return 0;
+    }
+
+    *status = request->status;
+    pthread_mutex_unlock(&request_lock);
+
+    return 0;
+}
+
+herr_t
+tutorial_request_free(void *_req)
+{
+    struct tutorial_request *request = (struct tutorial_request *)_req;
+
+    /* A request that's still running is freed when it completes */
+    pthread_mutex_lock(&request_lock);
+    if (H5VL_REQUEST_STATUS_IN_PROGRESS == request->status) {
+        request->released = true;
+        pthread_mutex_unlock(&request_lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&request_lock);
+
+    free(request);
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Asynchronous requests for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_REQUEST_H
+#define TUTORIAL_REQUEST_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+/* The part of an operation that touches the disk. Tasks run on a background
+ * thread, so they must not call into the HDF5 library.
+ */
+typedef herr_t (*tutorial_task_t)(void *task_data);
+
+/* Releases a task's data once it has run (or been canceled) */
+typedef void (*tutorial_task_free_t)(void *task_data);
+
+herr_t submit_task(struct tutorial_file *f, tutorial_task_t func, tutorial_task_free_t free_func,
+                   void *task_data, hbool_t cancelable, void **req);
+void   wait_for_tasks(struct tutorial_file *f);
+void   stop_task_thread(struct tutorial_file *f);
+
+#endif /* TUTORIAL_REQUEST_H */
@@ -0,0 +1,432 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Text encoding of elements for a simple tutorial virtual
+ *              object layer (VOL) connector
+ *
+ *              Text data files hold one decimal element per line. Whole
+ *              blocks of elements are encoded into and decoded from large
+ *              buffers. Integers avoid stdio entirely: digits are produced
+ *              two at a time from a table and parsed eight at a time with
+ *              64-bit word arithmetic.
+ */
+
+#include <hdf5.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tutorial_internal.h"
+#include "tutorial_text.h"
+
+/* "00" to "99" */
+static const char digit_pairs[201] = "0001020304050607080910111213141516171819"
+                                     "2021222324252627282930313233343536373839"
+                                     "4041424344454647484950515253545556575859"
+                                     "6061626364656667686970717273747576777879"
+                                     "8081828384858687888990919293949596979899";
+
+static int64_t
+load_signed(const char *p, size_t size)
+{
+    switch (size) {
+        case 1: {
+            int8_t v;
+            memcpy(&v, p, 1);
+            return v;
+        }
+        case 2: {
+            int16_t v;
+            memcpy(&v, p, 2);
+            return v;
+        }
+        case 4: {
+            int32_t v;
+            memcpy(&v, p, 4);
+            return v;
+        }
+        default: {
+            int64_t v;
+            memcpy(&v, p, 8);
+            return v;
+        }
+    }
+}
+
+static uint64_t
+load_unsigned(const char *p, size_t size)
+{
+    switch (size) {
+        case 1: {
+            uint8_t v;
+            memcpy(&v, p, 1);
+            return v;
+        }
+        case 2: {
+            uint16_t v;
+            memcpy(&v, p, 2);
+            return v;
+        }
+        case 4: {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            return v;
+        }
+        default: {
+            uint64_t v;
+            memcpy(&v, p, 8);
+            return v;
+        }
+    }
+}
+
+/* Stores the low size bytes of v (values out of range wrap, like a cast) */
+static void
+store_integer(char *p, size_t size, uint64_t v)
+{
+    switch (size) {
+        case 1: {
+            uint8_t x = (uint8_t)v;
+            memcpy(p, &x, 1);
+            break;
+        }
+        case 2: {
+            uint16_t x = (uint16_t)v;
+            memcpy(p, &x, 2);
+            break;
+        }
+        case 4: {
+            uint32_t x = (uint32_t)v;
+            memcpy(p, &x, 4);
+            break;
+        }
+        default:
+            memcpy(p, &v, 8);
+            break;
+    }
+}
+
+static hbool_t
+is_space(char c)
+{
+    return ' ' == c || '\n' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c;
+}
+
+/************/
+/* ENCODING */
+/************/
+
+/* Writes the decimal digits of v and returns how many there were */
+static size_t
+encode_uint64(uint64_t v, char *out)
+{
+    char   tmp[20];
+    char * p = tmp + sizeof(tmp);
+    size_t len;
+
+    while (v >= 100) {
+        unsigned pair = (unsigned)(v % 100);
+
+        v /= 100;
+        p -= 2;
+        memcpy(p, digit_pairs + 2 * pair, 2);
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + 2 * v, 2);
+    }
+    else
+        *--p = (char)('0' + v);
+
+    len = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, len);
+
+    return len;
+}
+
+/* Formats n native-order elements, one per line. out must have room for
+ * n * TEXT_MAX_ELMT_LEN bytes. Returns the number of bytes written.
+ */
+size_t
+encode_text(const struct tutorial_type *type, const void *elmts, size_t n, char *out)
+{
+    const char *src = (const char *)elmts;
+    char *      p   = out;
+    size_t      es  = type->size;
+
+    if (H5T_FLOAT == type->cls) {
+        /* Float formatting is left to the C library */
+        for (size_t i = 0; i < n; i++) {
+            p += format_element(type, src + i * es, p, TEXT_MAX_ELMT_LEN);
+            *p++ = '\n';
+        }
+    }
+    else if (H5T_SGN_2 == type->sign) {
+        for (size_t i = 0; i < n; i++) {
+            int64_t  v = load_signed(src + i * es, es);
+            uint64_t u = (uint64_t)v;
+
+            if (v < 0) {
+                *p++ = '-';
+                u    = 0 - u;
+            }
+            p += encode_uint64(u, p);
+            *p++ = '\n';
+        }
+    }
+    else {
+        for (size_t i = 0; i < n; i++) {
+            p += encode_uint64(load_unsigned(src + i * es, es), p);
+            *p++ = '\n';
+        }
+    }
+
+    return (size_t)(p - out);
+}
+
+/************/
+/* DECODING */
+/************/
+
+/* Loads 8 characters with the first one in the low byte */
+static uint64_t
+load_chars(const char *p)
+{
+    uint64_t v = 0;
+
+    for (int i = 7; i >= 0; i--)
+        v = (v << 8) | (unsigned char)p[i];
+
+    return v;
+}
+
+/* Whether all 8 characters are '0' to '9' */
+static hbool_t
+all_digits(uint64_t v)
+{
+    return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+           0x3333333333333333ull;
+}
+
+/* Value of 8 digit characters, combining pairs, then quads, then halves */
+static uint64_t
+eight_digits(uint64_t v)
+{
+    v = ((v & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+    v = ((v & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+
+    return ((v & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32;
+}
+
+/* Parses up to n whitespace-separated elements from in, into native order.
+ * A token that runs into the end of the buffer is left for the next call
+ * (callers add a trailing newline once the whole file has been read).
+ * *consumed is set to the number of bytes used, and *malformed is set if
+ * parsing stopped at something that isn't a number. Returns the number of
+ * elements parsed.
+ */
+size_t
+decode_text(const struct tutorial_type *type, const char *in, size_t len, void *elmts, size_t n,
+            size_t *consumed, hbool_t *malformed)
+{
+    const char *p     = in;
+    const char *end   = in + len;
+    char *      dst   = (char *)elmts;
+    size_t      es    = type->size;
+    size_t      count = 0;
+
+    *malformed = false;
+
+    while (count < n) {
+        const char *tok;
+
+        while (p < end && is_space(*p))
+            p++;
+        if (p == end)
+            break;
+        tok = p;
+
+        if (H5T_FLOAT == type->cls) {
+            char   word[64];
+            size_t wlen;
+
+            while (p < end && !is_space(*p))
+                p++;
+            if (p == end) {
+                p = tok;
+                break;
+            }
+
+            wlen = (size_t)(p - tok);
+            if (wlen < sizeof(word)) {
+                memcpy(word, tok, wlen);
+                word[wlen] = '\0';
+            }
+            if (wlen >= sizeof(word) || parse_element(type, word, dst + count * es) < 0) {
+                *malformed = true;
+                p          = tok;
+                break;
+            }
+        }
+        else {
+            hbool_t     neg = false;
+            uint64_t    v   = 0;
+            const char *digits;
+
+            if ('-' == *p || '+' == *p)
+                neg = ('-' == *p++);
+            digits = p;
+
+            /* Eight digits per step, then one at a time */
+            while (end - p >= 8) {
+                uint64_t chars = load_chars(p);
+
+                if (!all_digits(chars))
+                    break;
+                v = v * 100000000ull + eight_digits(chars);
+                p += 8;
+            }
+            while (p < end && *p >= '0' && *p <= '9')
+                v = v * 10 + (uint64_t)(*p++ - '0');
+
+            if (p == end) {
+                p = tok;
+                break;
+            }
+            if (p == digits || !is_space(*p)) {
+                *malformed = true;
+                p          = tok;
+                break;
+            }
+
+            store_integer(dst + count * es, es, neg ? 0 - v : v);
+        }
+
+        count++;
+    }
+
+    *consumed = (size_t)(p - in);
+
+    return count;
+}
+
+/*************/
+/* SPLITTING */
+/*************/
+
+/* The length of the text up to and including its last whitespace, so that
+ * every token in it is complete
+ */
+size_t
+complete_text_len(const char *in, size_t len)
+{
+    while (len > 0 && !is_space(in[len - 1]))
+        len--;
+
+    return len;
+}
+
+/* The offset just past the whitespace that ends the token at (or after)
+ * pos, or len if the token runs to the end
+ */
+size_t
+skip_token(const char *in, size_t len, size_t pos)
+{
+    while (pos < len && !is_space(in[pos]))
+        pos++;
+
+    return pos < len ? pos + 1 : len;
+}
+
+/* The number of whitespace-separated tokens in the text. Splitting text at
+ * the offsets skip_token() returns and counting each piece tells where the
+ * elements in each piece go, so the pieces can be decoded independently.
+ */
+size_t
+count_text(const char *in, size_t len)
+{
+    size_t  count    = 0;
+    hbool_t in_token = false;
+
+    for (size_t i = 0; i < len; i++) {
+        hbool_t space = is_space(in[i]);
+
+        count += (!space && !in_token);
+        in_token = !space;
+    }
+
+    return count;
+}
+
+/*******************/
+/* SINGLE ELEMENTS */
+/*******************/
+
+/* Formats one native-order element. Returns the length, like snprintf. */
+int
+format_element(const struct tutorial_type *type, const void *elmt, char *out, size_t len)
+{
+    if (H5T_FLOAT == type->cls) {
+        if (4 == type->size) {
+            float v;
+
+            memcpy(&v, elmt, sizeof(v));
+            return snprintf(out, len, "%.9g", (double)v);
+        }
+        else {
+            double v;
+
+            memcpy(&v, elmt, sizeof(v));
+            return snprintf(out, len, "%.17g", v);
+        }
+    }
+
+    if (H5T_SGN_2 == type->sign)
+        return snprintf(out, len, "%" PRId64, load_signed((const char *)elmt, type->size));
+
+    return snprintf(out, len, "%" PRIu64, load_unsigned((const char *)elmt, type->size));
+}
+
+/* Parses one element into native order */
+herr_t
+parse_element(const struct tutorial_type *type, const char *text, void *elmt)
+{
+    char *end = NULL;
+
+    if (H5T_FLOAT == type->cls) {
+        double v = strtod(text, &end);
+
+        if (end == text)
+            return -1;
+        if (4 == type->size) {
+            float f = (float)v;
+
+            memcpy(elmt, &f, sizeof(f));
+        }
+        else
+            memcpy(elmt, &v, sizeof(v));
+
+        return 0;
+    }
+
+    if (H5T_SGN_2 == type->sign) {
+        int64_t v = (int64_t)strtoll(text, &end, 10);
+
+        if (end == text)
+            return -1;
+        store_integer((char *)elmt, type->size, (uint64_t)v);
+    }
+    else {
+        uint64_t v = (uint64_t)strtoull(text, &end, 10);
+
+        if (end == text)
+            return -1;
+        store_integer((char *)elmt, type->size, v);
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Text encoding of elements for a simple tutorial virtual
+ *              object layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_TEXT_H
+#define TUTORIAL_TEXT_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+/* Longest text form of one element, including its newline */
+#define TEXT_MAX_ELMT_LEN 32
+
+size_t encode_text(const struct tutorial_type *type, const void *elmts, size_t n, char *out);
+size_t decode_text(const struct tutorial_type *type, const char *in, size_t len, void *elmts, size_t n,
+                   size_t *consumed, hbool_t *malformed);
+
+size_t complete_text_len(const char *in, size_t len);
+size_t skip_token(const char *in, size_t len, size_t pos);
+size_t count_text(const char *in, size_t len);
+
+int    format_element(const struct tutorial_type *type, const void *elmt, char *out, size_t len);
+herr_t parse_element(const struct tutorial_type *type, const char *text, void *elmt);
+
+#endif /* TUTORIAL_TEXT_H */
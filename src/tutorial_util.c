@@ -3,13 +3,26 @@
  * All rights reserved.                                                      *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <hdf5.h>
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "tutorial_arena.h"
 #include "tutorial_internal.h"
+#include "tutorial_pool.h"
 #include "tutorial_util.h"
 
+/* Parts per pool thread that removing a tree is split into, so threads that
+ * get small subtrees can take more
+ */
+#define REMOVAL_PARTS_PER_THREAD 16
+
 char *
 make_path(const char *component1, const char *component2, const char *ext)
 {
@@ -38,20 +51,291 @@ make_path(const char *component1, const char *component2, const char *ext)
     return out;
 }
 
+/* FNV-1a */
+uint64_t
+hash_string(const char *str, size_t len)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/* The last component of a (possibly multi-component) object name */
+const char *
+base_name(const char *name)
+{
+    const char *slash = strrchr(name, '/');
+
+    return slash ? slash + 1 : name;
+}
+
+/* Opens <name>.<ext> (or just name, when ext is NULL) relative to the
+ * directory dir_fd, so the kernel doesn't walk the whole path again.
+ * Returns a file descriptor, or -1.
+ */
+int
+open_at(int dir_fd, const char *name, const char *ext, int flags)
+{
+    char   file_name[NAME_MAX + 1];
+    size_t len;
+
+    if (ext)
+        len = (size_t)snprintf(file_name, sizeof(file_name), "%s.%s", name, ext);
+    else
+        len = (size_t)snprintf(file_name, sizeof(file_name), "%s", name);
+    if (len >= sizeof(file_name)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    return openat(dir_fd, file_name, flags, 0666);
+}
+
+/* The same as open_at(), but returns a stream opened with an fopen() mode
+ * ("r", "r+", "w" or "w+")
+ */
+FILE *
+fopen_at(int dir_fd, const char *name, const char *ext, const char *mode)
+{
+    FILE *stream = NULL;
+    int   flags  = ('+' == mode[1]) ? O_RDWR : ('r' == mode[0] ? O_RDONLY : O_WRONLY);
+    int   fd;
+
+    if ('w' == mode[0])
+        flags |= O_CREAT | O_TRUNC;
+
+    if ((fd = open_at(dir_fd, name, ext, flags)) < 0)
+        return NULL;
+    if (NULL == (stream = fdopen(fd, mode)))
+        close(fd);
+
+    return stream;
+}
+
+/* Removes name, relative to the directory dir_fd, along with everything
+ * under it if it's a directory
+ */
+int
+remove_tree(int dir_fd, const char *name)
+{
+    DIR *          dir   = NULL;
+    struct dirent *entry = NULL;
+    int            ret   = 0;
+
+    if (0 == unlinkat(dir_fd, name, 0))
+        return 0;
+
+    if (NULL == (dir = opendir_at(dir_fd, name)))
+        return -1;
+    while (NULL != (entry = readdir(dir)))
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+            if (remove_tree(dirfd(dir), entry->d_name) < 0)
+                ret = -1;
+    closedir(dir);
+
+    if (unlinkat(dir_fd, name, AT_REMOVEDIR) < 0)
+        ret = -1;
+
+    return ret;
+}
+
+/* Something to remove, relative to the directory dir_fd */
+struct removal_entry {
+    int   dir_fd;
+    char *name;
+};
+
+/* A directory listed to find more to remove */
+struct removal_dir {
+    int   parent_fd;
+    char *name;
+    DIR * dir;
+};
+
+/* A tree being removed in parallel */
+struct removal {
+    /* Everything found so far. The entries before first were directories
+     * that have been listed, or files that have been removed.
+     */
+    struct removal_entry *entries;
+    size_t                nentries;
+    size_t                cap;
+    size_t                first;
+
+    /* The listed directories, in the order they were listed */
+    struct removal_dir *dirs;
+    size_t              ndirs;
+    size_t              dirs_cap;
+
+    size_t nparts;
+};
+
+static void
+add_removal_entry(struct removal *rm, int dir_fd, const char *name)
+{
+    if (rm->nentries == rm->cap) {
+        rm->cap     = rm->cap ? 2 * rm->cap : 64;
+        rm->entries = realloc(rm->entries, rm->cap * sizeof(struct removal_entry));
+    }
+    rm->entries[rm->nentries].dir_fd = dir_fd;
+    rm->entries[rm->nentries].name   = strdup(name);
+    rm->nentries++;
+}
+
+static herr_t
+removal_part(size_t part, void *job_data)
+{
+    struct removal *rm  = (struct removal *)job_data;
+    size_t          n   = rm->nentries - rm->first;
+    size_t          end = rm->first + (part + 1) * n / rm->nparts;
+    herr_t          ret = 0;
+
+    for (size_t i = rm->first + part * n / rm->nparts; i < end; i++)
+        if (remove_tree(rm->entries[i].dir_fd, rm->entries[i].name) < 0)
+            ret = -1;
+
+    return ret;
+}
+
+/* Removes name like remove_tree(), with the work shared out over f's pool.
+ * Directories are listed breadth first until there are enough entries to
+ * go round, then each part removes whole subtrees, and the listed
+ * directories are removed last, deepest first.
+ */
+int
+remove_tree_parallel(struct tutorial_file *f, int dir_fd, const char *name)
+{
+    struct removal rm;
+    size_t         target = pool_threads(f) * REMOVAL_PARTS_PER_THREAD;
+    int            ret    = 0;
+
+    /* With one thread there's nothing to share */
+    if (pool_threads(f) < 2)
+        return remove_tree(dir_fd, name);
+
+    memset(&rm, 0, sizeof(rm));
+    add_removal_entry(&rm, dir_fd, name);
+
+    while (rm.first < rm.nentries && rm.nentries - rm.first < target) {
+        struct removal_entry entry = rm.entries[rm.first++];
+        struct dirent *      child = NULL;
+        DIR *                dir   = NULL;
+
+        if (0 == unlinkat(entry.dir_fd, entry.name, 0)) {
+            free(entry.name);
+            continue;
+        }
+        if (NULL == (dir = opendir_at(entry.dir_fd, entry.name))) {
+            free(entry.name);
+            ret = -1;
+            continue;
+        }
+
+        if (rm.ndirs == rm.dirs_cap) {
+            rm.dirs_cap = rm.dirs_cap ? 2 * rm.dirs_cap : 16;
+            rm.dirs     = realloc(rm.dirs, rm.dirs_cap * sizeof(struct removal_dir));
+        }
+        rm.dirs[rm.ndirs].parent_fd = entry.dir_fd;
+        rm.dirs[rm.ndirs].name      = entry.name;
+        rm.dirs[rm.ndirs].dir       = dir;
+        rm.ndirs++;
+
+        while (NULL != (child = readdir(dir)))
+            if (strcmp(child->d_name, ".") != 0 && strcmp(child->d_name, "..") != 0)
+                add_removal_entry(&rm, dirfd(dir), child->d_name);
+    }
+
+    rm.nparts = rm.nentries - rm.first < target ? rm.nentries - rm.first : target;
+    if (rm.nparts > 0 && run_parallel(f, rm.nparts, removal_part, &rm) < 0)
+        ret = -1;
+
+    /* A directory's subdirectories were listed after it */
+    for (size_t i = rm.ndirs; i-- > 0;) {
+        if (unlinkat(rm.dirs[i].parent_fd, rm.dirs[i].name, AT_REMOVEDIR) < 0)
+            ret = -1;
+        closedir(rm.dirs[i].dir);
+        free(rm.dirs[i].name);
+    }
+
+    for (size_t i = rm.first; i < rm.nentries; i++)
+        free(rm.entries[i].name);
+    free(rm.entries);
+    free(rm.dirs);
+
+    return ret;
+}
+
+/* Opens the directory name relative to the directory dir_fd */
+DIR *
+opendir_at(int dir_fd, const char *name)
+{
+    DIR *dir = NULL;
+    int  fd;
+
+    if ((fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY)) < 0)
+        return NULL;
+    if (NULL == (dir = fdopendir(fd)))
+        close(fd);
+
+    return dir;
+}
+
+/* Absolute names are looked up from the file's root group, wherever they
+ * were given. Returns the group that name is relative to, with any leading
+ * slashes skipped (a name that was nothing but slashes becomes ".").
+ */
+struct tutorial_object *
+resolve_name(struct tutorial_object *parent, const char **name)
+{
+    if ('/' == **name) {
+        parent = parent->file->root;
+        while ('/' == **name)
+            (*name)++;
+        if ('\0' == **name)
+            *name = ".";
+    }
+
+    return parent;
+}
+
 struct tutorial_object *
-make_object(H5I_type_t type, const char *parent_path, const char *name)
+make_object(struct tutorial_file *file, H5I_type_t type, const char *parent_path, const char *name)
 {
     struct tutorial_object *obj = NULL;
+    char                    path[PATH_MAX];
+    int                     len;
 
     /* Create the new object */
-    obj = calloc(1, sizeof(struct tutorial_object));
+    obj = arena_alloc_object(file->arena);
 
-    /* Set the object type */
+    /* Set the object type and file, which is kept until the object is
+     * destroyed
+     */
     obj->type = type;
+    obj->file = file;
+    file->nrefs++;
+
+    /* Set the name and path, which the file's arena keeps a single copy of
+     * however many times the object is opened
+     */
+    obj->name = arena_intern(file->arena, name, strlen(name));
 
-    /* Set the name and path */
-    obj->name = strdup(name);
-    obj->path = make_path(parent_path, name, NULL);
+    /* "." is the parent itself, so it gets the same path */
+    if (0 == strcmp(name, "."))
+        obj->path = arena_intern(file->arena, parent_path, strlen(parent_path));
+    else if ((size_t)(len = snprintf(path, sizeof(path), "%s/%s", parent_path, name)) < sizeof(path))
+        obj->path = arena_intern(file->arena, path, (size_t)len);
+    else {
+        char *long_path = make_path(parent_path, name, NULL);
+
+        obj->path = arena_intern(file->arena, long_path, strlen(long_path));
+        free(long_path);
+    }
 
     return obj;
 }
@@ -59,7 +343,28 @@ make_object(H5I_type_t type, const char *parent_path, const char *name)
 void
 destroy_object(struct tutorial_object **obj)
 {
-    free((*obj)->name);
-    free((*obj)->path);
-    free(*obj);
+    struct tutorial_file *file = (*obj)->file;
+
+    arena_free_object(file->arena, *obj);
+    *obj = NULL;
+
+    release_file(file);
+}
+
+int
+get_int_property(hid_t plist_id, const char *name, int default_value)
+{
+    int value = default_value;
+
+    /* Connector properties are optional and get inserted by the user, so
+     * their absence just means "use the default".
+     */
+    if (H5P_DEFAULT == plist_id)
+        return default_value;
+
+    if (H5Pexist(plist_id, name) > 0)
+        if (H5Pget(plist_id, name, &value) < 0)
+            value = default_value;
+
+    return value;
 }
@@ -10,12 +10,25 @@
 #ifndef TUTORIAL_UTIL_H
 #define TUTORIAL_UTIL_H
 
+#include <dirent.h>
 #include <hdf5.h>
+#include <stdint.h>
+#include <stdio.h>
 
 #include "tutorial_internal.h"
 
 char *                  make_path(const char *component1, const char *component2, const char *ext);
-struct tutorial_object *make_object(H5I_type_t type, const char *parent_path, const char *name);
+uint64_t                hash_string(const char *str, size_t len);
+const char *            base_name(const char *name);
+int                     open_at(int dir_fd, const char *name, const char *ext, int flags);
+FILE *                  fopen_at(int dir_fd, const char *name, const char *ext, const char *mode);
+int                     remove_tree(int dir_fd, const char *name);
+int                     remove_tree_parallel(struct tutorial_file *f, int dir_fd, const char *name);
+DIR *                   opendir_at(int dir_fd, const char *name);
+struct tutorial_object *resolve_name(struct tutorial_object *parent, const char **name);
+struct tutorial_object *make_object(struct tutorial_file *file, H5I_type_t type, const char *parent_path,
+                                    const char *name);
 void                    destroy_object(struct tutorial_object **obj);
+int                     get_int_property(hid_t plist_id, const char *name, int default_value);
 
 #endif /* TUTORIAL_UTIL_H */
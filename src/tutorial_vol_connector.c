@@ -16,6 +16,14 @@
 #include "tutorial_vol_connector.h"
 #include "tutorial_internal.h"
 
+/* Files deleted in the background are finished before the library goes */
+static herr_t
+tutorial_terminate(void)
+{
+    wait_for_deletes();
+    return 0;
+}
+
 /* The VOL class struct */
 static const H5VL_class_t tutorial_vol_g = {
     H5VL_VERSION,                 /* VOL class struct version */
@@ -24,7 +32,7 @@ static const H5VL_class_t tutorial_vol_g = {
     1,                            /* connector version */
     0,                            /* capability flags */
     NULL,                         /* initialize       */
-    NULL,                         /* terminate        */
+    tutorial_terminate,           /* terminate        */
     {
         /* info_cls */
         (size_t)0, /* size             */
@@ -44,25 +52,25 @@ static const H5VL_class_t tutorial_vol_g = {
     },
     {
         /* attribute_cls */
-        NULL, /* create           */
-        NULL, /* open             */
-        NULL, /* read             */
-        NULL, /* write            */
-        NULL, /* get              */
-        NULL, /* specific         */
-        NULL, /* optional         */
-        NULL  /* close            */
+        tutorial_attr_create,   /* create           */
+        tutorial_attr_open,     /* open             */
+        tutorial_attr_read,     /* read             */
+        tutorial_attr_write,    /* write            */
+        tutorial_attr_get,      /* get              */
+        tutorial_attr_specific, /* specific         */
+        NULL,                   /* optional         */
+        tutorial_attr_close     /* close            */
     },
     {
         /* dataset_cls */
-        tutorial_dataset_create, /* create           */
-        tutorial_dataset_open,   /* open             */
-        tutorial_dataset_read,   /* read             */
-        tutorial_dataset_write,  /* write            */
-        NULL,                    /* get              */
-        NULL,                    /* specific         */
-        NULL,                    /* optional         */
-        tutorial_dataset_close   /* close            */
+        tutorial_dataset_create,   /* create           */
+        tutorial_dataset_open,     /* open             */
+        tutorial_dataset_read,     /* read             */
+        tutorial_dataset_write,    /* write            */
+        tutorial_dataset_get,      /* get              */
+        tutorial_dataset_specific, /* specific         */
+        NULL,                      /* optional         */
+        tutorial_dataset_close     /* close            */
     },
     {
         /* datatype_cls */
@@ -86,19 +94,19 @@ static const H5VL_class_t tutorial_vol_g = {
         /* group_cls */
         tutorial_group_create, /* create           */
         tutorial_group_open,   /* open             */
-        NULL,                  /* get              */
+        tutorial_group_get,    /* get              */
         NULL,                  /* specific         */
         NULL,                  /* optional         */
         tutorial_group_close   /* close            */
     },
     {
         /* link_cls */
-        NULL, /* create           */
-        NULL, /* copy             */
-        NULL, /* move             */
-        NULL, /* get              */
-        NULL, /* specific         */
-        NULL  /* optional         */
+        NULL,                   /* create           */
+        NULL,                   /* copy             */
+        NULL,                   /* move             */
+        tutorial_link_get,      /* get              */
+        tutorial_link_specific, /* specific         */
+        NULL                    /* optional         */
     },
     {
         /* object_cls */
@@ -116,12 +124,12 @@ static const H5VL_class_t tutorial_vol_g = {
     },
     {
         /* request_cls */
-        NULL, /* wait             */
-        NULL, /* notify           */
-        NULL, /* cancel           */
-        NULL, /* specific         */
-        NULL, /* optional         */
-        NULL  /* free             */
+        tutorial_request_wait,   /* wait             */
+        tutorial_request_notify, /* notify           */
+        tutorial_request_cancel, /* cancel           */
+        NULL,                    /* specific         */
+        NULL,                    /* optional         */
+        tutorial_request_free    /* free             */
     },
     {
         /* blob_cls */
@@ -12,4 +12,83 @@
 #define TUTORIAL_VOL_CONNECTOR_VALUE ((H5VL_class_value_t)198)
 #define TUTORIAL_VOL_CONNECTOR_NAME  "tutorial_vol_connector"
 
+/* Optional property that selects the on-disk format of a dataset's data
+ * file. Add it to a dataset creation property list (or to the file access
+ * property list to set a default for every dataset in the file) with
+ * H5Pinsert2() as an int holding one of the TUTORIAL_VOL_DATA_FORMAT_*
+ * values. Binary is the default.
+ */
+#define TUTORIAL_VOL_DATA_FORMAT_PROP   "tutorial_vol_data_format"
+#define TUTORIAL_VOL_DATA_FORMAT_BINARY 0
+#define TUTORIAL_VOL_DATA_FORMAT_TEXT   1
+
+/* Optional property that memory-maps binary data files instead of going
+ * through stdio. Add it to a dataset access property list (or to the file
+ * access property list to map every dataset in the file) with H5Pinsert2()
+ * as a nonzero int. Changes are msync'd on H5Dflush() and H5Dclose().
+ */
+#define TUTORIAL_VOL_MMAP_PROP "tutorial_vol_mmap"
+
+/* Optional property that sets the number of threads that share the work of
+ * large dataset reads and writes in a file. Add it to the file access
+ * property list with H5Pinsert2() as an int. The default (0) is one thread
+ * per online processor, and 1 does all I/O on the calling thread.
+ */
+#define TUTORIAL_VOL_NTHREADS_PROP "tutorial_vol_nthreads"
+
+/* Optional property that gives every group created in a file a hashed index
+ * of its members' names, so checking whether a link exists (or whether it
+ * leads to a group or a dataset) doesn't need a directory scan or stat
+ * calls. Add it to the file access property list with H5Pinsert2() as a
+ * nonzero int. Indexes are kept up to date whenever the file is opened.
+ */
+#define TUTORIAL_VOL_GROUP_INDEX_PROP "tutorial_vol_group_index"
+
+/* Optional property that holds back creating groups and datasets on disk,
+ * along with writes to new datasets, until something needs them or the
+ * file is flushed or closed, and then creates them all at once, in
+ * parallel. Add it to the file access property list with H5Pinsert2() as a
+ * nonzero int. Errors in batched operations are reported by H5Fflush() and
+ * H5Fclose().
+ */
+#define TUTORIAL_VOL_BATCH_CREATE_PROP "tutorial_vol_batch_create"
+
+/* Optional property that buffers writes of fewer than this many bytes to
+ * binary, contiguous datasets that aren't memory-mapped, and writes them
+ * out together once the buffer holds this many bytes. Writes that carry on
+ * where the last one to the dataset left off are written out in one call.
+ * Add it to the file access property list with H5Pinsert2() as an int. The
+ * buffer is also written out by H5Fflush() and H5Fclose(), which report any
+ * errors, and a dataset's part of it by H5Dflush() and H5Dclose().
+ */
+#define TUTORIAL_VOL_WRITE_BUFFER_PROP "tutorial_vol_write_buffer"
+
+/* Optional property that also writes out the write buffer once its oldest
+ * write is this many milliseconds old, checked whenever something is added
+ * to it. Add it to the file access property list with H5Pinsert2() as an
+ * int. Without it, writes stay buffered until one of the other triggers.
+ */
+#define TUTORIAL_VOL_WRITE_BUFFER_MS_PROP "tutorial_vol_write_buffer_ms"
+
+/* Optional property that makes dataset writes survive a crash. Writes to
+ * binary, contiguous datasets all go through the write buffer (4 MiB unless
+ * TUTORIAL_VOL_WRITE_BUFFER_PROP says otherwise), and whatever is written
+ * out at once is first logged in the file's journal with a single sync, so
+ * they're durable once H5Dflush(), H5Dclose(), H5Fflush() or H5Fclose()
+ * returns. Files that are rewritten whole (text data files and chunks) are
+ * replaced in one step instead. Add it to the file access property list
+ * with H5Pinsert2() as a nonzero int. Opening the file replays whatever a
+ * crash left in its journal, with or without the property.
+ */
+#define TUTORIAL_VOL_DURABLE_PROP "tutorial_vol_durable"
+
+/* Optional property that makes H5Fdelete() return straight away. The file
+ * is renamed out of the way, so its name can be used again at once, and
+ * removed by a background thread (over TUTORIAL_VOL_NTHREADS_PROP threads,
+ * like any other delete). Add it to the file access property list passed to
+ * H5Fdelete() with H5Pinsert2() as a nonzero int. Deletes still running when
+ * the library closes are waited for.
+ */
+#define TUTORIAL_VOL_DELETE_IN_BACKGROUND_PROP "tutorial_vol_delete_in_background"
+
 #endif /* TUTORIAL_VOL_CONNECTOR_H */
@@ -0,0 +1,280 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Write-back buffering for a simple tutorial virtual object
+ *              layer (VOL) connector
+ *
+ *              In a file opened with TUTORIAL_VOL_WRITE_BUFFER_PROP, small
+ *              writes to binary data files are copied into the file's write
+ *              buffer instead of going to disk straight away. Each dataset's
+ *              buffered bytes are kept as runs, and a write that carries on
+ *              where the dataset's last one left off (as appends do) joins
+ *              its run, so the buffer is drained with one pwrite() per run
+ *              rather than one per write. The buffer is drained once it
+ *              holds the configured number of bytes, or the oldest bytes in
+ *              it are older than TUTORIAL_VOL_WRITE_BUFFER_MS_PROP, as well
+ *              as on H5Fflush() and H5Fclose(). A dataset's own bytes are
+ *              drained before anything else reads or changes it, and when
+ *              it is flushed or closed.
+ *
+ *              The buffer is only used by the file's tasks, which never run
+ *              at the same time, and by whatever waits for them, so it needs
+ *              no lock. Batched writes, which run on the thread pool, don't
+ *              use it (see flush_batch()).
+ *
+ *              In a file with a journal, every write to a binary data file
+ *              goes through the buffer, and whatever is drained at once is
+ *              committed to the journal as one transaction before any of it
+ *              is written. Writes bigger than the buffer go through it a
+ *              buffer's worth at a time.
+ */
+
+#include <hdf5.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tutorial_internal.h"
+#include "tutorial_journal.h"
+#include "tutorial_pool.h"
+#include "tutorial_writeback.h"
+
+/* An object's buffered bytes. Every handle on the object shares them, so
+ * they stay in the order they were written whichever handle wrote them.
+ */
+struct tutorial_wb_entry {
+    struct tutorial_wb_entry *next;
+    struct tutorial_object *        obj; /* The handle that drains them */
+    const struct tutorial_wb_class *cls;
+
+    /* The handles that have written them, which point to the entry */
+    struct tutorial_object **handles;
+    size_t                   nhandles;
+    size_t                   handles_cap;
+
+    /* The runs, in the order they were written (later runs may overwrite
+     * earlier ones)
+     */
+    struct tutorial_wb_run *runs;
+    size_t                  nruns;
+    size_t                  runs_cap;
+
+    /* The bytes of every run, one after another */
+    char * data;
+    size_t size;
+    size_t cap;
+
+    herr_t ret;
+};
+
+/* The objects with bytes in a file's write buffer */
+struct tutorial_write_buffer {
+    struct tutorial_wb_entry *head;
+    size_t                    nentries;
+    size_t                    nbytes;
+
+    /* When the oldest bytes were buffered */
+    struct timespec since;
+};
+
+static herr_t
+drain_part(size_t part, void *job_data)
+{
+    struct tutorial_wb_entry *entry = ((struct tutorial_wb_entry **)job_data)[part];
+
+    entry->ret = entry->cls->write(entry->obj, entry->runs, entry->nruns, entry->data);
+
+    return 0;
+}
+
+/* Whether a write of nbytes should go into f's write buffer (every write
+ * does, with a journal, however big: the buffer is drained as it fills)
+ */
+hbool_t
+write_buffer_takes(const struct tutorial_file *f, hsize_t nbytes)
+{
+    return f->journal || (f->write_buffer_size > 0 && nbytes < f->write_buffer_size);
+}
+
+/* Copies len bytes for file_off of obj's element array into its file's
+ * write buffer. cls says how to drain them.
+ */
+void
+buffer_write(struct tutorial_object *obj, hsize_t file_off, const void *mem, size_t len,
+             const struct tutorial_wb_class *cls)
+{
+    struct tutorial_file *    f     = obj->file;
+    struct tutorial_wb_entry *entry = obj->buffered;
+    struct tutorial_wb_run *  last  = NULL;
+
+    if (NULL == f->write_buffer) {
+        f->write_buffer = calloc(1, sizeof(struct tutorial_write_buffer));
+        clock_gettime(CLOCK_MONOTONIC, &(f->write_buffer->since));
+    }
+
+    if (NULL == entry) {
+        /* Another handle on the object may have bytes buffered already */
+        for (entry = f->write_buffer->head; entry; entry = entry->next)
+            if (strcmp(entry->obj->path, obj->path) == 0)
+                break;
+
+        if (NULL == entry) {
+            entry       = calloc(1, sizeof(struct tutorial_wb_entry));
+            entry->obj  = obj;
+            entry->cls  = cls;
+            entry->next = f->write_buffer->head;
+
+            f->write_buffer->head = entry;
+            f->write_buffer->nentries++;
+        }
+
+        if (entry->nhandles == entry->handles_cap) {
+            entry->handles_cap = entry->handles_cap ? 2 * entry->handles_cap : 4;
+            entry->handles = realloc(entry->handles, entry->handles_cap * sizeof(struct tutorial_object *));
+        }
+        entry->handles[entry->nhandles++] = obj;
+        obj->buffered                     = entry;
+    }
+
+    /* Bytes that carry on where the last run left off join it */
+    if (entry->nruns > 0)
+        last = &(entry->runs[entry->nruns - 1]);
+    if (last && last->file_off + last->len == file_off)
+        last->len += len;
+    else {
+        if (entry->nruns == entry->runs_cap) {
+            entry->runs_cap = entry->runs_cap ? 2 * entry->runs_cap : 16;
+            entry->runs     = realloc(entry->runs, entry->runs_cap * sizeof(struct tutorial_wb_run));
+        }
+        entry->runs[entry->nruns].file_off = file_off;
+        entry->runs[entry->nruns].len      = len;
+        entry->nruns++;
+    }
+
+    if (entry->size + len > entry->cap) {
+        entry->cap = 2 * entry->cap;
+        if (entry->cap < entry->size + len)
+            entry->cap = entry->size + len;
+        entry->data = realloc(entry->data, entry->cap);
+    }
+    memcpy(entry->data + entry->size, mem, len);
+    entry->size += len;
+
+    f->write_buffer->nbytes += len;
+}
+
+/* Drains f's write buffer if it has grown too big or been holding bytes
+ * too long
+ */
+herr_t
+check_write_buffer(struct tutorial_file *f)
+{
+    struct tutorial_write_buffer *wb = f->write_buffer;
+    struct timespec               now;
+
+    if (NULL == wb)
+        return 0;
+
+    if (wb->nbytes >= f->write_buffer_size)
+        return drain_write_buffer(f, NULL, false);
+
+    if (f->write_buffer_ms > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if ((now.tv_sec - wb->since.tv_sec) * 1000 + (now.tv_nsec - wb->since.tv_nsec) / 1000000 >=
+            f->write_buffer_ms)
+            return drain_write_buffer(f, NULL, false);
+    }
+
+    return 0;
+}
+
+/* Writes out the bytes buffered for the objects opened as path (all of
+ * them when path is NULL), in parallel, after committing them to the
+ * journal if there is one. Returns -1 if any of them failed, and with
+ * report set, if anything drained since the last report failed.
+ */
+herr_t
+drain_write_buffer(struct tutorial_file *f, const char *path, hbool_t report)
+{
+    struct tutorial_write_buffer *wb       = f->write_buffer;
+    struct tutorial_wb_entry **   entries  = NULL;
+    struct tutorial_wb_entry **   link     = NULL;
+    struct tutorial_wb_entry *    entry    = NULL;
+    size_t                        nentries = 0;
+    herr_t                        ret      = 0;
+
+    if (wb) {
+        /* Take the entries being drained out of the buffer */
+        entries = malloc(wb->nentries * sizeof(struct tutorial_wb_entry *));
+        for (link = &(wb->head); NULL != (entry = *link);)
+            if (NULL == path || strcmp(entry->obj->path, path) == 0) {
+                *link               = entry->next;
+                entries[nentries++] = entry;
+            }
+            else
+                link = &(entry->next);
+
+        /* The journal gets all of them in one transaction, so it's synced
+         * once however many writes there are. Bytes that aren't safely in
+         * the journal are never written, and are dropped.
+         */
+        if (f->journal && nentries > 0) {
+            for (size_t i = 0; i < nentries && ret >= 0; i++)
+                if (entries[i]->cls->log(entries[i]->obj, entries[i]->runs, entries[i]->nruns,
+                                         entries[i]->data) < 0)
+                    ret = -1;
+            if (ret < 0)
+                abort_journal(f);
+            else if (commit_journal(f) < 0)
+                ret = -1;
+        }
+
+        /* Each object's bytes go to its own data file */
+        if (ret >= 0 && 1 == nentries)
+            drain_part(0, entries);
+        else if (ret >= 0 && nentries > 1)
+            run_parallel(f, nentries, drain_part, entries);
+
+        for (size_t i = 0; i < nentries; i++) {
+            entry = entries[i];
+
+            if (entry->ret < 0)
+                ret = -1;
+
+            for (size_t h = 0; h < entry->nhandles; h++)
+                entry->handles[h]->buffered = NULL;
+            wb->nbytes -= entry->size;
+            wb->nentries--;
+
+            free(entry->handles);
+            free(entry->runs);
+            free(entry->data);
+            free(entry);
+        }
+
+        free(entries);
+
+        /* A journal that has grown too big is emptied once everything in
+         * it has been written
+         */
+        if (ret >= 0 && checkpoint_journal(f, false) < 0)
+            ret = -1;
+        if (ret < 0)
+            f->write_buffer_failed = true;
+
+        /* An empty buffer starts timing again with the next bytes */
+        if (0 == wb->nentries) {
+            free(wb);
+            f->write_buffer = NULL;
+        }
+    }
+
+    if (report && f->write_buffer_failed) {
+        f->write_buffer_failed = false;
+        ret                    = -1;
+    }
+
+    return ret;
+}
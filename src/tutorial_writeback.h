@@ -0,0 +1,44 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Purpose:     Write-back buffering for a simple tutorial virtual object
+ *              layer (VOL) connector
+ */
+
+#ifndef TUTORIAL_WRITEBACK_H
+#define TUTORIAL_WRITEBACK_H
+
+#include <hdf5.h>
+
+#include "tutorial_internal.h"
+
+/* A run of buffered bytes, for file_off of a dataset's element array */
+struct tutorial_wb_run {
+    hsize_t file_off;
+    size_t  len;
+};
+
+/* Writes an object's buffered runs, whose bytes are in data one after
+ * another
+ */
+typedef herr_t (*tutorial_wb_write_t)(struct tutorial_object *obj, const struct tutorial_wb_run *runs,
+                                      size_t nruns, const char *data);
+
+/* How an object's buffered runs are drained */
+struct tutorial_wb_class {
+    /* Adds them to the file's journal (files with a journal only) */
+    tutorial_wb_write_t log;
+
+    /* Writes them */
+    tutorial_wb_write_t write;
+};
+
+hbool_t write_buffer_takes(const struct tutorial_file *f, hsize_t nbytes);
+void    buffer_write(struct tutorial_object *obj, hsize_t file_off, const void *mem, size_t len,
+                     const struct tutorial_wb_class *cls);
+herr_t  check_write_buffer(struct tutorial_file *f);
+herr_t  drain_write_buffer(struct tutorial_file *f, const char *path, hbool_t report);
+
+#endif /* TUTORIAL_WRITEBACK_H */
@@ -12,6 +12,9 @@
 
 #include <hdf5.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include "tutorial_vol_connector.h"
 
@@ -324,6 +327,108 @@ error:
 
 } /* end test_file_ops() */
 
+/*-------------------------------------------------------------------------
+ * Function:    test_file_close_early()
+ *
+ * Purpose:     Tests closing a file while a group, a dataset and an
+ *              attribute in it are still open, then using and closing
+ *              them
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define CLOSE_EARLY_DIM 100
+static herr_t
+test_file_close_early(hid_t fapl_id)
+{
+    const char *filename = "file_close_early.h5tut";
+    hid_t       fid      = H5I_INVALID_HID;
+    hid_t       gid      = H5I_INVALID_HID;
+    hid_t       did      = H5I_INVALID_HID;
+    hid_t       aid      = H5I_INVALID_HID;
+    hid_t       sid      = H5I_INVALID_HID;
+    hsize_t     dims[1]  = {CLOSE_EARLY_DIM};
+    int         buf[CLOSE_EARLY_DIM];
+    int         out[CLOSE_EARLY_DIM];
+
+    TESTING("VOL objects open after the file is closed");
+
+    for (int i = 0; i < CLOSE_EARLY_DIM; i++)
+        buf[i] = i;
+
+    /* Create an HDF5 file with a group, a dataset and an attribute */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((gid = H5Gcreate2(fid, "group", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(gid, "dset", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((aid = H5Acreate2(gid, "attr", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+
+    /* Close the file first, then use what's still open */
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    fid = H5I_INVALID_HID;
+
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+        TEST_ERROR;
+    if (H5Awrite(aid, H5T_NATIVE_INT, buf) < 0)
+        TEST_ERROR;
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+    if (H5Aclose(aid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and check the data */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "/group/dset", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    if (memcmp(buf, out, sizeof(buf)) != 0) {
+        printf("WRONG DATA AFTER REOPEN\n");
+        TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Aclose(aid);
+        H5Dclose(did);
+        H5Gclose(gid);
+        H5Sclose(sid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_file_close_early() */
+
 static herr_t
 test_group_ops(hid_t fapl_id)
 {
@@ -528,6 +633,3288 @@ error:
 
 } /* end test_dataset_ops() */
 
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_selections()
+ *
+ * Purpose:     Tests dataset I/O with hyperslab and point selections
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_dataset_selections(hid_t fapl_id)
+{
+    const char *filename    = "dataset_selections.h5tut";
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       fsid        = H5I_INVALID_HID;
+    hid_t       msid        = H5I_INVALID_HID;
+    hsize_t     dims[1]     = {20};
+    hsize_t     start[1]    = {1};
+    hsize_t     stride[1]   = {3};
+    hsize_t     count[1]    = {6};
+    hsize_t     mdims[1]    = {6};
+    hsize_t     points[3]   = {19, 0, 7};
+    hsize_t     mcount[1]   = {3};
+    int         in_data[20];
+    int         out_data[20];
+
+    TESTING("VOL dataset selections");
+
+    for (int i = 0; i < 20; i++)
+        in_data[i] = i * 10;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Create and fill a 1D dataset */
+    if ((fsid = H5Screate_simple(1, dims, dims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+
+    /* Read a strided hyperslab into a compact buffer */
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, stride, count, NULL) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, mdims, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 6; i++)
+        if (out_data[i] != in_data[1 + 3 * i]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Read a point selection, which keeps the order the points were given in */
+    if (H5Sselect_elements(fsid, H5S_SELECT_SET, 3, points) < 0)
+        TEST_ERROR;
+    if (H5Sselect_hyperslab(msid, H5S_SELECT_SET, start, NULL, mcount, NULL) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    if (out_data[1] != in_data[19] || out_data[2] != in_data[0] || out_data[3] != in_data[7]) {
+        printf("BAD DATA VALUE\n");
+        TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_selections() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_2d()
+ *
+ * Purpose:     Tests I/O on a 2D dataset, including a tile read
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define DSET_2D_ROWS 50
+#define DSET_2D_COLS 40
+static herr_t
+test_dataset_2d(hid_t fapl_id)
+{
+    const char *filename = "dataset_2d.h5tut";
+    hid_t       fid      = H5I_INVALID_HID;
+    hid_t       did      = H5I_INVALID_HID;
+    hid_t       fsid     = H5I_INVALID_HID;
+    hid_t       msid     = H5I_INVALID_HID;
+    hsize_t     dims[2]  = {DSET_2D_ROWS, DSET_2D_COLS};
+    hsize_t     start[2] = {3, 5};
+    hsize_t     count[2] = {10, 7};
+    int *       in_data  = NULL;
+    int         out_data[10 * 7];
+
+    TESTING("VOL 2D dataset operations");
+
+    if (NULL == (in_data = malloc(DSET_2D_ROWS * DSET_2D_COLS * sizeof(int))))
+        TEST_ERROR;
+    for (int i = 0; i < DSET_2D_ROWS * DSET_2D_COLS; i++)
+        in_data[i] = i;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Create and fill a 2D dataset */
+    if ((fsid = H5Screate_simple(2, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset_2d", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+
+    /* Read a tile */
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(2, count, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 10; i++)
+        for (int j = 0; j < 7; j++)
+            if (out_data[i * 7 + j] != in_data[(3 + i) * DSET_2D_COLS + 5 + j]) {
+                printf("BAD DATA VALUE\n");
+                TEST_ERROR;
+            }
+
+    /* Close everything */
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    free(in_data);
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    free(in_data);
+    return FAIL;
+
+} /* end test_dataset_2d() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_chunked()
+ *
+ * Purpose:     Tests I/O on a chunked dataset, where chunks that were
+ *              never written read back as the fill value
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_dataset_chunked(hid_t fapl_id)
+{
+    const char *filename      = "dataset_chunked.h5tut";
+    hid_t       fid           = H5I_INVALID_HID;
+    hid_t       did           = H5I_INVALID_HID;
+    hid_t       fsid          = H5I_INVALID_HID;
+    hid_t       msid          = H5I_INVALID_HID;
+    hid_t       dcpl_id       = H5I_INVALID_HID;
+    int         fill_value    = -1;
+    hsize_t     dims[1]       = {100};
+    hsize_t     chunk_dims[1] = {10};
+    hsize_t     start[1]      = {35};
+    hsize_t     count[1]      = {10};
+    int         in_data[10]   = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int         out_data[100];
+
+    TESTING("VOL chunked dataset operations");
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Create a chunked dataset with a fill value */
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        TEST_ERROR;
+    if (H5Pset_chunk(dcpl_id, 1, chunk_dims) < 0)
+        TEST_ERROR;
+    if (H5Pset_fill_value(dcpl_id, H5T_NATIVE_INT, &fill_value) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(1, dims, dims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset_chunked", H5T_NATIVE_INT, fsid, H5P_DEFAULT, dcpl_id, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+
+    /* Write a block that straddles two chunks */
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, count, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+
+    /* Read everything back */
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 100; i++) {
+        int expected = (i >= 35 && i < 45) ? in_data[i - 35] : fill_value;
+
+        if (out_data[i] != expected) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+    }
+
+    /* Close everything */
+    if (H5Pclose(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Pclose(dcpl_id);
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_chunked() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_allocation()
+ *
+ * Purpose:     Tests that a dataset's data file only holds its header until
+ *              it's written, unless it's allocated early, that the gap
+ *              before a sparse write reads back as the fill value, and that
+ *              a dataset that's never filled stays that way once reopened
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define ALLOC_N_ELMTS     1000
+#define ALLOC_HEADER_SIZE 16 /* The data file's header */
+static herr_t
+test_dataset_allocation(hid_t fapl_id)
+{
+    const char *filename    = "dataset_allocation.h5tut";
+    const char *names[3]    = {"lazy", "never", "early"};
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       fsid        = H5I_INVALID_HID;
+    hid_t       msid        = H5I_INVALID_HID;
+    hid_t       dcpl_ids[3] = {H5I_INVALID_HID, H5I_INVALID_HID, H5I_INVALID_HID};
+    hsize_t     dims[1]     = {ALLOC_N_ELMTS};
+    hsize_t     start[1]    = {ALLOC_N_ELMTS - 1};
+    hsize_t     count[1]    = {1};
+    int         fill        = 7;
+    int         last        = 42;
+    struct stat st;
+    char        path[64];
+    int         out[ALLOC_N_ELMTS];
+
+    TESTING("VOL dataset allocation and fill values");
+
+    /* One dataset is allocated lazily, one is never filled and one is
+     * allocated (and filled) early
+     */
+    for (int i = 0; i < 3; i++) {
+        if ((dcpl_ids[i] = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+            TEST_ERROR;
+        if (H5Pset_fill_value(dcpl_ids[i], H5T_NATIVE_INT, &fill) < 0)
+            TEST_ERROR;
+    }
+    if (H5Pset_fill_time(dcpl_ids[1], H5D_FILL_TIME_NEVER) < 0)
+        TEST_ERROR;
+    if (H5Pset_alloc_time(dcpl_ids[2], H5D_ALLOC_TIME_EARLY) < 0)
+        TEST_ERROR;
+
+    /* Create an HDF5 file and the datasets */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < 3; i++) {
+        if ((did = H5Dcreate2(fid, names[i], H5T_NATIVE_INT, fsid, H5P_DEFAULT, dcpl_ids[i],
+                              H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Only the early dataset's data file holds its elements */
+    for (int i = 0; i < 3; i++) {
+        off_t size = ALLOC_HEADER_SIZE + (2 == i ? ALLOC_N_ELMTS * (off_t)sizeof(int) : 0);
+
+        snprintf(path, sizeof(path), "%s/%s/%s.data", filename, names[i], names[i]);
+        if (stat(path, &st) < 0 || st.st_size != size) {
+            printf("WRONG DATA FILE SIZE\n");
+            TEST_ERROR;
+        }
+    }
+
+    /* Reopen the file and write each dataset's last element */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDWR, fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, count, NULL)) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < 3; i++) {
+        if ((did = H5Dopen2(fid, names[i], H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, &last) < 0)
+            TEST_ERROR;
+
+        /* The elements before it are the fill value, except in the dataset
+         * that's never filled, where they're whatever the file held
+         */
+        if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+            TEST_ERROR;
+        for (int j = 0; j < ALLOC_N_ELMTS - 1; j++)
+            if (out[j] != (1 == i ? 0 : fill)) {
+                printf("BAD FILL VALUE\n");
+                TEST_ERROR;
+            }
+        if (out[ALLOC_N_ELMTS - 1] != last) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+
+    /* Close everything */
+    for (int i = 0; i < 3; i++)
+        if (H5Pclose(dcpl_ids[i]) < 0)
+            TEST_ERROR;
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        for (int i = 0; i < 3; i++)
+            H5Pclose(dcpl_ids[i]);
+        H5Sclose(msid);
+        H5Sclose(fsid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_allocation() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_types()
+ *
+ * Purpose:     Tests a double-precision dataset written and read through
+ *              other memory types
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_dataset_types(hid_t fapl_id)
+{
+    const char *filename = "dataset_types.h5tut";
+    hid_t       fid      = H5I_INVALID_HID;
+    hid_t       did      = H5I_INVALID_HID;
+    hid_t       sid      = H5I_INVALID_HID;
+    hsize_t     dims[1]  = {10};
+    float       in_data[10];
+    double      out_data[10];
+    int         int_data[10];
+
+    TESTING("VOL dataset type conversion");
+
+    for (int i = 0; i < 10; i++)
+        in_data[i] = (float)i + 0.5f;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Create a double dataset and write floats to it */
+    if ((sid = H5Screate_simple(1, dims, dims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset_double", H5T_NATIVE_DOUBLE, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) <
+        0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+
+    /* Read it back as doubles and as (truncated) ints */
+    if ((did = H5Dopen2(fid, "dset_double", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, int_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 10; i++)
+        if (out_data[i] != (double)in_data[i] || int_data[i] != i) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_types() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_text()
+ *
+ * Purpose:     Tests a dataset stored in the one-element-per-line text
+ *              format
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_dataset_text(hid_t fapl_id)
+{
+    const char *filename = "dataset_text.h5tut";
+    hid_t       fid      = H5I_INVALID_HID;
+    hid_t       did      = H5I_INVALID_HID;
+    hid_t       sid      = H5I_INVALID_HID;
+    hid_t       dcpl_id  = H5I_INVALID_HID;
+    FILE *      data     = NULL;
+    int         format   = TUTORIAL_VOL_DATA_FORMAT_TEXT;
+    hsize_t     dims[1]  = {1000};
+    int         in_data[1000];
+    int         out_data[1000];
+    int         value    = 0;
+
+    TESTING("VOL text dataset operations");
+
+    for (int i = 0; i < 1000; i++)
+        in_data[i] = (i % 2 ? -1 : 1) * i * 12345;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Ask for a text data file */
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dcpl_id, TUTORIAL_VOL_DATA_FORMAT_PROP, sizeof(int), &format, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, dims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset_text", H5T_NATIVE_INT, sid, H5P_DEFAULT, dcpl_id, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+
+    /* Read it back */
+    if ((did = H5Dopen2(fid, "dset_text", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 1000; i++)
+        if (out_data[i] != in_data[i]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* The data file is plain decimal text */
+    if (NULL == (data = fopen("dataset_text.h5tut/dset_text/dset_text.data", "r")))
+        TEST_ERROR;
+    for (int i = 0; i < 1000; i++)
+        if (fscanf(data, "%d\n", &value) != 1 || value != in_data[i]) {
+            printf("BAD TEXT VALUE\n");
+            TEST_ERROR;
+        }
+    fclose(data);
+    data = NULL;
+
+    /* Close everything */
+    if (H5Pclose(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    if (data)
+        fclose(data);
+    H5E_BEGIN_TRY
+    {
+        H5Pclose(dcpl_id);
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_text() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_reopen()
+ *
+ * Purpose:     Tests opening and closing the same datasets and groups
+ *              repeatedly, including after a dataset's extent changes
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define REOPEN_N_DSETS 50
+static herr_t
+test_dataset_reopen(hid_t fapl_id)
+{
+    const char *filename    = "dataset_reopen.h5tut";
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       gid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       sid         = H5I_INVALID_HID;
+    hsize_t     dims[1]     = {10};
+    hsize_t     new_dims[1] = {20};
+    char        name[32];
+    int         in_data[20];
+    int         out_data[20];
+
+    TESTING("VOL dataset reopening");
+
+    for (int i = 0; i < 20; i++)
+        in_data[i] = i * 11;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Create a group full of small datasets */
+    if ((gid = H5Gcreate2(fid, "group", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < REOPEN_N_DSETS; i++) {
+        snprintf(name, sizeof(name), "dset_%d", i);
+        if ((did = H5Dcreate2(gid, name, H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+
+    /* Open everything a few times over */
+    for (int pass = 0; pass < 3; pass++) {
+        if ((gid = H5Gopen2(fid, "group", H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+
+        for (int i = 0; i < REOPEN_N_DSETS; i++) {
+            snprintf(name, sizeof(name), "dset_%d", i);
+            if ((did = H5Dopen2(gid, name, H5P_DEFAULT)) < 0)
+                TEST_ERROR;
+            if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+                TEST_ERROR;
+            if (H5Dclose(did) < 0)
+                TEST_ERROR;
+
+            for (int j = 0; j < 10; j++)
+                if (out_data[j] != in_data[j]) {
+                    printf("BAD DATA VALUE\n");
+                    TEST_ERROR;
+                }
+        }
+
+        if (H5Gclose(gid) < 0)
+            TEST_ERROR;
+    }
+
+    /* Grow one of them, and make sure the next open sees the new extent */
+    if ((did = H5Dopen2(fid, "group/dset_0", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, new_dims, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, sid, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 20; i++)
+        out_data[i] = -1;
+    if ((did = H5Dopen2(fid, "group/dset_0", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 20; i++)
+        if (out_data[i] != in_data[i]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Gclose(gid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_reopen() */
+
+/*-------------------------------------------------------------------------
+ * Function:    write_text_file()
+ *
+ * Purpose:     Creates a small text file (for faking older datasets)
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+write_text_file(const char *path, const char *text)
+{
+    FILE *f = NULL;
+
+    if (NULL == (f = fopen(path, "w")))
+        return FAIL;
+    fputs(text, f);
+    fclose(f);
+
+    return SUCCEED;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_metadata()
+ *
+ * Purpose:     Tests that new datasets keep their metadata in one record
+ *              and that datasets with the older separate metadata files
+ *              can still be opened and resized
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_dataset_metadata(hid_t fapl_id)
+{
+    const char *filename    = "dataset_metadata.h5tut";
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       sid         = H5I_INVALID_HID;
+    FILE *      meta        = NULL;
+    hsize_t     dims[1]     = {5};
+    hsize_t     new_dims[1] = {8};
+    int         in_data[8]  = {8, 7, 6, 5, 4, 3, 2, 1};
+    int         out_data[8];
+
+    TESTING("VOL dataset metadata");
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* A new dataset only has a metadata record next to its data file */
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (NULL == (meta = fopen("dataset_metadata.h5tut/dset/dset.meta", "r")))
+        TEST_ERROR;
+    fclose(meta);
+    if (NULL != (meta = fopen("dataset_metadata.h5tut/dset/dset.dataspace", "r"))) {
+        fclose(meta);
+        TEST_ERROR;
+    }
+
+    /* Fake a dataset written by an older version of the connector */
+    if (mkdir("dataset_metadata.h5tut/old_dset", 0700) < 0)
+        TEST_ERROR;
+    if (write_text_file("dataset_metadata.h5tut/old_dset/old_dset.dataspace", "5\n") < 0 ||
+        write_text_file("dataset_metadata.h5tut/old_dset/old_dset.datatype", "TUTORIAL_DATA_TYPE_INT\n") < 0 ||
+        write_text_file("dataset_metadata.h5tut/old_dset/old_dset.fillval", "0\n") < 0 ||
+        write_text_file("dataset_metadata.h5tut/old_dset/old_dset.data", "1\n2\n3\n4\n5\n") < 0)
+        TEST_ERROR;
+
+    /* Read it, then grow it */
+    if ((did = H5Dopen2(fid, "old_dset", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 5; i++)
+        if (out_data[i] != i + 1) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    if ((sid = H5Screate_simple(1, new_dims, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, sid, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* The new extent is in the old dataspace file */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDWR, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "old_dset", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int i = 0; i < 8; i++)
+        if (out_data[i] != in_data[i]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_metadata() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_nested_groups()
+ *
+ * Purpose:     Tests creating groups and datasets several levels deep and
+ *              opening them by multi-component names
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define NESTED_DEPTH 4
+static herr_t
+test_nested_groups(hid_t fapl_id)
+{
+    const char *filename               = "nested_groups.h5tut";
+    hid_t       fid                    = H5I_INVALID_HID;
+    hid_t       gids[NESTED_DEPTH + 1] = {H5I_INVALID_HID};
+    hid_t       did                    = H5I_INVALID_HID;
+    hid_t       sid                    = H5I_INVALID_HID;
+    hid_t       dcpl_id                = H5I_INVALID_HID;
+    hsize_t     dims[1]                = {10};
+    hsize_t     chunk_dims[1]          = {4};
+    char        name[NESTED_DEPTH * 8];
+    char        dset_name[8 + NESTED_DEPTH * 8];
+    int         in_data[10];
+    int         out_data[10];
+
+    TESTING("VOL nested groups");
+
+    for (int i = 0; i < 10; i++)
+        in_data[i] = i * i;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        TEST_ERROR;
+    if (H5Pset_chunk(dcpl_id, 1, chunk_dims) < 0)
+        TEST_ERROR;
+
+    /* Create a chain of groups, each holding a dataset */
+    gids[0] = fid;
+    for (int i = 1; i <= NESTED_DEPTH; i++) {
+        if ((gids[i] = H5Gcreate2(gids[i - 1], "level", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if ((did = H5Dcreate2(gids[i], "dset", H5T_NATIVE_INT, sid, H5P_DEFAULT, i % 2 ? dcpl_id : H5P_DEFAULT,
+                              H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+    for (int i = NESTED_DEPTH; i > 0; i--) {
+        if (H5Gclose(gids[i]) < 0)
+            TEST_ERROR;
+        gids[i] = H5I_INVALID_HID;
+    }
+
+    /* Open each dataset from the file by its full name */
+    for (int i = 1, len = 0; i <= NESTED_DEPTH; i++) {
+        len += sprintf(name + len, "%slevel", i > 1 ? "/" : "");
+        snprintf(dset_name, sizeof(dset_name), "%s/dset", name);
+
+        if ((did = H5Dopen2(fid, dset_name, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+
+        for (int j = 0; j < 10; j++)
+            if (out_data[j] != in_data[j]) {
+                printf("BAD DATA VALUE\n");
+                TEST_ERROR;
+            }
+    }
+
+    /* Open the deepest group by its full name, and its dataset from there */
+    if ((gids[1] = H5Gopen2(fid, name, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(gids[1], "dset", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (int j = 0; j < 10; j++)
+        if (out_data[j] != in_data[j]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Gclose(gids[1]) < 0)
+        TEST_ERROR;
+    if (H5Pclose(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Dclose(did);
+        for (int i = NESTED_DEPTH; i > 0; i--)
+            H5Gclose(gids[i]);
+        H5Pclose(dcpl_id);
+        H5Sclose(sid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_nested_groups() */
+
+/*-------------------------------------------------------------------------
+ * Function:    collect_link()
+ *
+ * Purpose:     Link iteration callback that records each name, stopping
+ *              after a given number of links if asked to
+ *
+ * Return:      0 to continue, 1 to stop
+ *
+ *-------------------------------------------------------------------------
+ */
+#define LINKS_N_MEMBERS 20
+struct link_names {
+    int  nnames;
+    int  stop_after;
+    char names[LINKS_N_MEMBERS + 3][32];
+};
+
+static herr_t
+collect_link(hid_t group_id, const char *name, const H5L_info2_t *info, void *op_data)
+{
+    struct link_names *links = (struct link_names *)op_data;
+
+    (void)group_id;
+
+    if (H5L_TYPE_HARD != info->type || links->nnames >= LINKS_N_MEMBERS + 3)
+        return -1;
+
+    snprintf(links->names[links->nnames++], sizeof(links->names[0]), "%s", name);
+
+    return links->nnames == links->stop_after ? 1 : 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    test_group_links()
+ *
+ * Purpose:     Tests group info, link existence checks, iteration, visiting
+ *              and deletion, and that they see members created and deleted
+ *              along the way
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_group_links(hid_t fapl_id)
+{
+    const char *      filename = "group_links.h5tut";
+    hid_t             fid      = H5I_INVALID_HID;
+    hid_t             gid      = H5I_INVALID_HID;
+    hid_t             sub_gid  = H5I_INVALID_HID;
+    hid_t             did      = H5I_INVALID_HID;
+    hid_t             sid      = H5I_INVALID_HID;
+    hsize_t           dims[1]  = {4};
+    hsize_t           idx      = 0;
+    herr_t            status   = FAIL;
+    H5G_info_t        ginfo;
+    struct link_names links;
+    char              name[16];
+
+    TESTING("VOL group links");
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+
+    /* Fill a group, out of order, with datasets and one subgroup */
+    if ((gid = H5Gcreate2(fid, "members", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    for (int i = LINKS_N_MEMBERS - 1; i >= 0; i--) {
+        snprintf(name, sizeof(name), "m_%02d", i);
+        if ((did = H5Dcreate2(gid, name, H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+    if ((sub_gid = H5Gcreate2(gid, "sub", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(sub_gid, "inner", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Gclose(sub_gid) < 0)
+        TEST_ERROR;
+
+    /* Count the members */
+    if (H5Gget_info(gid, &ginfo) < 0)
+        TEST_ERROR;
+    if (ginfo.nlinks != LINKS_N_MEMBERS + 1) {
+        printf("WRONG NUMBER OF LINKS\n");
+        TEST_ERROR;
+    }
+
+    /* Get a subgroup's info by name and by index (it sorts after the
+     * datasets). Datasets aren't groups, either way.
+     */
+    if (H5Gget_info_by_name(fid, "members/sub", &ginfo, H5P_DEFAULT) < 0 || ginfo.nlinks != 1)
+        TEST_ERROR;
+    if (H5Gget_info_by_idx(fid, "members", H5_INDEX_NAME, H5_ITER_INC, LINKS_N_MEMBERS, &ginfo,
+                           H5P_DEFAULT) < 0)
+        TEST_ERROR;
+    if (ginfo.nlinks != 1)
+        TEST_ERROR;
+    H5E_BEGIN_TRY
+    {
+        status = H5Gget_info_by_name(gid, "m_07", &ginfo, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    if (status >= 0) {
+        printf("DATASET INFO RETRIEVED AS A GROUP'S\n");
+        TEST_ERROR;
+    }
+    H5E_BEGIN_TRY
+    {
+        status = H5Gget_info_by_idx(fid, "members", H5_INDEX_NAME, H5_ITER_INC, 0, &ginfo, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    if (status >= 0) {
+        printf("DATASET INFO RETRIEVED AS A GROUP'S\n");
+        TEST_ERROR;
+    }
+
+    /* Check for links, by relative and absolute names */
+    if (H5Lexists(gid, "m_07", H5P_DEFAULT) <= 0 || H5Lexists(fid, "/members/sub/inner", H5P_DEFAULT) <= 0)
+        TEST_ERROR;
+    if (H5Lexists(gid, "m_99", H5P_DEFAULT) != 0 || H5Lexists(fid, "members/sub/outer", H5P_DEFAULT) != 0)
+        TEST_ERROR;
+
+    /* Iterate in name order, then backwards from the middle, stopping early */
+    memset(&links, 0, sizeof(links));
+    if (H5Literate2(gid, H5_INDEX_NAME, H5_ITER_INC, &idx, collect_link, &links) < 0)
+        TEST_ERROR;
+    if (links.nnames != LINKS_N_MEMBERS + 1 || idx != LINKS_N_MEMBERS + 1)
+        TEST_ERROR;
+    for (int i = 0; i < LINKS_N_MEMBERS; i++) {
+        snprintf(name, sizeof(name), "m_%02d", i);
+        if (strcmp(links.names[i], name) != 0) {
+            printf("LINKS OUT OF ORDER\n");
+            TEST_ERROR;
+        }
+    }
+
+    memset(&links, 0, sizeof(links));
+    links.stop_after = 2;
+    idx              = 10;
+    if (H5Literate2(gid, H5_INDEX_NAME, H5_ITER_DEC, &idx, collect_link, &links) != 1)
+        TEST_ERROR;
+    if (idx != 12 || strcmp(links.names[0], "m_10") != 0 || strcmp(links.names[1], "m_09") != 0)
+        TEST_ERROR;
+
+    /* Visit everything under the root group */
+    memset(&links, 0, sizeof(links));
+    if (H5Lvisit2(fid, H5_INDEX_NAME, H5_ITER_INC, collect_link, &links) < 0)
+        TEST_ERROR;
+    if (links.nnames != LINKS_N_MEMBERS + 3)
+        TEST_ERROR;
+    if (strcmp(links.names[LINKS_N_MEMBERS + 2], "members/sub/inner") != 0)
+        TEST_ERROR;
+
+    /* Look a name up by its index */
+    if (H5Lget_name_by_idx(fid, "members", H5_INDEX_NAME, H5_ITER_INC, 3, name, sizeof(name), H5P_DEFAULT) < 0)
+        TEST_ERROR;
+    if (strcmp(name, "m_03") != 0)
+        TEST_ERROR;
+
+    /* Delete a member and add another, and make sure both are noticed */
+    if (H5Ldelete(gid, "m_03", H5P_DEFAULT) < 0)
+        TEST_ERROR;
+    if (H5Lexists(gid, "m_03", H5P_DEFAULT) != 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(gid, "new", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Gget_info(gid, &ginfo) < 0)
+        TEST_ERROR;
+    if (ginfo.nlinks != LINKS_N_MEMBERS + 1 || H5Lexists(gid, "new", H5P_DEFAULT) <= 0) {
+        printf("STALE LINKS\n");
+        TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Gclose(sub_gid);
+        H5Gclose(gid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_group_links() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_group_index()
+ *
+ * Purpose:     Tests link queries on groups with a name index, including
+ *              after members are deleted, replaced by an object of the
+ *              other type, and created once the file is reopened without
+ *              the index property
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define INDEX_N_MEMBERS 100
+static herr_t
+test_group_index(hid_t fapl_id)
+{
+    const char *      filename = "group_index.h5tut";
+    hid_t             ifapl_id = H5I_INVALID_HID;
+    hid_t             fid      = H5I_INVALID_HID;
+    hid_t             gid      = H5I_INVALID_HID;
+    hid_t             sub_gid  = H5I_INVALID_HID;
+    hid_t             did      = H5I_INVALID_HID;
+    hid_t             sid      = H5I_INVALID_HID;
+    hsize_t           dims[1]  = {1};
+    int               one      = 1;
+    struct link_names links;
+    char              name[32];
+
+    TESTING("VOL group name index");
+
+    /* Create an HDF5 file whose groups get name indexes */
+    if ((ifapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(ifapl_id, TUTORIAL_VOL_GROUP_INDEX_PROP, sizeof(int), &one, NULL, NULL, NULL, NULL,
+                   NULL, NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, ifapl_id)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+
+    /* Enough members, with names too long to fit in the index's slots, that
+     * the index has to grow
+     */
+    if ((gid = H5Gcreate2(fid, "idx", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < INDEX_N_MEMBERS; i++) {
+        snprintf(name, sizeof(name), "member_%03d_of_many", i);
+        if ((did = H5Dcreate2(gid, name, H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+
+    /* Delete every other member, and replace the first with a group */
+    for (int i = 0; i < INDEX_N_MEMBERS; i += 2) {
+        snprintf(name, sizeof(name), "member_%03d_of_many", i);
+        if (H5Ldelete(gid, name, H5P_DEFAULT) < 0)
+            TEST_ERROR;
+    }
+    if ((sub_gid = H5Gcreate2(gid, "member_000_of_many", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Gclose(sub_gid) < 0)
+        TEST_ERROR;
+
+    for (int i = 1; i < INDEX_N_MEMBERS; i++) {
+        snprintf(name, sizeof(name), "member_%03d_of_many", i);
+        if (H5Lexists(gid, name, H5P_DEFAULT) != i % 2) {
+            printf("WRONG LINK EXISTENCE\n");
+            TEST_ERROR;
+        }
+    }
+
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file without the property, which still keeps the indexes
+     * that are there up to date
+     */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDWR, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "/idx/member_000_of_many/inner", H5T_NATIVE_INT, sid,
+                          H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Lexists(fid, "/idx/member_000_of_many/inner", H5P_DEFAULT) <= 0 ||
+        H5Lexists(fid, "/idx/member_002_of_many", H5P_DEFAULT) != 0)
+        TEST_ERROR;
+
+    /* Visiting only descends into the members that are groups */
+    memset(&links, 0, sizeof(links));
+    if (H5Lvisit2(fid, H5_INDEX_NAME, H5_ITER_INC, collect_link, &links) < 0)
+        TEST_ERROR;
+    if (links.nnames != LINKS_N_MEMBERS + 3)
+        TEST_ERROR;
+    if (strcmp(links.names[2], "idx/member_000_of_many/inner") != 0) {
+        printf("WRONG MEMBER TYPE\n");
+        TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(ifapl_id) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Gclose(sub_gid);
+        H5Gclose(gid);
+        H5Fclose(fid);
+        H5Pclose(ifapl_id);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_group_index() */
+
+#define ATTR_N_ELMTS 2000
+struct attr_names {
+    int  nnames;
+    char names[4][32];
+};
+
+static herr_t
+collect_attr(hid_t loc_id, const char *name, const H5A_info_t *info, void *op_data)
+{
+    struct attr_names *attrs = (struct attr_names *)op_data;
+
+    (void)loc_id;
+
+    if (!info->corder_valid || attrs->nnames >= 4)
+        return -1;
+
+    snprintf(attrs->names[attrs->nnames++], sizeof(attrs->names[0]), "%s", name);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    test_attributes()
+ *
+ * Purpose:     Tests string and numeric attributes on groups and datasets,
+ *              one too large to be kept in the attribute record, iteration
+ *              in name and creation order, renaming and deletion, and
+ *              reading them back once the file is reopened
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_attributes(hid_t fapl_id)
+{
+    const char *      filename = "attributes.h5tut";
+    hid_t             fid      = H5I_INVALID_HID;
+    hid_t             gid      = H5I_INVALID_HID;
+    hid_t             did      = H5I_INVALID_HID;
+    hid_t             aid      = H5I_INVALID_HID;
+    hid_t             sid      = H5I_INVALID_HID;
+    hid_t             scalar   = H5I_INVALID_HID;
+    hid_t             str_tid  = H5I_INVALID_HID;
+    hsize_t           dims[1]  = {ATTR_N_ELMTS};
+    hsize_t           idx      = 0;
+    double *          buf      = NULL;
+    int *             ibuf     = NULL;
+    char              units[8] = "metres";
+    char              str[8];
+    int               version = 3;
+    struct attr_names names;
+
+    TESTING("VOL attributes");
+
+    if (NULL == (buf = malloc(ATTR_N_ELMTS * sizeof(double))))
+        TEST_ERROR;
+    if (NULL == (ibuf = malloc(ATTR_N_ELMTS * sizeof(int))))
+        TEST_ERROR;
+    for (int i = 0; i < ATTR_N_ELMTS; i++)
+        buf[i] = i * 0.25;
+
+    /* Create an HDF5 file with a group and a dataset to hold attributes */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((gid = H5Gcreate2(fid, "group", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((scalar = H5Screate(H5S_SCALAR)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(gid, "dset", H5T_NATIVE_INT, scalar, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+
+    /* A fixed-length string on the dataset */
+    if ((str_tid = H5Tcopy(H5T_C_S1)) < 0)
+        TEST_ERROR;
+    if (H5Tset_size(str_tid, sizeof(units)) < 0)
+        TEST_ERROR;
+    if ((aid = H5Acreate2(did, "units", str_tid, scalar, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Awrite(aid, str_tid, units) < 0)
+        TEST_ERROR;
+    if (H5Aclose(aid) < 0)
+        TEST_ERROR;
+
+    /* A large array, stored big-endian, on the dataset */
+    if ((aid = H5Acreate2(did, "calibration", H5T_IEEE_F64BE, sid, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Awrite(aid, H5T_NATIVE_DOUBLE, buf) < 0)
+        TEST_ERROR;
+    if (H5Aclose(aid) < 0)
+        TEST_ERROR;
+
+    /* A scalar on the group, which can't be created twice */
+    if ((aid = H5Acreate2(gid, "version", H5T_STD_I32LE, scalar, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Awrite(aid, H5T_NATIVE_INT, &version) < 0)
+        TEST_ERROR;
+    if (H5Aclose(aid) < 0)
+        TEST_ERROR;
+    H5E_BEGIN_TRY
+    {
+        aid = H5Acreate2(gid, "version", H5T_STD_I32LE, scalar, H5P_DEFAULT, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    if (aid >= 0)
+        TEST_ERROR;
+
+    /* Iterate in name order and in creation order */
+    memset(&names, 0, sizeof(names));
+    if (H5Aiterate2(did, H5_INDEX_NAME, H5_ITER_INC, &idx, collect_attr, &names) < 0)
+        TEST_ERROR;
+    if (names.nnames != 2 || strcmp(names.names[0], "calibration") != 0 ||
+        strcmp(names.names[1], "units") != 0) {
+        printf("WRONG ATTRIBUTE NAME ORDER\n");
+        TEST_ERROR;
+    }
+    memset(&names, 0, sizeof(names));
+    idx = 0;
+    if (H5Aiterate2(did, H5_INDEX_CRT_ORDER, H5_ITER_INC, &idx, collect_attr, &names) < 0)
+        TEST_ERROR;
+    if (names.nnames != 2 || strcmp(names.names[0], "units") != 0) {
+        printf("WRONG ATTRIBUTE CREATION ORDER\n");
+        TEST_ERROR;
+    }
+
+    /* Rename one attribute and delete another */
+    if (H5Arename(did, "calibration", "gains") < 0)
+        TEST_ERROR;
+    if (H5Adelete(gid, "version") < 0)
+        TEST_ERROR;
+    if (H5Aexists(did, "calibration") != 0 || H5Aexists(did, "gains") <= 0 || H5Aexists(gid, "version") != 0)
+        TEST_ERROR;
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and read the attributes back, converting the large
+     * one to another type
+     */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((aid = H5Aopen_by_name(fid, "group/dset", "units", H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Aread(aid, str_tid, str) < 0)
+        TEST_ERROR;
+    if (strcmp(str, units) != 0) {
+        printf("WRONG STRING ATTRIBUTE\n");
+        TEST_ERROR;
+    }
+    if (H5Aclose(aid) < 0)
+        TEST_ERROR;
+
+    if ((aid = H5Aopen_by_name(fid, "group/dset", "gains", H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Aget_storage_size(aid) != ATTR_N_ELMTS * sizeof(double))
+        TEST_ERROR;
+    if (H5Aread(aid, H5T_NATIVE_INT, ibuf) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < ATTR_N_ELMTS; i++)
+        if (ibuf[i] != (int)buf[i]) {
+            printf("WRONG ARRAY ATTRIBUTE\n");
+            TEST_ERROR;
+        }
+    if (H5Aclose(aid) < 0)
+        TEST_ERROR;
+
+    /* Close everything */
+    if (H5Tclose(str_tid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(scalar) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    free(buf);
+    free(ibuf);
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Aclose(aid);
+        H5Tclose(str_tid);
+        H5Sclose(scalar);
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Gclose(gid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    free(buf);
+    free(ibuf);
+    return FAIL;
+
+} /* end test_attributes() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_batch_create()
+ *
+ * Purpose:     Tests creating and writing many small datasets in a file
+ *              that batches creation, including reading one back before
+ *              the batch is flushed, and that everything is there once the
+ *              file is reopened
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define BATCH_N_DSETS 500
+#define BATCH_N_ELMTS 16
+static herr_t
+test_batch_create(hid_t fapl_id)
+{
+    const char *filename = "batch_create.h5tut";
+    hid_t       bfapl_id = H5I_INVALID_HID;
+    hid_t       fid      = H5I_INVALID_HID;
+    hid_t       gid      = H5I_INVALID_HID;
+    hid_t       did      = H5I_INVALID_HID;
+    hid_t       sid      = H5I_INVALID_HID;
+    hsize_t     dims[1]  = {BATCH_N_ELMTS};
+    int         one      = 1;
+    int         buf[BATCH_N_ELMTS];
+    int         out[BATCH_N_ELMTS];
+    char        name[32];
+
+    TESTING("VOL batched dataset creation");
+
+    /* Create an HDF5 file that batches creation */
+    if ((bfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(bfapl_id, TUTORIAL_VOL_BATCH_CREATE_PROP, sizeof(int), &one, NULL, NULL, NULL, NULL,
+                   NULL, NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, bfapl_id)) < 0)
+        TEST_ERROR;
+    if ((gid = H5Gcreate2(fid, "group", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+
+    /* Create, write and close many small datasets, which are all held back */
+    for (int i = 0; i < BATCH_N_DSETS; i++) {
+        snprintf(name, sizeof(name), "dset_%d", i);
+        for (int j = 0; j < BATCH_N_ELMTS; j++)
+            buf[j] = i * BATCH_N_ELMTS + j;
+
+        if ((did = H5Dcreate2(gid, name, H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+            TEST_ERROR;
+
+        /* Reading one back makes the batch run */
+        if (BATCH_N_DSETS / 2 == i) {
+            if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+                TEST_ERROR;
+            if (memcmp(buf, out, sizeof(buf)) != 0) {
+                printf("WRONG DATA BEFORE FLUSH\n");
+                TEST_ERROR;
+            }
+        }
+
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+
+    if (H5Fflush(fid, H5F_SCOPE_GLOBAL) < 0)
+        TEST_ERROR;
+    if (H5Lexists(gid, "dset_0", H5P_DEFAULT) <= 0)
+        TEST_ERROR;
+
+    /* Close everything */
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and check every dataset */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id)) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < BATCH_N_DSETS; i++) {
+        snprintf(name, sizeof(name), "/group/dset_%d", i);
+
+        if ((did = H5Dopen2(fid, name, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+            TEST_ERROR;
+        for (int j = 0; j < BATCH_N_ELMTS; j++)
+            if (out[j] != i * BATCH_N_ELMTS + j) {
+                printf("WRONG DATA AFTER REOPEN\n");
+                TEST_ERROR;
+            }
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(bfapl_id) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Gclose(gid);
+        H5Fclose(fid);
+        H5Pclose(bfapl_id);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_batch_create() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_filters()
+ *
+ * Purpose:     Tests a chunked dataset compressed with the shuffle and
+ *              deflate filters, read back in part, whole and after the
+ *              file is reopened, and that filters without chunks are
+ *              refused
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define FILTERS_DIM 100
+static herr_t
+test_dataset_filters(hid_t fapl_id)
+{
+    const char *filename      = "dataset_filters.h5tut";
+    hid_t       fid           = H5I_INVALID_HID;
+    hid_t       did           = H5I_INVALID_HID;
+    hid_t       fsid          = H5I_INVALID_HID;
+    hid_t       msid          = H5I_INVALID_HID;
+    hid_t       dcpl_id       = H5I_INVALID_HID;
+    hsize_t     dims[2]       = {FILTERS_DIM, FILTERS_DIM};
+    hsize_t     chunk_dims[2] = {25, 25};
+    hsize_t     start[2]      = {30, 60};
+    hsize_t     count[2]      = {10, 10};
+    int         part[10][10];
+    int *       buf           = NULL;
+    int *       out           = NULL;
+
+    TESTING("VOL filtered dataset operations");
+
+    if (NULL == (buf = malloc(FILTERS_DIM * FILTERS_DIM * sizeof(int))))
+        TEST_ERROR;
+    if (NULL == (out = malloc(FILTERS_DIM * FILTERS_DIM * sizeof(int))))
+        TEST_ERROR;
+
+    /* Slowly changing values, like a sensor's, compress well */
+    for (int i = 0; i < FILTERS_DIM * FILTERS_DIM; i++)
+        buf[i] = 1000 + i / 7;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(2, dims, NULL)) < 0)
+        TEST_ERROR;
+
+    /* Filters need chunks */
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        TEST_ERROR;
+    if (H5Pset_shuffle(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Pset_deflate(dcpl_id, 6) < 0)
+        TEST_ERROR;
+    H5E_BEGIN_TRY
+    {
+        did = H5Dcreate2(fid, "dset_contig", H5T_NATIVE_INT, fsid, H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+    }
+    H5E_END_TRY;
+    if (did >= 0) {
+        printf("FILTERED CONTIGUOUS DATASET CREATED\n");
+        TEST_ERROR;
+    }
+
+    /* Create a compressed chunked dataset and write all of it */
+    if (H5Pset_chunk(dcpl_id, 2, chunk_dims) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset_filtered", H5T_NATIVE_INT, fsid, H5P_DEFAULT, dcpl_id, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+        TEST_ERROR;
+
+    /* Read back a block that straddles four chunks */
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(2, count, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, part) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < 10; i++)
+        for (int j = 0; j < 10; j++)
+            if (part[i][j] != buf[(30 + i) * FILTERS_DIM + 60 + j]) {
+                printf("WRONG PARTIAL DATA\n");
+                TEST_ERROR;
+            }
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and read the whole dataset */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "dset_filtered", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    if (memcmp(buf, out, FILTERS_DIM * FILTERS_DIM * sizeof(int)) != 0) {
+        printf("WRONG DATA AFTER REOPEN\n");
+        TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Pclose(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    free(buf);
+    free(out);
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Pclose(dcpl_id);
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    free(buf);
+    free(out);
+    return FAIL;
+
+} /* end test_dataset_filters() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_extend()
+ *
+ * Purpose:     Tests appending to a dataset with unlimited maximum dims by
+ *              extending it and writing only the new elements, and that
+ *              datasets can't grow past their maximum dims
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define EXTEND_N_APPENDS 10
+#define EXTEND_N_ELMTS   100
+static herr_t
+test_dataset_extend(hid_t fapl_id)
+{
+    const char *filename      = "dataset_extend.h5tut";
+    hid_t       fid           = H5I_INVALID_HID;
+    hid_t       did           = H5I_INVALID_HID;
+    hid_t       fsid          = H5I_INVALID_HID;
+    hid_t       msid          = H5I_INVALID_HID;
+    hid_t       dcpl_id       = H5I_INVALID_HID;
+    hsize_t     dims[1]       = {0};
+    hsize_t     maxdims[1]    = {H5S_UNLIMITED};
+    hsize_t     chunk_dims[1] = {64};
+    hsize_t     start[1]      = {0};
+    hsize_t     count[1]      = {EXTEND_N_ELMTS};
+    herr_t      status        = 0;
+    int         buf[EXTEND_N_ELMTS];
+    int         out[EXTEND_N_APPENDS * EXTEND_N_ELMTS];
+
+    TESTING("VOL dataset extension");
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Create an empty dataset that can grow without limit */
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        TEST_ERROR;
+    if (H5Pset_chunk(dcpl_id, 1, chunk_dims) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(1, dims, maxdims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset_extend", H5T_NATIVE_INT, fsid, H5P_DEFAULT, dcpl_id, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, count, NULL)) < 0)
+        TEST_ERROR;
+
+    /* Append to it, writing only the new elements each time */
+    for (int i = 0; i < EXTEND_N_APPENDS; i++) {
+        for (int j = 0; j < EXTEND_N_ELMTS; j++)
+            buf[j] = i * EXTEND_N_ELMTS + j;
+
+        start[0] = dims[0];
+        dims[0] += EXTEND_N_ELMTS;
+        if (H5Dset_extent(did, dims) < 0)
+            TEST_ERROR;
+        if ((fsid = H5Dget_space(did)) < 0)
+            TEST_ERROR;
+        if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, buf) < 0)
+            TEST_ERROR;
+        if (H5Sclose(fsid) < 0)
+            TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and check the extent and the elements */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDWR, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "dset_extend", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Dget_space(did)) < 0)
+        TEST_ERROR;
+    if (H5Sget_simple_extent_dims(fsid, dims, maxdims) < 0)
+        TEST_ERROR;
+    if (dims[0] != EXTEND_N_APPENDS * EXTEND_N_ELMTS || maxdims[0] != H5S_UNLIMITED) {
+        printf("WRONG EXTENT\n");
+        TEST_ERROR;
+    }
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < EXTEND_N_APPENDS * EXTEND_N_ELMTS; i++)
+        if (out[i] != i) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+
+    /* A dataset with fixed maximum dims can't grow past them */
+    dims[0] = maxdims[0] = EXTEND_N_ELMTS;
+    if ((fsid = H5Screate_simple(1, dims, maxdims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "fixed", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    dims[0]++;
+    H5E_BEGIN_TRY
+    {
+        status = H5Dset_extent(did, dims);
+    }
+    H5E_END_TRY;
+    if (status >= 0) {
+        printf("EXTENDED PAST MAXIMUM DIMS\n");
+        TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Pclose(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Pclose(dcpl_id);
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_extend() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_mmap()
+ *
+ * Purpose:     Tests writing, reading, growing and shrinking a dataset
+ *              that's memory-mapped through its access property list, and
+ *              reading it back through a file that maps all its datasets
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define MMAP_ROWS 20
+#define MMAP_COLS 8
+static herr_t
+test_dataset_mmap(hid_t fapl_id)
+{
+    const char *filename   = "dataset_mmap.h5tut";
+    hid_t       fid        = H5I_INVALID_HID;
+    hid_t       did        = H5I_INVALID_HID;
+    hid_t       fsid       = H5I_INVALID_HID;
+    hid_t       msid       = H5I_INVALID_HID;
+    hid_t       dcpl_id    = H5I_INVALID_HID;
+    hid_t       dapl_id    = H5I_INVALID_HID;
+    hid_t       mfapl_id   = H5I_INVALID_HID;
+    int         use_mmap   = 1;
+    int         fill       = -1;
+    hsize_t     dims[2]    = {MMAP_ROWS, MMAP_COLS};
+    hsize_t     maxdims[2] = {H5S_UNLIMITED, MMAP_COLS};
+    hsize_t     start[2]   = {MMAP_ROWS, 0};
+    hsize_t     count[2]   = {MMAP_ROWS, MMAP_COLS};
+    int         in_data[MMAP_ROWS][MMAP_COLS];
+    int         out_data[2 * MMAP_ROWS][MMAP_COLS];
+
+    TESTING("VOL memory-mapped dataset I/O");
+
+    for (int i = 0; i < MMAP_ROWS; i++)
+        for (int j = 0; j < MMAP_COLS; j++)
+            in_data[i][j] = i * MMAP_COLS + j;
+
+    /* Create an HDF5 file and a dataset that's mapped */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((dapl_id = H5Pcreate(H5P_DATASET_ACCESS)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dapl_id, TUTORIAL_VOL_MMAP_PROP, sizeof(int), &use_mmap, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        TEST_ERROR;
+    if (H5Pset_fill_value(dcpl_id, H5T_NATIVE_INT, &fill) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(2, dims, maxdims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset", H5T_NATIVE_INT, fsid, H5P_DEFAULT, dcpl_id, dapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+
+    /* Write it and read it back */
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    memset(out_data, 0, sizeof(out_data));
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+    if (memcmp(in_data, out_data, sizeof(in_data)) != 0) {
+        printf("BAD DATA VALUE\n");
+        TEST_ERROR;
+    }
+
+    /* Grow it and write the new rows, negated */
+    for (int i = 0; i < MMAP_ROWS; i++)
+        for (int j = 0; j < MMAP_COLS; j++)
+            in_data[i][j] = -in_data[i][j];
+    dims[0] = 2 * MMAP_ROWS;
+    if (H5Dset_extent(did, dims) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Dget_space(did)) < 0)
+        TEST_ERROR;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(2, count, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+
+    memset(out_data, 0, sizeof(out_data));
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < 2 * MMAP_ROWS; i++)
+        for (int j = 0; j < MMAP_COLS; j++)
+            if (out_data[i][j] != (i < MMAP_ROWS ? 1 : -1) * ((i % MMAP_ROWS) * MMAP_COLS + j)) {
+                printf("BAD DATA VALUE AFTER GROWING\n");
+                TEST_ERROR;
+            }
+
+    /* Shrink it to half its original rows, then grow it back: the rows in
+     * between were cut, so they read back as the fill value
+     */
+    dims[0] = MMAP_ROWS / 2;
+    if (H5Dset_extent(did, dims) < 0)
+        TEST_ERROR;
+    dims[0] = MMAP_ROWS;
+    if (H5Dset_extent(did, dims) < 0)
+        TEST_ERROR;
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file with every dataset mapped and check the elements */
+    if ((mfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(mfapl_id, TUTORIAL_VOL_MMAP_PROP, sizeof(int), &use_mmap, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, mfapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "dset", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Dget_space(did)) < 0)
+        TEST_ERROR;
+    if (H5Sget_simple_extent_dims(fsid, dims, NULL) < 0)
+        TEST_ERROR;
+    if (dims[0] != MMAP_ROWS || dims[1] != MMAP_COLS) {
+        printf("WRONG EXTENT\n");
+        TEST_ERROR;
+    }
+
+    memset(out_data, 0, sizeof(out_data));
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < MMAP_ROWS; i++)
+        for (int j = 0; j < MMAP_COLS; j++)
+            if (out_data[i][j] != (i < MMAP_ROWS / 2 ? i * MMAP_COLS + j : fill)) {
+                printf("BAD DATA VALUE AFTER SHRINKING\n");
+                TEST_ERROR;
+            }
+
+    /* Close everything */
+    if (H5Pclose(mfapl_id) < 0)
+        TEST_ERROR;
+    if (H5Pclose(dapl_id) < 0)
+        TEST_ERROR;
+    if (H5Pclose(dcpl_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Pclose(mfapl_id);
+        H5Pclose(dapl_id);
+        H5Pclose(dcpl_id);
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_dataset_mmap() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_write_buffer()
+ *
+ * Purpose:     Tests many small writes in a file that buffers them, read
+ *              back while they're buffered, after H5Fflush() and after the
+ *              file is reopened
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define WBUF_N_WRITES 200
+#define WBUF_N_ELMTS  10
+static herr_t
+test_write_buffer(hid_t fapl_id)
+{
+    const char *filename    = "write_buffer.h5tut";
+    hid_t       wfapl_id    = H5I_INVALID_HID;
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       fsid        = H5I_INVALID_HID;
+    hid_t       msid        = H5I_INVALID_HID;
+    hsize_t     dims[1]     = {WBUF_N_WRITES * WBUF_N_ELMTS};
+    hsize_t     start[1]    = {0};
+    hsize_t     count[1]    = {WBUF_N_ELMTS};
+    int         buffer_size = 64 * 1024;
+    int         buf[WBUF_N_ELMTS];
+    int         out[WBUF_N_WRITES * WBUF_N_ELMTS];
+
+    TESTING("VOL write buffer");
+
+    /* Create an HDF5 file that buffers small writes */
+    if ((wfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(wfapl_id, TUTORIAL_VOL_WRITE_BUFFER_PROP, sizeof(int), &buffer_size, NULL, NULL, NULL,
+                   NULL, NULL, NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, wfapl_id)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, count, NULL)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "buffered", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+
+    /* Write it a few elements at a time, checking everything written so far
+     * halfway through, and flushing the file after that
+     */
+    for (int i = 0; i < WBUF_N_WRITES; i++) {
+        for (int j = 0; j < WBUF_N_ELMTS; j++)
+            buf[j] = i * WBUF_N_ELMTS + j;
+
+        start[0] = (hsize_t)i * WBUF_N_ELMTS;
+        if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, buf) < 0)
+            TEST_ERROR;
+
+        if (WBUF_N_WRITES / 2 == i) {
+            if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+                TEST_ERROR;
+            for (int j = 0; j < (i + 1) * WBUF_N_ELMTS; j++)
+                if (out[j] != j) {
+                    printf("WRONG DATA BEFORE FLUSH\n");
+                    TEST_ERROR;
+                }
+            if (H5Fflush(fid, H5F_SCOPE_GLOBAL) < 0)
+                TEST_ERROR;
+        }
+    }
+
+    /* Close everything */
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and check the dataset */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "buffered", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < WBUF_N_WRITES * WBUF_N_ELMTS; i++)
+        if (out[i] != i) {
+            printf("WRONG DATA AFTER REOPEN\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Pclose(wfapl_id) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+        H5Pclose(wfapl_id);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_write_buffer() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_write_buffer_handles()
+ *
+ * Purpose:     Tests overlapping buffered writes through two handles on the
+ *              same dataset, which must land in the order they were made
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define WBUF_HANDLES_N_ELMTS 30
+static herr_t
+test_write_buffer_handles(hid_t fapl_id)
+{
+    const char *filename    = "write_buffer_handles.h5tut";
+    hid_t       wfapl_id    = H5I_INVALID_HID;
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       did1        = H5I_INVALID_HID;
+    hid_t       did2        = H5I_INVALID_HID;
+    hid_t       fsid        = H5I_INVALID_HID;
+    hid_t       msid        = H5I_INVALID_HID;
+    hsize_t     dims[1]     = {WBUF_HANDLES_N_ELMTS};
+    hsize_t     start[1]    = {0};
+    hsize_t     count[1]    = {10};
+    int         buffer_size = 64 * 1024;
+    int         ones[10]    = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    int         twos[10]    = {2, 2, 2, 2, 2, 2, 2, 2, 2, 2};
+    int         threes[10]  = {3, 3, 3, 3, 3, 3, 3, 3, 3, 3};
+    int         expected[WBUF_HANDLES_N_ELMTS];
+    int         out[WBUF_HANDLES_N_ELMTS];
+
+    TESTING("VOL write buffer with two handles on a dataset");
+
+    /* Elements 0-4 from the first write, 5-14 from the second, 15-19 from
+     * the third, and the rest never written
+     */
+    for (int i = 0; i < WBUF_HANDLES_N_ELMTS; i++)
+        expected[i] = i < 5 ? 1 : i < 15 ? 2 : i < 20 ? 3 : 0;
+
+    /* Create an HDF5 file that buffers small writes, and open its dataset
+     * twice
+     */
+    if ((wfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(wfapl_id, TUTORIAL_VOL_WRITE_BUFFER_PROP, sizeof(int), &buffer_size, NULL, NULL, NULL,
+                   NULL, NULL, NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, wfapl_id)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, count, NULL)) < 0)
+        TEST_ERROR;
+    if ((did1 = H5Dcreate2(fid, "buffered", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if ((did2 = H5Dopen2(fid, "buffered", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+
+    /* Overlapping writes, alternating between the handles */
+    start[0] = 0;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did1, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, ones) < 0)
+        TEST_ERROR;
+    start[0] = 5;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did2, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, twos) < 0)
+        TEST_ERROR;
+    start[0] = 15;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did1, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, threes) < 0)
+        TEST_ERROR;
+
+    /* Reading through either handle drains them */
+    if (H5Dread(did2, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < WBUF_HANDLES_N_ELMTS; i++)
+        if (out[i] != expected[i]) {
+            printf("WRONG DATA\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did1) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did2) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(wfapl_id) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did1);
+        H5Dclose(did2);
+        H5Fclose(fid);
+        H5Pclose(wfapl_id);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_write_buffer_handles() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_durable_writes()
+ *
+ * Purpose:     Tests that writes to a file opened for durable writes are
+ *              logged in its journal until the file is flushed, and that
+ *              opening the file replays a journal left behind as if by a
+ *              crash
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define DURABLE_N_WRITES 50
+#define DURABLE_N_ELMTS  20
+static herr_t
+test_durable_writes(hid_t fapl_id)
+{
+    const char *filename     = "durable.h5tut";
+    const char *journal_path = "durable.h5tut/TUTORIAL_VOL_JOURNAL";
+    const char *data_path    = "durable.h5tut/durable/durable.data";
+    hid_t       dfapl_id     = H5I_INVALID_HID;
+    hid_t       fid          = H5I_INVALID_HID;
+    hid_t       did          = H5I_INVALID_HID;
+    hid_t       fsid         = H5I_INVALID_HID;
+    hid_t       msid         = H5I_INVALID_HID;
+    hsize_t     dims[1]      = {DURABLE_N_WRITES * DURABLE_N_ELMTS};
+    hsize_t     start[1]     = {0};
+    hsize_t     count[1]     = {DURABLE_N_ELMTS};
+    int         durable      = 1;
+    int         buf[DURABLE_N_WRITES * DURABLE_N_ELMTS];
+    int         out[DURABLE_N_WRITES * DURABLE_N_ELMTS];
+    char *      journal      = NULL;
+    size_t      journal_size = 0;
+    FILE *      f            = NULL;
+    struct stat st;
+
+    TESTING("VOL durable writes");
+
+    for (int i = 0; i < DURABLE_N_WRITES * DURABLE_N_ELMTS; i++)
+        buf[i] = i + 1;
+
+    /* Create an HDF5 file with durable writes */
+    if ((dfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dfapl_id, TUTORIAL_VOL_DURABLE_PROP, sizeof(int), &durable, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, dfapl_id)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(1, count, NULL)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "durable", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+
+    /* Write it a few elements at a time. Flushing the dataset commits them
+     * all to the journal at once.
+     */
+    for (int i = 0; i < DURABLE_N_WRITES; i++) {
+        start[0] = (hsize_t)i * DURABLE_N_ELMTS;
+        if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, buf + start[0]) < 0)
+            TEST_ERROR;
+    }
+    if (H5Dflush(did) < 0)
+        TEST_ERROR;
+
+    /* Keep a copy of the journal, as a crash right now would have left it */
+    if (stat(journal_path, &st) < 0 || 0 == (journal_size = (size_t)st.st_size))
+        TEST_ERROR;
+    if (NULL == (journal = malloc(journal_size)) || NULL == (f = fopen(journal_path, "rb")) ||
+        fread(journal, 1, journal_size, f) != journal_size)
+        TEST_ERROR;
+    fclose(f);
+    f = NULL;
+
+    /* Close everything, which empties the journal */
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(dfapl_id) < 0)
+        TEST_ERROR;
+    if (stat(journal_path, &st) < 0 || 0 != st.st_size) {
+        printf("JOURNAL NOT EMPTIED\n");
+        TEST_ERROR;
+    }
+
+    /* Lose the elements from the data file (they come after its header)
+     * and put the journal back
+     */
+    memset(out, 0, sizeof(out));
+    if (stat(data_path, &st) < 0 || (size_t)st.st_size < sizeof(out) ||
+        NULL == (f = fopen(data_path, "r+b")) ||
+        fseek(f, (long)((size_t)st.st_size - sizeof(out)), SEEK_SET) < 0 ||
+        fwrite(out, 1, sizeof(out), f) != sizeof(out))
+        TEST_ERROR;
+    fclose(f);
+    if (NULL == (f = fopen(journal_path, "wb")) || fwrite(journal, 1, journal_size, f) != journal_size)
+        TEST_ERROR;
+    fclose(f);
+    f = NULL;
+
+    /* The journal can't be replayed without write access, so a read-only
+     * open fails
+     */
+    H5E_BEGIN_TRY
+    {
+        fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id);
+    }
+    H5E_END_TRY;
+    if (fid >= 0) {
+        printf("OPENED READ-ONLY WITH A JOURNAL TO REPLAY\n");
+        TEST_ERROR;
+    }
+
+    /* Reopen the file, which replays the journal, and check the dataset */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDWR, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "durable", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    for (int i = 0; i < DURABLE_N_WRITES * DURABLE_N_ELMTS; i++)
+        if (out[i] != buf[i]) {
+            printf("WRONG DATA AFTER RECOVERY\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    free(journal);
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+        H5Pclose(dfapl_id);
+    }
+    H5E_END_TRY;
+    if (f)
+        fclose(f);
+    free(journal);
+    return FAIL;
+
+} /* end test_durable_writes() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_durable_relayout()
+ *
+ * Purpose:     Tests that changing the extent of a dataset in a file
+ *              opened for durable writes, which moves its elements, leaves
+ *              nothing in the journal that replaying would put where the
+ *              elements used to be
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define RELAYOUT_ROWS     10
+#define RELAYOUT_OLD_COLS 10
+#define RELAYOUT_NEW_COLS 20
+static herr_t
+test_durable_relayout(hid_t fapl_id)
+{
+    const char *filename     = "durable_relayout.h5tut";
+    const char *journal_path = "durable_relayout.h5tut/TUTORIAL_VOL_JOURNAL";
+    hid_t       dfapl_id     = H5I_INVALID_HID;
+    hid_t       fid          = H5I_INVALID_HID;
+    hid_t       did          = H5I_INVALID_HID;
+    hid_t       fsid         = H5I_INVALID_HID;
+    hid_t       msid         = H5I_INVALID_HID;
+    hsize_t     dims[2]      = {RELAYOUT_ROWS, RELAYOUT_OLD_COLS};
+    hsize_t     maxdims[2]   = {RELAYOUT_ROWS, RELAYOUT_NEW_COLS};
+    hsize_t     start[2]     = {0, 0};
+    hsize_t     count[2]     = {1, RELAYOUT_NEW_COLS};
+    int         durable      = 1;
+    int         buf[RELAYOUT_ROWS * RELAYOUT_OLD_COLS];
+    int         row[RELAYOUT_NEW_COLS];
+    int         out[RELAYOUT_ROWS * RELAYOUT_NEW_COLS];
+    char *      journal      = NULL;
+    size_t      journal_size = 0;
+    FILE *      f            = NULL;
+    struct stat st;
+
+    TESTING("VOL durable writes across a change of extent");
+
+    for (int i = 0; i < RELAYOUT_ROWS * RELAYOUT_OLD_COLS; i++)
+        buf[i] = i + 1;
+    for (int i = 0; i < RELAYOUT_NEW_COLS; i++)
+        row[i] = -(i + 1);
+
+    /* Create an HDF5 file with durable writes, and write a dataset through
+     * the journal
+     */
+    if ((dfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dfapl_id, TUTORIAL_VOL_DURABLE_PROP, sizeof(int), &durable, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, dfapl_id)) < 0)
+        TEST_ERROR;
+    if ((fsid = H5Screate_simple(2, dims, maxdims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "relayout", H5T_NATIVE_INT, fsid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+        TEST_ERROR;
+    if (H5Dflush(did) < 0)
+        TEST_ERROR;
+
+    /* Widen the rows, which moves every row but the first */
+    dims[1] = RELAYOUT_NEW_COLS;
+    if (H5Dset_extent(did, dims) < 0)
+        TEST_ERROR;
+
+    /* Write the first row through the journal again */
+    if ((fsid = H5Dget_space(did)) < 0)
+        TEST_ERROR;
+    if ((msid = H5Screate_simple(2, count, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, count, NULL) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, row) < 0)
+        TEST_ERROR;
+    if (H5Dflush(did) < 0)
+        TEST_ERROR;
+
+    /* Keep a copy of the journal, as a crash right now would have left it */
+    if (stat(journal_path, &st) < 0 || 0 == (journal_size = (size_t)st.st_size))
+        TEST_ERROR;
+    if (NULL == (journal = malloc(journal_size)) || NULL == (f = fopen(journal_path, "rb")) ||
+        fread(journal, 1, journal_size, f) != journal_size)
+        TEST_ERROR;
+    fclose(f);
+    f = NULL;
+
+    /* Close everything, then put the journal back */
+    if (H5Sclose(msid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(fsid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(dfapl_id) < 0)
+        TEST_ERROR;
+    if (NULL == (f = fopen(journal_path, "wb")) || fwrite(journal, 1, journal_size, f) != journal_size)
+        TEST_ERROR;
+    fclose(f);
+    f = NULL;
+
+    /* Reopen the file, which replays the journal. Only the write made
+     * after the change of extent is replayed.
+     */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDWR, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dopen2(fid, "relayout", H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+        TEST_ERROR;
+    for (int r = 0; r < RELAYOUT_ROWS; r++)
+        for (int c = 0; c < RELAYOUT_NEW_COLS; c++) {
+            int expected = 0;
+
+            if (0 == r)
+                expected = row[c];
+            else if (c < RELAYOUT_OLD_COLS)
+                expected = buf[r * RELAYOUT_OLD_COLS + c];
+
+            if (out[r * RELAYOUT_NEW_COLS + c] != expected) {
+                printf("WRONG DATA AFTER RECOVERY\n");
+                TEST_ERROR;
+            }
+        }
+
+    /* Close everything */
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    free(journal);
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(fsid);
+        H5Sclose(msid);
+        H5Dclose(did);
+        H5Fclose(fid);
+        H5Pclose(dfapl_id);
+    }
+    H5E_END_TRY;
+    if (f)
+        fclose(f);
+    free(journal);
+    return FAIL;
+
+} /* end test_durable_relayout() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_durable_batch()
+ *
+ * Purpose:     Tests batched dataset creation in a file opened for durable
+ *              writes, with another dataset's writes waiting in the write
+ *              buffer while the batch's datasets are made and written on
+ *              the thread pool
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define DURABLE_BATCH_N_DSETS 200
+#define DURABLE_BATCH_N_ELMTS 16
+static herr_t
+test_durable_batch(hid_t fapl_id)
+{
+    const char *filename    = "durable_batch.h5tut";
+    hid_t       dfapl_id    = H5I_INVALID_HID;
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       pdid        = H5I_INVALID_HID;
+    hid_t       sid         = H5I_INVALID_HID;
+    hsize_t     dims[1]     = {DURABLE_BATCH_N_ELMTS};
+    int         one         = 1;
+    int         nthreads    = 4;
+    int         buffer_size = (int)sizeof(int);
+    int         buf[DURABLE_BATCH_N_ELMTS];
+    int         out[DURABLE_BATCH_N_ELMTS];
+    char        name[32];
+
+    TESTING("VOL durable writes with batched creation");
+
+    /* Create an HDF5 file that batches creation (on more than one thread)
+     * and logs writes, committing each one to the journal as it's made
+     */
+    if ((dfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dfapl_id, TUTORIAL_VOL_NTHREADS_PROP, sizeof(int), &nthreads, NULL, NULL, NULL, NULL,
+                   NULL, NULL) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dfapl_id, TUTORIAL_VOL_WRITE_BUFFER_PROP, sizeof(int), &buffer_size, NULL, NULL, NULL,
+                   NULL, NULL, NULL) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dfapl_id, TUTORIAL_VOL_BATCH_CREATE_PROP, sizeof(int), &one, NULL, NULL, NULL, NULL,
+                   NULL, NULL) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(dfapl_id, TUTORIAL_VOL_DURABLE_PROP, sizeof(int), &one, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, dfapl_id)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, NULL)) < 0)
+        TEST_ERROR;
+
+    /* A dataset created before the batch, whose writes are in the journal
+     * when the batch runs
+     */
+    if ((pdid = H5Dcreate2(fid, "plain", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Fflush(fid, H5F_SCOPE_GLOBAL) < 0)
+        TEST_ERROR;
+
+    /* Create, write and close many small datasets, which are all held back */
+    for (int i = 0; i < DURABLE_BATCH_N_DSETS; i++) {
+        snprintf(name, sizeof(name), "dset_%d", i);
+        for (int j = 0; j < DURABLE_BATCH_N_ELMTS; j++)
+            buf[j] = i * DURABLE_BATCH_N_ELMTS + j;
+
+        if ((did = H5Dcreate2(fid, name, H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+            TEST_ERROR;
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+
+        /* Writing to the other dataset makes the batch run first */
+        if (i % 20 == 19) {
+            if (H5Dwrite(pdid, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+                TEST_ERROR;
+            if (H5Dread(pdid, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+                TEST_ERROR;
+            if (memcmp(buf, out, sizeof(buf)) != 0) {
+                printf("WRONG DATA BEFORE FLUSH\n");
+                TEST_ERROR;
+            }
+        }
+    }
+
+    if (H5Dclose(pdid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Reopen the file and check every dataset */
+    if ((fid = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id)) < 0)
+        TEST_ERROR;
+    for (int i = 0; i <= DURABLE_BATCH_N_DSETS; i++) {
+        int last = i < DURABLE_BATCH_N_DSETS ? i : DURABLE_BATCH_N_DSETS - 1;
+
+        if (i < DURABLE_BATCH_N_DSETS)
+            snprintf(name, sizeof(name), "dset_%d", i);
+        else
+            snprintf(name, sizeof(name), "plain");
+
+        if ((did = H5Dopen2(fid, name, H5P_DEFAULT)) < 0)
+            TEST_ERROR;
+        if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out) < 0)
+            TEST_ERROR;
+        for (int j = 0; j < DURABLE_BATCH_N_ELMTS; j++)
+            if (out[j] != last * DURABLE_BATCH_N_ELMTS + j) {
+                printf("WRONG DATA AFTER REOPEN\n");
+                TEST_ERROR;
+            }
+        if (H5Dclose(did) < 0)
+            TEST_ERROR;
+    }
+
+    /* Close everything */
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(dfapl_id) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Dclose(pdid);
+        H5Fclose(fid);
+        H5Pclose(dfapl_id);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_durable_batch() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_async()
+ *
+ * Purpose:     Tests asynchronous group and dataset creation and dataset
+ *              I/O through an event set
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define ASYNC_N_ELMTS 100000
+static herr_t
+test_async(hid_t fapl_id)
+{
+    const char *filename    = "async.h5tut";
+    hid_t       fid         = H5I_INVALID_HID;
+    hid_t       gid         = H5I_INVALID_HID;
+    hid_t       did         = H5I_INVALID_HID;
+    hid_t       sid         = H5I_INVALID_HID;
+    hid_t       es_id       = H5I_INVALID_HID;
+    hsize_t     dims[1]     = {ASYNC_N_ELMTS};
+    size_t      in_progress = 0;
+    hbool_t     op_failed   = false;
+    int *       in_data     = NULL;
+    double *    out_data    = NULL;
+
+    TESTING("VOL asynchronous operations");
+
+    if (NULL == (in_data = malloc(ASYNC_N_ELMTS * sizeof(int))))
+        TEST_ERROR;
+    if (NULL == (out_data = malloc(ASYNC_N_ELMTS * sizeof(double))))
+        TEST_ERROR;
+    for (int i = 0; i < ASYNC_N_ELMTS; i++)
+        in_data[i] = i * 3 - 7;
+
+    /* Create an HDF5 file using the tutorial VOL connector */
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        TEST_ERROR;
+    if ((es_id = H5EScreate()) < 0)
+        TEST_ERROR;
+
+    /* Queue up a group, a dataset in it, a write and a (converting) read */
+    if ((gid = H5Gcreate_async(fid, "group", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT, es_id)) < 0)
+        TEST_ERROR;
+    if ((sid = H5Screate_simple(1, dims, dims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate_async(gid, "dset", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT,
+                               es_id)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite_async(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data, es_id) < 0)
+        TEST_ERROR;
+    if (H5Dread_async(did, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data, es_id) < 0)
+        TEST_ERROR;
+
+    /* Wait for all of it */
+    if (H5ESwait(es_id, H5ES_WAIT_FOREVER, &in_progress, &op_failed) < 0)
+        TEST_ERROR;
+    if (in_progress > 0 || op_failed)
+        TEST_ERROR;
+
+    for (int i = 0; i < ASYNC_N_ELMTS; i++)
+        if (out_data[i] != (double)in_data[i]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Close everything */
+    if (H5ESclose(es_id) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Gclose(gid) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+
+    free(in_data);
+    free(out_data);
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5ESwait(es_id, H5ES_WAIT_FOREVER, &in_progress, &op_failed);
+        H5ESclose(es_id);
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Gclose(gid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    free(in_data);
+    free(out_data);
+    return FAIL;
+
+} /* end test_async() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_dataset_parallel()
+ *
+ * Purpose:     Tests dataset I/O large enough to be split across the
+ *              file's worker threads
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define PARALLEL_ROWS 1000
+#define PARALLEL_COLS 2000
+static herr_t
+test_dataset_parallel(hid_t fapl_id)
+{
+    const char *filename   = "dataset_parallel.h5tut";
+    hid_t       fid        = H5I_INVALID_HID;
+    hid_t       did        = H5I_INVALID_HID;
+    hid_t       sid        = H5I_INVALID_HID;
+    hid_t       mem_sid    = H5I_INVALID_HID;
+    hid_t       pfapl_id   = H5I_INVALID_HID;
+    int         nthreads   = 4;
+    hsize_t     dims[2]    = {PARALLEL_ROWS, PARALLEL_COLS};
+    hsize_t     start[2]   = {1, 3};
+    hsize_t     stride[2]  = {2, 3};
+    hsize_t     count[2]   = {PARALLEL_ROWS / 2, PARALLEL_COLS / 3};
+    int *       in_data    = NULL;
+    double *    out_data   = NULL;
+    size_t      n_elmts    = PARALLEL_ROWS * PARALLEL_COLS;
+    size_t      n_selected = (PARALLEL_ROWS / 2) * (PARALLEL_COLS / 3);
+
+    TESTING("VOL parallel dataset I/O");
+
+    if (NULL == (in_data = malloc(n_elmts * sizeof(int))))
+        TEST_ERROR;
+    if (NULL == (out_data = malloc(n_elmts * sizeof(double))))
+        TEST_ERROR;
+    for (size_t i = 0; i < n_elmts; i++)
+        in_data[i] = (int)i * 31 - 1000000;
+
+    /* Create an HDF5 file that uses four threads for dataset I/O */
+    if ((pfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(pfapl_id, TUTORIAL_VOL_NTHREADS_PROP, sizeof(int), &nthreads, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, pfapl_id)) < 0)
+        TEST_ERROR;
+
+    /* Write the whole dataset and read it back with a conversion */
+    if ((sid = H5Screate_simple(2, dims, dims)) < 0)
+        TEST_ERROR;
+    if ((did = H5Dcreate2(fid, "dset", H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+        TEST_ERROR;
+    if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, in_data) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (size_t i = 0; i < n_elmts; i++)
+        if (out_data[i] != (double)in_data[i]) {
+            printf("BAD DATA VALUE\n");
+            TEST_ERROR;
+        }
+
+    /* Read a strided selection */
+    if (H5Sselect_hyperslab(sid, H5S_SELECT_SET, start, stride, count, NULL) < 0)
+        TEST_ERROR;
+    if ((mem_sid = H5Screate_simple(2, count, NULL)) < 0)
+        TEST_ERROR;
+    if (H5Dread(did, H5T_NATIVE_DOUBLE, mem_sid, sid, H5P_DEFAULT, out_data) < 0)
+        TEST_ERROR;
+
+    for (size_t i = 0; i < n_selected; i++) {
+        size_t row = start[0] + stride[0] * (i / count[1]);
+        size_t col = start[1] + stride[1] * (i % count[1]);
+
+        if (out_data[i] != (double)in_data[row * PARALLEL_COLS + col]) {
+            printf("BAD SELECTED VALUE\n");
+            TEST_ERROR;
+        }
+    }
+
+    /* Close everything */
+    if (H5Sclose(mem_sid) < 0)
+        TEST_ERROR;
+    if (H5Sclose(sid) < 0)
+        TEST_ERROR;
+    if (H5Dclose(did) < 0)
+        TEST_ERROR;
+    if (H5Fclose(fid) < 0)
+        TEST_ERROR;
+    if (H5Pclose(pfapl_id) < 0)
+        TEST_ERROR;
+
+    free(in_data);
+    free(out_data);
+
+    /* Delete the file */
+    if (DELETE_FILES_g)
+        if (H5Fdelete(filename, fapl_id) < 0)
+            TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(mem_sid);
+        H5Sclose(sid);
+        H5Dclose(did);
+        H5Fclose(fid);
+        H5Pclose(pfapl_id);
+    }
+    H5E_END_TRY;
+    free(in_data);
+    free(out_data);
+    return FAIL;
+
+} /* end test_dataset_parallel() */
+
+/*-------------------------------------------------------------------------
+ * Function:    create_delete_file()
+ *
+ * Purpose:     Creates a file with groups of small datasets for
+ *              test_file_delete() to delete
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+#define DELETE_NGROUPS 4
+#define DELETE_NDSETS  50
+static herr_t
+create_delete_file(const char *filename, hid_t fapl_id)
+{
+    hid_t   fid     = H5I_INVALID_HID;
+    hid_t   gid     = H5I_INVALID_HID;
+    hid_t   did     = H5I_INVALID_HID;
+    hid_t   sid     = H5I_INVALID_HID;
+    hsize_t dims[1] = {16};
+    char    name[32];
+
+    if ((fid = H5Fcreate(filename, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        goto error;
+    if ((sid = H5Screate_simple(1, dims, dims)) < 0)
+        goto error;
+
+    for (int i = 0; i < DELETE_NGROUPS; i++) {
+        snprintf(name, sizeof(name), "group%d", i);
+        if ((gid = H5Gcreate2(fid, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+            goto error;
+
+        for (int j = 0; j < DELETE_NDSETS; j++) {
+            snprintf(name, sizeof(name), "dset%d", j);
+            if ((did = H5Dcreate2(gid, name, H5T_NATIVE_INT, sid, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) < 0)
+                goto error;
+            if (H5Dclose(did) < 0)
+                goto error;
+        }
+
+        if (H5Gclose(gid) < 0)
+            goto error;
+    }
+
+    if (H5Sclose(sid) < 0)
+        goto error;
+    if (H5Fclose(fid) < 0)
+        goto error;
+
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Dclose(did);
+        H5Gclose(gid);
+        H5Sclose(sid);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end create_delete_file() */
+
+/*-------------------------------------------------------------------------
+ * Function:    test_file_delete()
+ *
+ * Purpose:     Tests deleting files over several threads, and in the
+ *              background
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+test_file_delete(hid_t fapl_id)
+{
+    const char *filename   = "file_delete.h5tut";
+    hid_t       pfapl_id   = H5I_INVALID_HID;
+    hid_t       bfapl_id   = H5I_INVALID_HID;
+    int         nthreads   = 4;
+    int         background = 1;
+    struct stat st;
+
+    TESTING("VOL file deletion");
+
+    if ((pfapl_id = H5Pcopy(fapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(pfapl_id, TUTORIAL_VOL_NTHREADS_PROP, sizeof(int), &nthreads, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        TEST_ERROR;
+
+    /* Delete a file over four threads */
+    if (create_delete_file(filename, fapl_id) < 0)
+        TEST_ERROR;
+    if (H5Fdelete(filename, pfapl_id) < 0)
+        TEST_ERROR;
+    if (stat(filename, &st) == 0) {
+        printf("FILE NOT DELETED\n");
+        TEST_ERROR;
+    }
+
+    /* Delete one in the background. Its name is free straight away. */
+    if ((bfapl_id = H5Pcopy(pfapl_id)) < 0)
+        TEST_ERROR;
+    if (H5Pinsert2(bfapl_id, TUTORIAL_VOL_DELETE_IN_BACKGROUND_PROP, sizeof(int), &background, NULL, NULL,
+                   NULL, NULL, NULL, NULL) < 0)
+        TEST_ERROR;
+    if (create_delete_file(filename, fapl_id) < 0)
+        TEST_ERROR;
+    if (H5Fdelete(filename, bfapl_id) < 0)
+        TEST_ERROR;
+    if (stat(filename, &st) == 0) {
+        printf("FILE NOT MOVED AWAY\n");
+        TEST_ERROR;
+    }
+    if (create_delete_file(filename, fapl_id) < 0)
+        TEST_ERROR;
+
+    if (H5Pclose(bfapl_id) < 0)
+        TEST_ERROR;
+    if (H5Pclose(pfapl_id) < 0)
+        TEST_ERROR;
+
+    /* Delete the file */
+    if (H5Fdelete(filename, fapl_id) < 0)
+        TEST_ERROR;
+
+    PASSED();
+    return SUCCEED;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Pclose(bfapl_id);
+        H5Pclose(pfapl_id);
+    }
+    H5E_END_TRY;
+    return FAIL;
+
+} /* end test_file_delete() */
+
 /*-------------------------------------------------------------------------
  * Function:    main
  *
@@ -569,8 +3956,33 @@ main(void)
     }
 
     nerrors += test_file_ops(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_file_close_early(fapl_id) < 0 ? 1 : 0;
     nerrors += test_group_ops(fapl_id) < 0 ? 1 : 0;
     nerrors += test_dataset_ops(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_selections(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_2d(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_chunked(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_allocation(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_types(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_text(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_reopen(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_metadata(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_nested_groups(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_group_links(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_group_index(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_attributes(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_batch_create(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_filters(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_extend(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_mmap(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_write_buffer(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_write_buffer_handles(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_durable_writes(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_durable_relayout(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_durable_batch(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_async(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_dataset_parallel(fapl_id) < 0 ? 1 : 0;
+    nerrors += test_file_delete(fapl_id) < 0 ? 1 : 0;
 
     /* Close fapl and VOL connector */
     if (H5Pclose(fapl_id) < 0) {
@@ -0,0 +1,534 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Copyright by The HDF Group.                                               *
+ * All rights reserved.                                                      *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/*
+ * Purpose:     Measures dataset read and write throughput through the
+ *              tutorial VOL connector.
+ *
+ *              Sweeps data file format, layout, rank, dataset size,
+ *              selection shape and access pattern, and prints one CSV row
+ *              per operation and configuration to stdout.
+ *
+ *              Uses the tutorial VOL connector which is loaded as a
+ *              dynamically-loaded plugin.
+ */
+
+#include <hdf5.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tutorial_vol_connector.h"
+
+#define BENCH_FILENAME "tutorial_bench.h5tut"
+
+/* Rewriting a text data file costs the whole file, so text is only
+ * measured at sizes up to this many elements.
+ */
+#define TEXT_MAX_NELMTS ((hsize_t)1 << 18)
+
+/* Each window is about this fraction of the dataset */
+#define WINDOWS_PER_DATASET 64
+
+#define MAX_SIZES 16
+
+enum bench_shape {
+    SHAPE_SLAB, /* Whole rows along the slowest dimension (contiguous in the file) */
+    SHAPE_TILE, /* The same extent in every dimension */
+};
+
+enum bench_pattern {
+    PATTERN_SEQUENTIAL, /* Every window, in order */
+    PATTERN_STRIDED,    /* Every fourth window */
+    PATTERN_RANDOM,     /* Windows in random order */
+};
+
+static const char *shape_names[]   = {"slab", "tile"};
+static const char *pattern_names[] = {"sequential", "strided", "random"};
+
+struct bench_config {
+    int     format;
+    hbool_t chunked;
+    int     rank;
+    hsize_t dims[3];
+    hsize_t nelmts;
+};
+
+struct bench_options {
+    hsize_t  sizes[MAX_SIZES];
+    int      nsizes;
+    int      iters;
+    size_t   max_ops;
+    uint64_t seed;
+};
+
+/* Small deterministic generator so runs are comparable */
+static uint64_t rng_state_g;
+
+static uint64_t
+next_random(void)
+{
+    rng_state_g = rng_state_g * 6364136223846793005ull + 1442695040888963407ull;
+
+    return rng_state_g >> 33;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Largest r such that r^rank <= n */
+static hsize_t
+int_root(hsize_t n, int rank)
+{
+    hsize_t r = 1;
+
+    for (;;) {
+        hsize_t p = 1;
+
+        for (int i = 0; i < rank; i++)
+            p *= r + 1;
+        if (p > n)
+            return r;
+        r++;
+    }
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Value at quantile q of n sorted values */
+static double
+percentile(const double *sorted, size_t n, double q)
+{
+    return sorted[(size_t)(q * (double)(n - 1) + 0.5)];
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    report()
+ *
+ * Purpose:     Prints one CSV row for a set of timed operations
+ *
+ *-------------------------------------------------------------------------
+ */
+static void
+report(const char *op, const struct bench_config *cfg, const char *selection, const char *pattern,
+       hsize_t window_nelmts, double *lat, size_t nops)
+{
+    double total = 0.0;
+    double bytes = (double)window_nelmts * sizeof(int) * (double)nops;
+    char   dims[64];
+
+    if (0 == nops)
+        return;
+
+    for (size_t i = 0; i < nops; i++)
+        total += lat[i];
+    qsort(lat, nops, sizeof(double), compare_doubles);
+
+    if (1 == cfg->rank)
+        snprintf(dims, sizeof(dims), "%llu", (unsigned long long)cfg->dims[0]);
+    else if (2 == cfg->rank)
+        snprintf(dims, sizeof(dims), "%llux%llu", (unsigned long long)cfg->dims[0],
+                 (unsigned long long)cfg->dims[1]);
+    else
+        snprintf(dims, sizeof(dims), "%llux%llux%llu", (unsigned long long)cfg->dims[0],
+                 (unsigned long long)cfg->dims[1], (unsigned long long)cfg->dims[2]);
+
+    printf("%s,%s,%s,%d,%s,%s,%s,%llu,%zu,%.0f,%.6f,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f\n", op,
+           TUTORIAL_VOL_DATA_FORMAT_TEXT == cfg->format ? "text" : "binary",
+           cfg->chunked ? "chunked" : "contiguous", cfg->rank, dims, selection, pattern,
+           (unsigned long long)window_nelmts, nops, bytes, total, total > 0 ? bytes / total / 1e6 : 0.0,
+           total > 0 ? (double)nops / total : 0.0, percentile(lat, nops, 0.50) * 1e6,
+           percentile(lat, nops, 0.90) * 1e6, percentile(lat, nops, 0.99) * 1e6, lat[nops - 1] * 1e6);
+    fflush(stdout);
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    bench_full()
+ *
+ * Purpose:     Times writes and reads of the whole dataset
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+bench_full(hid_t did, const struct bench_config *cfg, const struct bench_options *opts, int *buf)
+{
+    double *lat = NULL;
+
+    lat = malloc((size_t)opts->iters * sizeof(double));
+
+    for (int i = 0; i < opts->iters; i++) {
+        double start = now();
+
+        if (H5Dwrite(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+            goto error;
+        lat[i] = now() - start;
+    }
+    report("write", cfg, "all", "full", cfg->nelmts, lat, (size_t)opts->iters);
+
+    for (int i = 0; i < opts->iters; i++) {
+        double start;
+
+        memset(buf, 0, (size_t)cfg->nelmts * sizeof(int));
+        start = now();
+        if (H5Dread(did, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf) < 0)
+            goto error;
+        lat[i] = now() - start;
+    }
+    report("read", cfg, "all", "full", cfg->nelmts, lat, (size_t)opts->iters);
+
+    /* Make sure what's being timed actually works */
+    for (hsize_t i = 0; i < cfg->nelmts; i++)
+        if (buf[i] != (int)i) {
+            fprintf(stderr, "bad data value at %llu\n", (unsigned long long)i);
+            goto error;
+        }
+
+    free(lat);
+    return 0;
+
+error:
+    free(lat);
+    return -1;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    bench_windows()
+ *
+ * Purpose:     Times writes and then reads of windows of the dataset,
+ *              visited in the given pattern
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+bench_windows(hid_t did, const struct bench_config *cfg, const struct bench_options *opts,
+              enum bench_shape shape, enum bench_pattern pattern, int *buf)
+{
+    hid_t    fsid = H5I_INVALID_HID;
+    hid_t    msid = H5I_INVALID_HID;
+    hsize_t  win[3];
+    hsize_t  grid[3];
+    hsize_t  nwindows      = 1;
+    hsize_t  window_nelmts = 1;
+    hsize_t  target        = cfg->nelmts / WINDOWS_PER_DATASET;
+    size_t   nops          = 0;
+    double * lat           = NULL;
+    hsize_t *order         = NULL;
+
+    if (0 == target)
+        target = 1;
+
+    /* Size the window */
+    for (int i = 0; i < cfg->rank; i++) {
+        if (SHAPE_SLAB == shape)
+            win[i] = (0 == i) ? target / (cfg->nelmts / cfg->dims[0]) : cfg->dims[i];
+        else
+            win[i] = int_root(target, cfg->rank);
+        if (0 == win[i])
+            win[i] = 1;
+        if (win[i] > cfg->dims[i])
+            win[i] = cfg->dims[i];
+        grid[i] = cfg->dims[i] / win[i];
+        nwindows *= grid[i];
+        window_nelmts *= win[i];
+    }
+
+    /* Pick the windows to visit, as row-major indices into the grid */
+    order = malloc((size_t)nwindows * sizeof(hsize_t));
+    for (hsize_t k = 0; k < nwindows; k += (PATTERN_STRIDED == pattern) ? 4 : 1)
+        order[nops++] = k;
+    if (PATTERN_RANDOM == pattern)
+        for (size_t k = nops - 1; k > 0; k--) {
+            size_t  j   = (size_t)(next_random() % (k + 1));
+            hsize_t tmp = order[k];
+
+            order[k] = order[j];
+            order[j] = tmp;
+        }
+    if (nops > opts->max_ops)
+        nops = opts->max_ops;
+
+    lat = malloc(nops * sizeof(double));
+
+    if ((fsid = H5Dget_space(did)) < 0)
+        goto error;
+    if ((msid = H5Screate_simple(cfg->rank, win, NULL)) < 0)
+        goto error;
+
+    for (int write = 1; write >= 0; write--) {
+        for (size_t k = 0; k < nops; k++) {
+            hsize_t start[3];
+            hsize_t idx = order[k];
+            double  t0;
+
+            for (int i = cfg->rank - 1; i >= 0; i--) {
+                start[i] = (idx % grid[i]) * win[i];
+                idx /= grid[i];
+            }
+
+            t0 = now();
+            if (H5Sselect_hyperslab(fsid, H5S_SELECT_SET, start, NULL, win, NULL) < 0)
+                goto error;
+            if (write) {
+                if (H5Dwrite(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, buf) < 0)
+                    goto error;
+            }
+            else if (H5Dread(did, H5T_NATIVE_INT, msid, fsid, H5P_DEFAULT, buf) < 0)
+                goto error;
+            lat[k] = now() - t0;
+        }
+
+        report(write ? "write" : "read", cfg, shape_names[shape], pattern_names[pattern], window_nelmts, lat,
+               nops);
+    }
+
+    H5Sclose(msid);
+    H5Sclose(fsid);
+    free(order);
+    free(lat);
+    return 0;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Sclose(msid);
+        H5Sclose(fsid);
+    }
+    H5E_END_TRY;
+    free(order);
+    free(lat);
+    return -1;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    bench_config()
+ *
+ * Purpose:     Runs every measurement on one dataset configuration
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t
+bench_config(hid_t fapl_id, const struct bench_config *cfg, const struct bench_options *opts)
+{
+    hid_t fid     = H5I_INVALID_HID;
+    hid_t did     = H5I_INVALID_HID;
+    hid_t sid     = H5I_INVALID_HID;
+    hid_t dcpl_id = H5I_INVALID_HID;
+    int   format  = cfg->format;
+    int * buf     = NULL;
+
+    buf = malloc((size_t)cfg->nelmts * sizeof(int));
+    for (hsize_t i = 0; i < cfg->nelmts; i++)
+        buf[i] = (int)i;
+
+    H5E_BEGIN_TRY
+    {
+        H5Fdelete(BENCH_FILENAME, fapl_id);
+    }
+    H5E_END_TRY;
+
+    if ((fid = H5Fcreate(BENCH_FILENAME, H5F_ACC_EXCL, H5P_DEFAULT, fapl_id)) < 0)
+        goto error;
+
+    if ((dcpl_id = H5Pcreate(H5P_DATASET_CREATE)) < 0)
+        goto error;
+    if (H5Pinsert2(dcpl_id, TUTORIAL_VOL_DATA_FORMAT_PROP, sizeof(int), &format, NULL, NULL, NULL, NULL, NULL,
+                   NULL) < 0)
+        goto error;
+    if (cfg->chunked) {
+        hsize_t chunk[3];
+
+        /* About as many chunks as windows */
+        for (int i = 0; i < cfg->rank; i++) {
+            chunk[i] = int_root(cfg->nelmts / WINDOWS_PER_DATASET, cfg->rank);
+            if (0 == chunk[i])
+                chunk[i] = 1;
+            if (chunk[i] > cfg->dims[i])
+                chunk[i] = cfg->dims[i];
+        }
+        if (H5Pset_chunk(dcpl_id, cfg->rank, chunk) < 0)
+            goto error;
+    }
+
+    if ((sid = H5Screate_simple(cfg->rank, cfg->dims, NULL)) < 0)
+        goto error;
+    if ((did = H5Dcreate2(fid, "bench", H5T_NATIVE_INT, sid, H5P_DEFAULT, dcpl_id, H5P_DEFAULT)) < 0)
+        goto error;
+
+    if (bench_full(did, cfg, opts, buf) < 0)
+        goto error;
+    for (int shape = SHAPE_SLAB; shape <= SHAPE_TILE; shape++) {
+        /* Slabs and tiles are the same thing in 1D */
+        if (1 == cfg->rank && SHAPE_TILE == shape)
+            continue;
+        for (int pattern = PATTERN_SEQUENTIAL; pattern <= PATTERN_RANDOM; pattern++)
+            if (bench_windows(did, cfg, opts, (enum bench_shape)shape, (enum bench_pattern)pattern, buf) <
+                0)
+                goto error;
+    }
+
+    if (H5Dclose(did) < 0)
+        goto error;
+    if (H5Sclose(sid) < 0)
+        goto error;
+    if (H5Pclose(dcpl_id) < 0)
+        goto error;
+    if (H5Fclose(fid) < 0)
+        goto error;
+    if (H5Fdelete(BENCH_FILENAME, fapl_id) < 0)
+        goto error;
+
+    free(buf);
+    return 0;
+
+error:
+    H5E_BEGIN_TRY
+    {
+        H5Dclose(did);
+        H5Sclose(sid);
+        H5Pclose(dcpl_id);
+        H5Fclose(fid);
+    }
+    H5E_END_TRY;
+    free(buf);
+    return -1;
+}
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--quick] [--size NELMTS]... [--iters N] [--ops N] [--seed N]\n"
+            "\n"
+            "  --quick         small sizes and few operations (smoke test)\n"
+            "  --size NELMTS   dataset size in elements (repeatable)\n"
+            "  --iters N       repetitions of whole-dataset reads and writes\n"
+            "  --ops N         maximum window operations per access pattern\n"
+            "  --seed N        seed for the random access pattern\n",
+            prog);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct bench_options opts;
+    hid_t                fapl_id = H5I_INVALID_HID;
+    hid_t                vol_id  = H5I_INVALID_HID;
+    int                  nerrors = 0;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.iters   = 5;
+    opts.max_ops = 256;
+    opts.seed    = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            opts.sizes[0] = (hsize_t)1 << 12;
+            opts.sizes[1] = (hsize_t)1 << 16;
+            opts.nsizes   = 2;
+            opts.iters    = 2;
+            opts.max_ops  = 16;
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc && opts.nsizes < MAX_SIZES)
+            opts.sizes[opts.nsizes++] = (hsize_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc)
+            opts.iters = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+            opts.max_ops = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            opts.seed = strtoull(argv[++i], NULL, 10);
+        else {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (0 == opts.nsizes) {
+        opts.sizes[0] = (hsize_t)1 << 16;
+        opts.sizes[1] = (hsize_t)1 << 20;
+        opts.sizes[2] = (hsize_t)1 << 22;
+        opts.nsizes   = 3;
+    }
+    if (opts.iters < 1)
+        opts.iters = 1;
+    if (0 == opts.max_ops)
+        opts.max_ops = 1;
+
+    /* Create a fapl that uses the tutorial VOL connector */
+    if ((fapl_id = H5Pcreate(H5P_FILE_ACCESS)) < 0) {
+        fprintf(stderr, "File access property list creation FAILED\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((vol_id = H5VLregister_connector_by_name(TUTORIAL_VOL_CONNECTOR_NAME, H5P_DEFAULT)) < 0) {
+        fprintf(stderr, "Tutorial VOL registration FAILED\n");
+        exit(EXIT_FAILURE);
+    }
+    if (H5Pset_vol(fapl_id, vol_id, NULL) < 0) {
+        fprintf(stderr, "Setting VOL in the fapl FAILED\n");
+        exit(EXIT_FAILURE);
+    }
+
+    puts("op,format,layout,rank,dims,selection,pattern,window_elmts,nops,bytes,seconds,mb_per_s,ops_per_s,"
+         "lat_p50_us,lat_p90_us,lat_p99_us,lat_max_us");
+
+    for (int format = TUTORIAL_VOL_DATA_FORMAT_BINARY; format <= TUTORIAL_VOL_DATA_FORMAT_TEXT; format++)
+        for (int chunked = 0; chunked <= 1; chunked++) {
+            /* Chunks are always binary */
+            if (chunked && TUTORIAL_VOL_DATA_FORMAT_TEXT == format)
+                continue;
+
+            for (int rank = 1; rank <= 3; rank++)
+                for (int s = 0; s < opts.nsizes; s++) {
+                    struct bench_config cfg;
+                    hsize_t             side = int_root(opts.sizes[s], rank);
+
+                    if (TUTORIAL_VOL_DATA_FORMAT_TEXT == format && opts.sizes[s] > TEXT_MAX_NELMTS)
+                        continue;
+
+                    memset(&cfg, 0, sizeof(cfg));
+                    cfg.format  = format;
+                    cfg.chunked = (hbool_t)chunked;
+                    cfg.rank    = rank;
+                    cfg.nelmts  = 1;
+                    for (int i = 0; i < rank; i++) {
+                        cfg.dims[i] = side;
+                        cfg.nelmts *= side;
+                    }
+
+                    rng_state_g = opts.seed;
+                    if (bench_config(fapl_id, &cfg, &opts) < 0) {
+                        fprintf(stderr, "benchmark FAILED (format %d, chunked %d, rank %d, %llu elements)\n",
+                                format, chunked, rank, (unsigned long long)opts.sizes[s]);
+                        nerrors++;
+                    }
+                }
+        }
+
+    H5Pclose(fapl_id);
+    H5VLunregister_connector(vol_id);
+
+    exit(nerrors ? EXIT_FAILURE : EXIT_SUCCESS);
+
+} /* end main() */